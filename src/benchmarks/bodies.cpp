@@ -4,6 +4,8 @@
 
 /// This benchmark emulates the behavior of the _tuple of vectors of tuples_ storage.
 /// This is achieved by using a _tuple of vectors_ storage but manually storing tuples inside.
+/// With OPTIMIZE_INFERRED, components are passed separately and grouping is left to the storage
+/// (e.g., the _tuple of vectors of tuples_ storage groups transforms and rigid bodies like OPTIMIZE_RIGID).
 
 struct Transform {
   float position[WIDTH];
@@ -26,6 +28,13 @@ public:
       std::get<Transform>(tuple).position[i] += std::get<RigidBody>(tuple).mass[i];
     #endif
   }
+  #elif defined OPTIMIZE_INFERRED
+  void operator()(Transform& transform, const RigidBody& rigid_body) const {
+    #ifndef SKIP_RIGID
+    for (auto i{0}; i < WIDTH; ++i)
+      transform.position[i] += rigid_body.mass[i];
+    #endif
+  }
   #elif defined OPTIMIZE_SOFT
   void operator()(std::tuple<Transform, SoftBody>& tuple, const RigidBody& rigid_body) const {
     #ifndef SKIP_RIGID
@@ -54,6 +63,13 @@ public:
       std::get<Transform>(tuple).position[i] += soft_body.stiffness[i];
     #endif
   }
+  #elif defined OPTIMIZE_INFERRED
+  void operator()(Transform& transform, const RigidBody&, const SoftBody& soft_body) const {
+    #ifndef SKIP_SOFT
+    for (auto i{0}; i < WIDTH; ++i)
+      transform.position[i] += soft_body.stiffness[i];
+    #endif
+  }
   #else
   static_assert(false, "No system optimization chosen.");
   #endif
@@ -71,6 +87,10 @@ int main(int argc, const char** argv) {
   benchmark::Scene scene(SoftBodySystem{}, RigidBodySystem{});
   for (auto i{0u}; i < count; ++i)
     scene->manager.new_entity(std::make_tuple(Transform{}, SoftBody{}), RigidBody{});
+  #elif defined OPTIMIZE_INFERRED
+  benchmark::Scene scene(RigidBodySystem{}, SoftBodySystem{});
+  for (auto i{0u}; i < count; ++i)
+    scene->manager.new_entity(Transform{}, RigidBody{}, SoftBody{});
   #endif
 
   scene.run();
@@ -0,0 +1,62 @@
+from s2bench.cpp2bench import Benchmark, Run, Step, Plot, PlotRun
+
+runs = [
+  Run(
+    name='tovft',
+    compile_params='-DBENCHMARK_FRAMETIME -DSTORAGE_TOV',
+    instrument='frameavg',
+    repetitions=24,
+  ),
+  Run(
+    name='tovfreeft',
+    compile_params='-DBENCHMARK_FRAMETIME -DSTORAGE_TOV -DSTORAGE_FREE_LIST',
+    instrument='frameavg',
+    repetitions=24,
+  ),
+  Run(
+    name='tovstableft',
+    compile_params='-DBENCHMARK_FRAMETIME -DSTORAGE_TOV -DSTORAGE_STABLE_COMPACTION',
+    instrument='frameavg',
+    repetitions=24,
+  ),
+  Run(
+    name='votft',
+    compile_params='-DBENCHMARK_FRAMETIME -DSTORAGE_VOT',
+    instrument='frameavg',
+    repetitions=24,
+  ),
+  Run(
+    name='votfreeft',
+    compile_params='-DBENCHMARK_FRAMETIME -DSTORAGE_VOT -DSTORAGE_FREE_LIST',
+    instrument='frameavg',
+    repetitions=24,
+  ),
+  Run(
+    name='votstableft',
+    compile_params='-DBENCHMARK_FRAMETIME -DSTORAGE_VOT -DSTORAGE_STABLE_COMPACTION',
+    instrument='frameavg',
+    repetitions=24,
+  ),
+]
+
+benchmark = Benchmark(
+  dir='churn/',
+  title='',
+  xlabel='frame',
+  ylabel='frame time',
+  axis_params='change y base, y SI prefix=milli, y unit=s,ymin=0,xmin=0,xmax=2499',
+  main='../spawn.cpp',
+  frames=2500,
+  compile_params='-DSCHEDULER_SEQUENTIAL -DINITIAL_COUNT=0 -DSPAWN_RATE=256 -DLIFETIME=500',
+  runs=runs,
+  plots=[
+    Plot('tovft', title='tuple of vectors', tex_params='"thick,orange,const plot"', plotruns=[PlotRun(runs[0])]),
+    Plot('tovfreeft', title='tuple of vectors (free list)', tex_params='"thick,orange,dashed,const plot"', plotruns=[PlotRun(runs[1])]),
+    Plot('tovstableft', title='tuple of vectors (stable)', tex_params='"thick,orange,dotted,const plot"', plotruns=[PlotRun(runs[2])]),
+    Plot('votft', title='vector of tuples', tex_params='"thick,green!75!black,const plot"', plotruns=[PlotRun(runs[3])]),
+    Plot('votfreeft', title='vector of tuples (free list)', tex_params='"thick,green!75!black,dashed,const plot"', plotruns=[PlotRun(runs[4])]),
+    Plot('votstableft', title='vector of tuples (stable)', tex_params='"thick,green!75!black,dotted,const plot"', plotruns=[PlotRun(runs[5])]),
+  ]
+)
+
+benchmark.generate()
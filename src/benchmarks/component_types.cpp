@@ -11,6 +11,15 @@ struct Payload {
   std::array<size_t, size> data;
 };
 
+#ifdef SPARSE
+// Store all but the first payload type (which every entity has) in sparse sets.
+template<size_t size, size_t index>
+requires (index > 0)
+struct scanta::component_traits<Payload<size, index>> {
+  static constexpr auto layout = scanta::Layout::sparse;
+};
+#endif
+
 template<typename TPayload>
 class ScreenSystem {
 public:
@@ -10,6 +10,9 @@ runs = [
 
   Run(name='scattered_set_seq_ft', compile_params='-DBENCHMARK_FRAMETIME -DSCHEDULER_SEQUENTIAL -DSTORAGE_SCATTERED -DSTORAGE_SCATTERED_SET', steps=[Step(avg=True)]),
   Run(name='scattered_set_par_ft', compile_params='-DBENCHMARK_FRAMETIME -DSCHEDULER_PARALLEL -DSTORAGE_SCATTERED -DSTORAGE_SCATTERED_SET', steps=[Step(avg=True)]),
+  Run(name='tov_sorted_seq_ft', compile_params='-DBENCHMARK_FRAMETIME -DSCHEDULER_SEQUENTIAL -DSTORAGE_TOV -DSORT_INTERVAL=60', steps=[Step(avg=True)]),
+  Run(name='vot_sorted_seq_ft', compile_params='-DBENCHMARK_FRAMETIME -DSCHEDULER_SEQUENTIAL -DSTORAGE_VOT -DSORT_INTERVAL=60', steps=[Step(avg=True)]),
+  Run(name='tov_double_buffered_par_ft', compile_params='-DBENCHMARK_FRAMETIME -DSCHEDULER_PARALLEL -DSTORAGE_TOV -DDOUBLE_BUFFER', steps=[Step(avg=True)]),
 ]
   
 benchmark = Benchmark(
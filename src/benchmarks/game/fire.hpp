@@ -25,12 +25,16 @@ public:
 
 class FireDamageSystem {
 public:
-  auto operator()(ECS::Entity entity, const Flammable& flammable, Mortal& mortal, float delta_time) {
-    return [&, entity, delta_time](const auto& manager) {
-      if (flammable.on_fire) {
-        mortal.hp -= delta_time;
-        if (mortal.hp <= 0) manager.remove_entity(entity);
-      }
+  void operator()(const Flammable& flammable, Mortal& mortal, float delta_time) {
+    if (flammable.on_fire) mortal.hp -= delta_time;
+  }
+};
+
+class DeathSystem {
+public:
+  auto operator()() const {
+    return [](const auto& manager) {
+      manager.template remove_entities_if_parallel<Mortal>([](const Mortal& mortal) { return mortal.hp <= 0; });
     };
   }
 };
@@ -30,6 +30,10 @@ public:
       CombustionSystem{},
       WaterSystem{},
       FireDamageSystem{},
+      DeathSystem{},
+    #ifdef SORT_INTERVAL
+      SpatialSortSystem(SORT_INTERVAL),
+    #endif
       CollisionSystem{},
       ColliderCleanupSystem{},
       RectangleRenderSystem(_renderer),
@@ -142,6 +146,10 @@ private:
     CombustionSystem,
     WaterSystem,
     FireDamageSystem,
+    DeathSystem,
+  #ifdef SORT_INTERVAL
+    SpatialSortSystem,
+  #endif
     CollisionSystem,
     ColliderCleanupSystem,
     RectangleRenderSystem,
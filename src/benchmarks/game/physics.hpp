@@ -1,5 +1,6 @@
 #pragma once
 
+#include <cstdint>
 #include <vector>
 #include <unordered_set>
 #include <glm/glm.hpp>
@@ -9,6 +10,14 @@ struct Transform {
   glm::vec2 pos{0, 0};
 };
 
+#ifdef DOUBLE_BUFFER
+// Let collision and rendering read last frame's transforms, so they need not wait for movement.
+template<>
+struct scanta::component_traits<Transform> {
+  static constexpr bool double_buffered = true;
+};
+#endif
+
 struct RigidBody {
   glm::vec2 velocity{0, 0};
 };
@@ -120,3 +129,32 @@ public:
     collider.collisions.clear();
   }
 };
+
+// Reorders entities along a Z-order curve over their positions every few frames,
+// so that systems touching spatially nearby entities together access memory in order.
+class SpatialSortSystem {
+public:
+  SpatialSortSystem(size_t interval) : _interval(interval) {}
+
+  auto operator()() {
+    const bool sort = _frame++ % _interval == 0;
+    return [sort](const auto& manager) {
+      if (sort) manager.template sort_entities<Transform>([](const Transform& transform) { return morton(transform.pos); });
+    };
+  }
+private:
+  // Interleaves the bits of the (clamped) integer coordinates.
+  static uint32_t morton(glm::vec2 pos) {
+    auto spread = [](uint32_t value) {
+      value &= 0xffff;
+      value = (value | (value << 8)) & 0x00ff00ff;
+      value = (value | (value << 4)) & 0x0f0f0f0f;
+      value = (value | (value << 2)) & 0x33333333;
+      return (value | (value << 1)) & 0x55555555;
+    };
+    return spread(uint32_t(glm::clamp(pos.x, 0.f, 65535.f))) | (spread(uint32_t(glm::clamp(pos.y, 0.f, 65535.f))) << 1);
+  }
+
+  size_t _interval;
+  size_t _frame = 0;
+};
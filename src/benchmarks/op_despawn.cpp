@@ -12,6 +12,12 @@ using Storage = scanta::storage::ScatteredCustom
   #ifdef STORAGE_SCATTERED_SET
     ::WithEntitySet
   #endif
+  #ifdef STORAGE_SCATTERED_POOLS
+    ::WithPools
+  #endif
+  #ifdef STORAGE_SCATTERED_CONTIGUOUS
+    ::WithContiguousMetadata
+  #endif
   ::Storage<size_t>;
 
 int main() {
@@ -22,7 +28,7 @@ int main() {
   size_t de_index = 0;
   while (de_index < ENTITY_COUNT) {
     size_t index = 0;
-    Storage::Entity entity{nullptr};
+    Storage::Entity entity{};
     storage.for_entities_with<size_t>([&](Storage::Entity e) {
       if (index++ == de_index)
         entity = e;
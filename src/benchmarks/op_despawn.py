@@ -13,6 +13,12 @@ runs = [
     instrument='frameavg',
     repetitions=16,
   ),
+  Run(
+    name='contft',
+    compile_params='-DSTORAGE_SCATTERED_CONTIGUOUS',
+    instrument='frameavg',
+    repetitions=16,
+  ),
 ]
 
 benchmark = Benchmark(
@@ -29,6 +35,7 @@ benchmark = Benchmark(
   plots=[
     Plot('vecft', title='vector', tex_params='"thick,green!75!black" "x*3333"', plotruns=[PlotRun(runs[0])]),
     Plot('setft', title='set', tex_params='"thick,violet" "x*3333"', plotruns=[PlotRun(runs[1])]),
+    Plot('contft', title='contiguous', tex_params='"thick,orange" "x*3333"', plotruns=[PlotRun(runs[2])]),
   ]
 )
 
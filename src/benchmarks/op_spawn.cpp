@@ -12,6 +12,12 @@ using Storage = scanta::storage::ScatteredCustom
   #ifdef STORAGE_SCATTERED_SET
     ::WithEntitySet
   #endif
+  #ifdef STORAGE_SCATTERED_POOLS
+    ::WithPools
+  #endif
+  #ifdef STORAGE_SCATTERED_CONTIGUOUS
+    ::WithContiguousMetadata
+  #endif
   ::Storage<size_t>;
 
 constexpr size_t iterations = ENTITY_COUNT / SPAWN_RATE;
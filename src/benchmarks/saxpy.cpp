@@ -1,6 +1,7 @@
 #include <cstring>
 #include <thread>
 #include <chrono>
+#include <span>
 
 #include "util/benchmark.hpp"
 
@@ -12,10 +13,44 @@ struct Y {
   float value[WIDTH];
 };
 
+#ifdef AOSOA
+// Store both components in AoSoA blocks, so the system processes a block of entities at once.
+template<>
+struct scanta::component_traits<X> {
+  using aosoa_scalar = float;
+};
+
+template<>
+struct scanta::component_traits<Y> {
+  using aosoa_scalar = float;
+};
+#endif
+
 class SaxpySystem {
 public:
   SaxpySystem(float a) : a(a) {}
 
+#ifdef AOSOA
+  void operator()(const scanta::Block<X>& x, scanta::Block<Y>& y)
+  #ifdef INNER_PARALLELISM
+    const
+  #endif
+  {
+    for (auto i{0u}; i < WIDTH; ++i)
+      for (auto lane{0u}; lane < scanta::block_lanes; ++lane)
+        y[i][lane] = a * x[i][lane] + y[i][lane];
+  }
+#elif defined(SPAN)
+  void operator()(std::span<const X> x, std::span<Y> y)
+  #ifdef INNER_PARALLELISM
+    const
+  #endif
+  {
+    for (auto entity{0u}; entity < x.size(); ++entity)
+      for (auto i{0u}; i < WIDTH; ++i)
+        y[entity].value[i] = a * x[entity].value[i] + y[entity].value[i];
+  }
+#else
   void operator()(const X& x, Y& y)
   #ifdef INNER_PARALLELISM
     const
@@ -24,6 +59,7 @@ public:
     for (auto i{0u}; i < WIDTH; ++i)
       y.value[i] = a * x.value[i] + y.value[i];
   }
+#endif
 
 private:
   float a;
@@ -34,8 +70,12 @@ int main(int argc, const char** argv) {
   unsigned int count = atoi(argv[1]);
 
   benchmark::Scene scene(SaxpySystem(9.81f));
+#ifdef BULK
+  scene->manager.new_entities(count, [](size_t) { return std::tuple{X{3.1416f}, Y{1.68f}}; });
+#else
   for (auto i{0u}; i < count; ++i)
     scene->manager.new_entity(X{3.1416f}, Y{1.68f});
+#endif
 
   std::this_thread::sleep_for(std::chrono::milliseconds(3000));
 
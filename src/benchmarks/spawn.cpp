@@ -6,17 +6,71 @@ struct Payload {
   size_t value[256];
 };
 
+#ifdef BOXED
+// Allocate payloads individually, so that shuffling only moves pointers.
+template<>
+struct scanta::component_traits<Payload> {
+  static constexpr auto layout = scanta::Layout::boxed;
+};
+#endif
+
 class PayloadSystem {
 public:
   void operator()(const Payload&) const {}
 };
 
+#ifdef LIFETIME
+/// The number of frames an entity has existed for.
+struct Age {
+  size_t frames = 0;
+};
+
+class AgingSystem {
+public:
+  void operator()(Age& age) const {
+    ++age.frames;
+  }
+};
+
+// Despawn entities after LIFETIME frames, so that the entity count reaches a steady state.
+class DespawnSystem {
+public:
+  auto operator()() {
+    return [](const auto& manager) {
+      manager.template remove_entities_if<Age>([](const Age& age) { return age.frames >= LIFETIME; });
+    };
+  }
+};
+
+#define SPAWNED Payload{}, Age{}
+#else
+#define SPAWNED Payload{}
+#endif
+
+#ifdef SNAPSHOT_INTERVAL
+// Checkpoint the scene every SNAPSHOT_INTERVAL frames, so that frame times include capturing snapshots.
+class SnapshotSystem {
+public:
+  auto operator()() {
+    return [frame = _frame++](const auto& manager) {
+      if (frame % SNAPSHOT_INTERVAL == 0) manager.save_snapshot("spawn.snapshot");
+    };
+  }
+private:
+  size_t _frame = 0;
+};
+#endif
+
 class SpawnSystem {
 public:
   auto operator()() {
     return [](const auto& manager) {
+    #ifdef BULK
+      manager.new_entities(SPAWN_RATE, [](size_t) { return std::tuple{SPAWNED}; });
+    #else
       for (auto i{0u}; i < SPAWN_RATE; ++i)
-        manager.new_entity(Payload{});
+        manager.new_entity(SPAWNED);
+    #endif
     };
   }
 };
@@ -24,10 +78,26 @@ public:
 int main(int argc, const char** argv) {
   benchmark::Scene scene(
     PayloadSystem{},
+  #ifdef LIFETIME
+    AgingSystem{},
+    DespawnSystem{},
+  #endif
+  #ifdef SNAPSHOT_INTERVAL
+    SnapshotSystem{},
+  #endif
     SpawnSystem{}
   );
+#ifdef MAPPED_DIRECTORY
+  // Resume the world saved by a previous run, if any.
+  scene->manager.map_files(MAPPED_DIRECTORY);
+  if (scene->manager.get_entity_count() == 0)
+#endif
+#ifdef BULK
+  scene->manager.new_entities(INITIAL_COUNT, [](size_t) { return std::tuple{SPAWNED}; });
+#else
   for (auto i{0u}; i < INITIAL_COUNT; ++i)
-    scene->manager.new_entity(Payload{});
+    scene->manager.new_entity(SPAWNED);
+#endif
   scene.run();
   return 0;
 }
@@ -19,10 +19,41 @@
 static_assert("No scheduler option set.");
 #endif
 
+#include "scanta/util/allocator.hpp"
+/// The allocator storages allocate their vectors with (ignored by the entt storage).
+#if defined ALLOCATOR_ALIGNED
+template<typename T>
+using BenchmarkAllocator = scanta::AlignedAllocator<T>;
+#elif defined ALLOCATOR_HUGE_PAGES
+template<typename T>
+using BenchmarkAllocator = scanta::HugePageAllocator<T>;
+#else
+template<typename T>
+using BenchmarkAllocator = std::allocator<T>;
+#endif
+
 #if defined STORAGE_TOV
 #include "scanta/storage/tuple_of_vectors.hpp"
 using ECS = scanta::EntityComponentSystem<
-  scanta::storage::TupleOfVectors,
+  #if defined STORAGE_FREE_LIST
+  scanta::storage::TupleOfVectorsCustom::WithAllocator<BenchmarkAllocator>::WithFreeList::Storage,
+  #elif defined STORAGE_STABLE_COMPACTION
+  scanta::storage::TupleOfVectorsCustom::WithAllocator<BenchmarkAllocator>::WithStableCompaction::Storage,
+  #elif defined STORAGE_MAPPED
+  scanta::storage::TupleOfVectorsCustom::WithAllocator<BenchmarkAllocator>::WithMappedColumns::Storage,
+  #else
+  scanta::storage::TupleOfVectorsCustom::WithAllocator<BenchmarkAllocator>::Storage,
+  #endif
+  #if defined SCHEDULER_SEQUENTIAL
+  scanta::scheduler::Sequential
+  #elif defined SCHEDULER_PARALLEL
+  scanta::scheduler::Parallel
+  #endif
+>;
+#elif defined STORAGE_TOVT
+#include "scanta/storage/tuple_of_vectors_of_tuples.hpp"
+using ECS = scanta::EntityComponentSystem<
+  scanta::storage::TupleOfVectorsOfTuplesCustom<>::WithAllocator<BenchmarkAllocator>::InferredStorage,
   #if defined SCHEDULER_SEQUENTIAL
   scanta::scheduler::Sequential
   #elif defined SCHEDULER_PARALLEL
@@ -32,7 +63,33 @@ using ECS = scanta::EntityComponentSystem<
 #elif defined STORAGE_VOT
 #include "scanta/storage/vector_of_tuples.hpp"
 using ECS = scanta::EntityComponentSystem<
-  scanta::storage::VectorOfTuples,
+  #if defined STORAGE_FREE_LIST
+  scanta::storage::VectorOfTuplesCustom::WithAllocator<BenchmarkAllocator>::WithFreeList::Storage,
+  #elif defined STORAGE_STABLE_COMPACTION
+  scanta::storage::VectorOfTuplesCustom::WithAllocator<BenchmarkAllocator>::WithStableCompaction::Storage,
+  #else
+  scanta::storage::VectorOfTuplesCustom::WithAllocator<BenchmarkAllocator>::Storage,
+  #endif
+  #if defined SCHEDULER_SEQUENTIAL
+  scanta::scheduler::Sequential
+  #elif defined SCHEDULER_PARALLEL
+  scanta::scheduler::Parallel
+  #endif
+>;
+#elif defined STORAGE_ARCHETYPE
+#include "scanta/storage/archetype.hpp"
+using ECS = scanta::EntityComponentSystem<
+  scanta::storage::ArchetypeCustom::WithAllocator<BenchmarkAllocator>::Storage,
+  #if defined SCHEDULER_SEQUENTIAL
+  scanta::scheduler::Sequential
+  #elif defined SCHEDULER_PARALLEL
+  scanta::scheduler::Parallel
+  #endif
+>;
+#elif defined STORAGE_SPARSE_SET
+#include "scanta/storage/sparse_set.hpp"
+using ECS = scanta::EntityComponentSystem<
+  scanta::storage::SparseSetCustom::WithAllocator<BenchmarkAllocator>::Storage,
   #if defined SCHEDULER_SEQUENTIAL
   scanta::scheduler::Sequential
   #elif defined SCHEDULER_PARALLEL
@@ -42,13 +99,19 @@ using ECS = scanta::EntityComponentSystem<
 #elif defined STORAGE_SCATTERED
 #include "scanta/storage/scattered.hpp"
 using ECS = scanta::EntityComponentSystem<
-  scanta::storage::ScatteredCustom
+  scanta::storage::ScatteredCustom::WithAllocator<BenchmarkAllocator>
     #ifdef STORAGE_SCATTERED_SMART
     ::WithSmartPointers
     #endif
     #ifdef STORAGE_SCATTERED_SET
       ::WithEntitySet
     #endif
+    #ifdef STORAGE_SCATTERED_POOLS
+      ::WithPools
+    #endif
+    #ifdef STORAGE_SCATTERED_CONTIGUOUS
+      ::WithContiguousMetadata
+    #endif
     ::Storage
   ,
   #if defined SCHEDULER_SEQUENTIAL
@@ -5,3 +5,6 @@
 #include "storage/scattered.hpp"
 #include "storage/vector_of_tuples.hpp"
 #include "storage/tuple_of_vectors.hpp"
+#include "storage/tuple_of_vectors_of_tuples.hpp"
+#include "storage/archetype.hpp"
+#include "storage/sparse_set.hpp"
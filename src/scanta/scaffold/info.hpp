@@ -1,28 +1,168 @@
 #pragma once
 
+#include <span>
+#include <type_traits>
+
 #include <boost/hana.hpp>
 #include "scanta/util/callable_traits.hpp"
+#include "scanta/util/group.hpp"
+#include "scanta/util/aosoa.hpp"
+#include "scanta/util/change_filter.hpp"
+#include "scanta/util/observer.hpp"
+#include "scanta/util/query.hpp"
+#include "scanta/util/to_hana_tuple_t.hpp"
 
 namespace hana = boost::hana;
 namespace ct = boost::callable_traits;
 
 namespace scanta {
 
+/// Describes how a system parameter accesses data.
+///
+/// Plain parameters are passed by value or reference and access their decayed type.
+/// @tparam TParameter The non-decayed parameter type.
+template<typename TParameter>
+struct ParameterTraits {
+  /// The type of the data accessed (e.g., the component type).
+  using Accessed = std::decay_t<TParameter>;
+  /// Whether the parameter references shared data (instead of being a copy).
+  static constexpr bool references = std::is_reference_v<TParameter>;
+  /// Whether the parameter allows writing to the referenced data.
+  static constexpr bool writes = references && !std::is_const_v<std::remove_reference_t<TParameter>>;
+  /// Whether the parameter accesses a block of entities instead of a single one.
+  static constexpr bool blockwise = false;
+  /// Whether the parameter accesses a run of consecutive entities instead of a single one.
+  static constexpr bool spanwise = false;
+};
+
+/// Describes a system parameter accessing an AoSoA block of components.
+///
+/// The block is written to if it is referenced non-const.
+/// @tparam TParameter The non-decayed parameter type.
+template<typename TParameter>
+requires is_block<std::decay_t<TParameter>>
+struct ParameterTraits<TParameter> {
+  using Accessed = typename std::decay_t<TParameter>::Component;
+  static constexpr bool references = std::is_reference_v<TParameter>;
+  static constexpr bool writes = references && !std::is_const_v<std::remove_reference_t<TParameter>>;
+  static constexpr bool blockwise = true;
+  static constexpr bool spanwise = false;
+};
+
+/// Whether a type is a dynamically-sized span.
+///
+/// @tparam T The type.
+template<typename T>
+constexpr bool is_span = false;
+
+template<typename T>
+constexpr bool is_span<std::span<T>> = true;
+
+/// Describes a system parameter accessing a span of components (or entity handles) of a run of consecutive entities.
+///
+/// The span always references shared data and is written to if its element type is non-const,
+/// just like a reference parameter.
+/// @tparam TParameter The non-decayed parameter type.
+template<typename TParameter>
+requires is_span<std::decay_t<TParameter>>
+struct ParameterTraits<TParameter> {
+  using Accessed = std::remove_const_t<typename std::decay_t<TParameter>::element_type>;
+  static constexpr bool references = true;
+  static constexpr bool writes = !std::is_const_v<typename std::decay_t<TParameter>::element_type>;
+  static constexpr bool blockwise = false;
+  static constexpr bool spanwise = true;
+};
+
+/// Describes a system parameter filtering entities by changes of a component type.
+///
+/// The component is accessed like the wrapped parameter type. The parameter always counts as a reference though,
+/// since the change ticks it is filtered by are shared data, which systems writing the component type update.
+/// @tparam TParameter The non-decayed parameter type.
+template<typename TParameter>
+requires is_change_filter<std::decay_t<TParameter>>
+struct ParameterTraits<TParameter> {
+  using Accessed = typename std::decay_t<TParameter>::Component;
+  static constexpr bool references = true;
+  static constexpr bool writes = ParameterTraits<typename std::decay_t<TParameter>::Parameter>::writes;
+  static constexpr bool blockwise = false;
+  static constexpr bool spanwise = false;
+};
+
+/// Describes a system parameter passing a batch of entities affected by a structural event.
+///
+/// The parameter accesses entity handles only, which are passed as a copy of the batch.
+/// @tparam TParameter The non-decayed parameter type.
+template<typename TParameter>
+requires is_observation<std::decay_t<TParameter>>
+struct ParameterTraits<TParameter> {
+  using Accessed = typename std::decay_t<TParameter>::Entity;
+  static constexpr bool references = false;
+  static constexpr bool writes = false;
+  static constexpr bool blockwise = false;
+  static constexpr bool spanwise = false;
+};
+
+/// Describes a system parameter excluding entities with a component type attached.
+///
+/// The parameter carries no data, but the signatures of the component type are read to match entities.
+/// @tparam TParameter The non-decayed parameter type.
+template<typename TParameter>
+requires is_exclusion<std::decay_t<TParameter>>
+struct ParameterTraits<TParameter> {
+  using Accessed = typename std::decay_t<TParameter>::Component;
+  static constexpr bool references = false;
+  static constexpr bool writes = false;
+  static constexpr bool blockwise = false;
+  static constexpr bool spanwise = false;
+};
+
+/// Describes a system parameter passing a component which may not be attached.
+///
+/// The parameter references the component like a pointer and is written to if the wrapped type is non-const.
+/// @tparam TParameter The non-decayed parameter type.
+template<typename TParameter>
+requires is_optional<std::decay_t<TParameter>>
+struct ParameterTraits<TParameter> {
+  using Accessed = typename std::decay_t<TParameter>::Component;
+  static constexpr bool references = true;
+  static constexpr bool writes = !std::is_const_v<std::remove_pointer_t<decltype(std::declval<std::decay_t<TParameter>>().get())>>;
+  static constexpr bool blockwise = false;
+  static constexpr bool spanwise = false;
+};
+
+/// The data type accessed by a system parameter type, given as a hana::type.
+constexpr auto accessed_type = []<typename T>(T) {
+  return hana::type_c<typename ParameterTraits<typename T::type>::Accessed>;
+};
+
 template<typename TEntity, typename... TSystems>
 struct Info {
   /// The system types in decayed form (without qualifiers).
   static constexpr auto systems = hana::transform(hana::tuple_t<TSystems...>, hana::traits::decay);
 
+  /// The structural events observed by any system, as their decayed `Observed` parameter types without duplicates.
+  static constexpr auto observations = hana::to_tuple(hana::to_set(hana::filter(
+    hana::transform(hana::flatten(hana::make_tuple(to_hana_tuple_t<ct::args_t<TSystems>>...)), hana::traits::decay),
+    []<typename T>(T) { return hana::bool_c<is_observation<typename T::type>>; }
+  )));
+
   /// Set of component types used by any system in decayed form (removes cv-qualifiers and reference).
   ///
+  /// Component types accessed through wrappers (e.g., `Block`) are unwrapped,
+  /// and the component types of observed events are included.
   /// System-types and special types are discarded.
   static constexpr auto components = hana::difference(
-    hana::to_set(hana::transform(
-      hana::flatten(
-        hana::make_tuple(to_hana_tuple_t<ct::args_t<TSystems>>...)
-      ),
-      hana::traits::decay
-    )),
+    hana::union_(
+      hana::to_set(hana::transform(
+        hana::flatten(
+          hana::make_tuple(to_hana_tuple_t<ct::args_t<TSystems>>...)
+        ),
+        accessed_type
+      )),
+      hana::to_set(hana::flatten(hana::transform(observations, []<typename T>(T) {
+        return to_hana_tuple_t<typename T::type::Components>;
+      })))
+    ),
     hana::union_(
       hana::to_set(systems),
       hana::to_set(hana::tuple_t<
@@ -32,13 +172,65 @@ struct Info {
     )
   );
 
-  /// The parameter types required by a system in decayed form.
+  /// The parameter types required by a system in decayed form, with component types unwrapped.
+  template<typename TSystem>
+  static constexpr auto argtypes = hana::transform(argtypes_of<TSystem>, accessed_type);
+
+  /// Whether a system is called once per block of entities instead of once per entity.
+  ///
+  /// This is the case if it takes `Block` parameters.
+  template<typename TSystem>
+  static constexpr bool blockwise = hana::any_of(argtypes_of<TSystem>, []<typename T>(T) {
+    return hana::bool_c<ParameterTraits<typename T::type>::blockwise>;
+  });
+
+  /// Whether a system is called once per run of consecutive entities instead of once per entity.
+  ///
+  /// This is the case if it takes `std::span` parameters.
+  template<typename TSystem>
+  static constexpr bool spanwise = hana::any_of(argtypes_of<TSystem>, []<typename T>(T) {
+    return hana::bool_c<ParameterTraits<typename T::type>::spanwise>;
+  });
+
+  /// Whether a system is only called for entities whose components changed since it last ran.
+  ///
+  /// This is the case if it takes `Added` or `Changed` parameters.
   template<typename TSystem>
-  static constexpr auto argtypes = hana::transform(argtypes_of<TSystem>, hana::traits::decay);
+  static constexpr bool filtered = hana::any_of(argtypes_of<TSystem>, []<typename T>(T) {
+    return hana::bool_c<is_change_filter<std::decay_t<typename T::type>>>;
+  });
 
-  /// The decayed system parameter types that are also stored component types.
+  /// Whether a system is an observer, which is only called with the batches of entities affected by a structural event.
+  ///
+  /// This is the case if it takes an `Observed` parameter (e.g., `OnCreate`).
   template<typename TSystem>
-  static constexpr auto component_argtypes = hana::intersection(hana::to_set(argtypes<TSystem>), components);
+  static constexpr bool observer = hana::any_of(argtypes_of<TSystem>, []<typename T>(T) {
+    return hana::bool_c<is_observation<std::decay_t<typename T::type>>>;
+  });
+
+  /// The decayed component types an entity is required to have attached for a system to be called, with wrappers unwrapped.
+  ///
+  /// Excluded (`Without`) and optional (`Optional`) component types do not restrict the entities and are left out.
+  template<typename TSystem>
+  static constexpr auto required_argtypes = hana::transform(hana::filter(argtypes_of<TSystem>, []<typename T>(T) {
+    return hana::bool_c<!is_exclusion<std::decay_t<typename T::type>> && !is_optional<std::decay_t<typename T::type>>>;
+  }), accessed_type);
+
+  /// The component types an entity is required to not have attached for a system to be called.
+  template<typename TSystem>
+  static constexpr auto excluded_argtypes = hana::transform(hana::filter(argtypes_of<TSystem>, []<typename T>(T) {
+    return hana::bool_c<is_exclusion<std::decay_t<typename T::type>>>;
+  }), accessed_type);
+
+  /// The component types a system accesses through `Optional` parameters, which need not be attached.
+  template<typename TSystem>
+  static constexpr auto optional_argtypes = hana::transform(hana::filter(argtypes_of<TSystem>, []<typename T>(T) {
+    return hana::bool_c<is_optional<std::decay_t<typename T::type>>>;
+  }), accessed_type);
+
+  /// The decayed system parameter types that are also stored component types and required to be attached.
+  template<typename TSystem>
+  static constexpr auto component_argtypes = hana::intersection(hana::to_set(required_argtypes<TSystem>), components);
 
   /// The non-decayed system parameter types that are also system types.
   template<typename TSystem>
@@ -46,6 +238,27 @@ struct Info {
     return hana::find(systems, hana::traits::decay(argtype)) != hana::nothing;
   });
 
+  /// The stored component types arranged into columns, grouping component types which are always accessed together.
+  ///
+  /// Component types required by exactly the same set of systems form one `Group`.
+  /// A component type whose set of systems is unique stays on its own.
+  static constexpr auto component_groups = []() consteval {
+    constexpr auto types = hana::to_tuple(components);
+    // The systems requiring a component type, as a tuple of boolean constants (one per system).
+    auto users = [](auto component) {
+      return hana::transform(hana::tuple_t<TSystems...>, [&](auto system) {
+        return hana::contains(component_argtypes<typename decltype(system)::type>, component);
+      });
+    };
+    // The component types required by the same systems as a component type.
+    auto peers = [&](auto component) {
+      return hana::filter(types, [&](auto other) { return users(other) == users(component); });
+    };
+    // Represent each group by its first member.
+    auto firsts = hana::filter(types, [&](auto component) { return hana::front(peers(component)) == component; });
+    return arrange_columns(hana::transform(firsts, peers), types);
+  }();
+
   /// Whether a system allows for inner parallelism or not.
   ///
   /// A system is considered parallelizable if it does not alter state of itself or any other system.
@@ -1,5 +1,13 @@
 #pragma once
 
+#include <array>
+#include <filesystem>
+#include <span>
+#include <tuple>
+#include <unordered_set>
+#include <utility>
+#include <vector>
+
 #include "info.hpp"
 #include "storage.hpp"
 
@@ -13,8 +21,381 @@ public:
 protected:
   using Info = scanta::Info<Entity, TSystems...>;
 
+  /// The types passed to the storage as template parameters.
+  ///
+  /// These are the associated component types, or, if the storage asks for it, their grouping by the systems using them.
+  static constexpr auto stored_types = []() {
+    if constexpr (requires { TStorage<>::infer_groups; }) return Info::component_groups;
+    else return Info::components;
+  }();
+
   // The type of Storage used, determined by applying the associated component types as TStorage<...> template-parameters.
-  using Storage = typename decltype(hana::unpack(Info::components, hana::template_<TStorage>))::type;
+  using Storage = typename decltype(hana::unpack(stored_types, hana::template_<TStorage>))::type;
+
+  /// Field for accessing whether the storage keeps a copy of the previous frame's components of a type.
+  ///
+  /// Systems reading such a (double-buffered) component type get the previous frame's copy,
+  /// so they need not wait for the systems writing it. Storages not supporting it keep no copies.
+  /// @tparam TComponent The component type to be checked.
+  template<typename TComponent>
+  static constexpr bool double_buffered = []() {
+    if constexpr (requires { Storage::template double_buffered<TComponent>; }) return bool(Storage::template double_buffered<TComponent>);
+    else return false;
+  }();
+
+  /// Field for accessing whether a system parameter is passed the previous frame's copy of a double-buffered component type.
+  ///
+  /// This is the case for parameters reading such a type, unless they filter entities by its changes,
+  /// which are only consistent with the current components.
+  /// @tparam TParameter The non-decayed parameter type.
+  template<typename TParameter>
+  static constexpr bool reads_previous = !ParameterTraits<TParameter>::writes && !is_change_filter<std::decay_t<TParameter>>
+    && double_buffered<typename ParameterTraits<TParameter>::Accessed>;
+
+  /// Whether the storage matches entities against excluded component types itself (see `Without`).
+  ///
+  /// Storages doing so take the excluded component types wrapped into `Without` along with the required ones.
+  /// For all other storages, the entities matching the required component types are tested one by one.
+  static constexpr bool matches_exclusions = requires { Storage::matches_exclusions; };
+
+  /// The component types a system's entities are matched against by the storage, as a `boost::hana::tuple_t`.
+  ///
+  /// These are the required component types, followed by the excluded ones wrapped into `Without` if the storage matches them.
+  /// @tparam TSystem The system type.
+  template<typename TSystem>
+  static constexpr auto query_argtypes = []() {
+    // Systems without required component types are called once instead of per entity, which has nothing to exclude or optionally access.
+    static_assert((hana::is_empty(Info::template excluded_argtypes<TSystem>) && hana::is_empty(Info::template optional_argtypes<TSystem>))
+      || hana::length(Info::template component_argtypes<TSystem>) != hana::size_c<0>, "Systems excluding or optionally accessing component types have to require at least one component type.");
+    if constexpr (matches_exclusions)
+      return hana::concat(hana::to_tuple(Info::template component_argtypes<TSystem>), hana::transform(Info::template excluded_argtypes<TSystem>, hana::template_<Without>));
+    else return hana::to_tuple(Info::template component_argtypes<TSystem>);
+  }();
+
+  /// Whether an entity has any of the component types attached which a system excludes.
+  ///
+  /// Used for storages not matching exclusions themselves.
+  /// @param storage The storage of the entity.
+  /// @param entity The entity to be tested.
+  /// @tparam TSystem The system type.
+  template<typename TSystem>
+  static bool excluded(const auto& storage, Entity entity) {
+    return hana::unpack(Info::template excluded_argtypes<TSystem>, [&](auto... components) {
+      return (storage.template has_component<typename decltype(components)::type>(entity) || ...);
+    });
+  }
+
+  /// Whether two systems are never called for the same entity, since one excludes a component type the other requires.
+  ///
+  /// Systems taking blocks are called for whole blocks, including lanes they do not apply to, so they are never disjoint.
+  /// @tparam TFirst The first system type.
+  /// @tparam TSecond The second system type.
+  template<typename TFirst, typename TSecond>
+  static constexpr bool disjoint = !Info::template blockwise<TFirst> && !Info::template blockwise<TSecond> && (
+    hana::length(hana::intersection(hana::to_set(Info::template excluded_argtypes<TFirst>), Info::template component_argtypes<TSecond>)) != hana::size_c<0>
+    || hana::length(hana::intersection(hana::to_set(Info::template excluded_argtypes<TSecond>), Info::template component_argtypes<TFirst>)) != hana::size_c<0>
+  );
+
+  /// The index of a system in the order of registration.
+  ///
+  /// @tparam TSystem The system type.
+  template<typename TSystem>
+  static constexpr size_t system_index = std::decay_t<decltype(hana::index_if(Info::systems, hana::equal.to(hana::type_c<std::decay_t<TSystem>>)).value())>::value;
+
+  /// Returns the change tick of a system run, ordering the changes it makes (see `ChangeFilter`).
+  ///
+  /// Ticks increase with the frame and the index of the system within it. Since a system only waits for systems registered
+  /// before it, a system sees the changes made since its last run as those with ticks between the ticks of its last and current run.
+  /// @param frame The number of the frame, counting from 1.
+  /// @param index The index of the system, or the number of systems for the structural changes at the end of the frame.
+  static constexpr uint64_t change_tick(uint64_t frame, size_t index) {
+    return frame * (sizeof...(TSystems) + 1) + index;
+  }
+
+  /// Lets the storage track the changes of all component types which systems filter entities by.
+  ///
+  /// Structural changes made before the first frame are stamped with the tick of the end of frame 0,
+  /// so that all systems see the entities created by then as added.
+  /// @param storage The storage to be set up.
+  static void track_changes(auto& storage) {
+    hana::for_each(hana::tuple_t<TSystems...>, [&](auto system) {
+      hana::for_each(argtypes_of<typename decltype(system)::type>, [&](auto parameter) {
+        using Parameter = std::decay_t<typename decltype(parameter)::type>;
+        if constexpr (is_change_filter<Parameter>) {
+          static_assert(requires { storage.template track_changes<typename Parameter::Component>(); }, "Systems taking change filters require a storage tracking changes.");
+          storage.template track_changes<typename Parameter::Component>();
+        }
+      });
+    });
+    if constexpr (requires { storage.set_change_tick(uint64_t{}); })
+      storage.set_change_tick(change_tick(0, sizeof...(TSystems)));
+  }
+
+  /// Whether an entity passes the change filters of a system, i.e., its filtered components changed after some tick.
+  ///
+  /// @param storage The storage of the entity.
+  /// @param entity The entity to be tested.
+  /// @param since The tick of the last run of the system.
+  /// @tparam TSystem The system type.
+  template<typename TSystem>
+  static bool passes_filters(const auto& storage, Entity entity, uint64_t since) {
+    return hana::unpack(argtypes_of<TSystem>, [&](auto... parameters) {
+      return ([&]() {
+        using Parameter = std::decay_t<typename decltype(parameters)::type>;
+        if constexpr (!is_change_filter<Parameter>) return true;
+        else if constexpr (Parameter::filter == Change::added) return storage.template added_since<typename Parameter::Component>(entity, since);
+        else return storage.template changed_since<typename Parameter::Component>(entity, since);
+      }() && ...);
+    });
+  }
+
+  /// Marks the component types a system accesses mutably as changed for all entities the system applies to,
+  /// if the storage supports tracking changes.
+  ///
+  /// Systems not filtering entities by changes mark all entities with their required components attached at once after running.
+  /// Optional components are only marked for the entities they are attached to.
+  /// @param storage The storage accessed by the system.
+  /// @param tick The tick of the system run.
+  /// @tparam TSystem The system type.
+  template<typename TSystem>
+  static void mark_changes(auto& storage, uint64_t tick) {
+    hana::for_each(argtypes_of<TSystem>, [&](auto parameter) {
+      using Parameter = ParameterTraits<typename decltype(parameter)::type>;
+      using Component = typename Parameter::Accessed;
+      if constexpr (Parameter::writes && hana::contains(Info::components, hana::type_c<Component>)) {
+        // Optional components are additionally required, so that only the entities they are attached to are marked.
+        constexpr auto marked = []() {
+          if constexpr (is_optional<std::decay_t<typename decltype(parameter)::type>>) return hana::append(query_argtypes<TSystem>, hana::type_c<Component>);
+          else return query_argtypes<TSystem>;
+        }();
+        hana::unpack(marked, [&](auto... required) {
+          if constexpr (requires { storage.template mark_changed<Component, typename decltype(required)::type...>(tick); })
+            storage.template mark_changed<Component, typename decltype(required)::type...>(tick);
+        });
+      }
+    });
+  }
+
+  /// Marks the component types a system accesses mutably as changed for a single entity, if the storage supports tracking changes.
+  ///
+  /// Systems filtering entities by changes mark the entities they are called for one by one.
+  /// @param storage The storage accessed by the system.
+  /// @param tick The tick of the system run.
+  /// @param entity The entity the system has been called for.
+  /// @tparam TSystem The system type.
+  template<typename TSystem>
+  static void mark_changes(auto& storage, uint64_t tick, Entity entity) {
+    hana::for_each(argtypes_of<TSystem>, [&](auto parameter) {
+      using Parameter = ParameterTraits<typename decltype(parameter)::type>;
+      using Component = typename Parameter::Accessed;
+      if constexpr (Parameter::writes && hana::contains(Info::components, hana::type_c<Component>)) {
+        if constexpr (requires { storage.template mark_changed<Component>(entity, tick); }) {
+          // Optional components are only marked if attached.
+          if constexpr (is_optional<std::decay_t<typename decltype(parameter)::type>>)
+            if (!storage.template has_component<Component>(entity)) return;
+          storage.template mark_changed<Component>(entity, tick);
+        }
+      }
+    });
+  }
+
+  /// Calls a system taking blocks, restoring the lanes of written blocks which the system does not apply to.
+  ///
+  /// Systems taking blocks process all lanes of a block, including those of entities which do not match
+  /// the system's required components (or of unused slots). Those lanes are copied before the call and restored after it.
+  /// @param args The filled-in arguments of the system call.
+  /// @param lanes A bit mask with bit `i` set if the `i`-th lane belongs to a matching entity.
+  /// @param call The system call.
+  /// @tparam TSystem The system type called.
+  template<typename TSystem>
+  static void preserve_unmatched_lanes(auto& args, uint64_t lanes, auto&& call) {
+    constexpr uint64_t all_lanes = block_lanes == 64 ? ~uint64_t{0} : (uint64_t{1} << block_lanes) - 1;
+    if (lanes == all_lanes) {
+      call();
+      return;
+    }
+    // The indices of the written block parameters.
+    constexpr auto written = hana::filter(hana::to_tuple(hana::make_range(0_c, hana::length(argtypes_of<TSystem>))), [](auto index) {
+      using Parameter = ParameterTraits<typename decltype(+argtypes_of<TSystem>[index])::type>;
+      return hana::bool_c<Parameter::blockwise && Parameter::writes>;
+    });
+    auto saved = hana::transform(written, [&](auto index) { return args[index].get(); });
+    call();
+    hana::for_each(hana::make_range(0_c, hana::length(written)), [&](auto index) {
+      args[written[index]].get().restore(saved[index], ~lanes);
+    });
+  }
+
+  /// The structural events observed by systems (see `Observed`), collected over a frame.
+  ///
+  /// Deferred managers record the events of the structural changes they make, but only those some system observes.
+  class EventLog {
+  public:
+    /// The batches of entities affected by each observed event, in the order of `Info::observations`.
+    using Batches = std::array<std::vector<Entity>, hana::length(Info::observations)>;
+
+    /// Whether any system observes an event.
+    ///
+    /// @tparam event The event.
+    template<Event event>
+    static constexpr bool observes = hana::any_of(Info::observations, []<typename T>(T) {
+      return hana::bool_c<T::type::trigger == event>;
+    });
+
+    /// Whether any system observes any event.
+    static constexpr bool observing = !hana::is_empty(Info::observations);
+
+    /// Records the creation of an entity.
+    ///
+    /// @param entity The created entity.
+    /// @tparam TComponents The component types initially attached to the entity.
+    template<typename... TComponents>
+    void created(Entity entity) {
+      record<Event::created>(entity, []<typename T>(T) {
+        return hana::all_of(to_hana_tuple_t<typename T::type::Components>, [](auto component) {
+          return hana::contains(hana::tuple_t<std::decay_t<TComponents>...>, component);
+        });
+      });
+    }
+
+    /// Records the attachment of a component to an entity.
+    ///
+    /// @param entity The entity attached to.
+    /// @tparam TComponent The attached component type.
+    template<typename TComponent>
+    void attached(Entity entity) {
+      record<Event::attached>(entity, []<typename T>(T) {
+        return hana::bool_c<std::is_same_v<typename T::type::Components, std::tuple<std::decay_t<TComponent>>>>;
+      });
+    }
+
+    /// Records the detachment of a component from an entity, before it is detached.
+    ///
+    /// @param entity The entity detached from.
+    /// @param storage The storage of the entity.
+    /// @tparam TComponent The detached component type.
+    template<typename TComponent>
+    void detached(Entity entity, const Storage& storage) {
+      record<Event::detached>(entity, [&]<typename T>(T) {
+        return std::is_same_v<typename T::type::Components, std::tuple<TComponent>> && storage.template has_component<TComponent>(entity);
+      });
+    }
+
+    /// Records the removal of an entity, before it is removed.
+    ///
+    /// @param entity The removed entity.
+    /// @param storage The storage of the entity.
+    void removed(Entity entity, const Storage& storage) {
+      record<Event::removed>(entity, [&]<typename T>(T) {
+        return hana::unpack(to_hana_tuple_t<typename T::type::Components>, [&](auto... components) {
+          return (storage.template has_component<typename decltype(components)::type>(entity) && ...);
+        });
+      });
+      // Removed entities are dropped from the batches of all other events.
+      if constexpr (observes<Event::created> || observes<Event::attached> || observes<Event::detached>)
+        _removed.push_back(entity);
+    }
+
+    /// Forgets all events recorded so far, e.g., after all entities have been replaced.
+    void clear() {
+      for (auto& batch : _batches) batch.clear();
+      _removed.clear();
+    }
+
+    /// Takes the batches of the events recorded so far, clearing them for the events still to come.
+    ///
+    /// Each entity is only passed once per event, and only if it still matches the event,
+    /// i.e., it has not been removed since and still has the component types attached (or detached).
+    /// @param storage The storage of the entities.
+    /// @returns The batches, which remain valid until taken again.
+    const Batches& take(const Storage& storage) {
+      const std::unordered_set<Entity> removed(_removed.begin(), _removed.end());
+      _removed.clear();
+      hana::for_each(hana::make_range(hana::size_c<0>, hana::length(Info::observations)), [&](auto index) {
+        using Observation = typename decltype(+Info::observations[index])::type;
+        std::unordered_set<Entity> seen;
+        _taken[index].clear();
+        for (Entity entity : _batches[index]) {
+          if constexpr (Observation::trigger != Event::removed) {
+            if (removed.contains(entity)) continue;
+            const bool attached = hana::unpack(to_hana_tuple_t<typename Observation::Components>, [&](auto... components) {
+              return (storage.template has_component<typename decltype(components)::type>(entity) && ...);
+            });
+            if (attached == (Observation::trigger == Event::detached)) continue;
+          }
+          if (seen.insert(entity).second) _taken[index].push_back(entity);
+        }
+        _batches[index].clear();
+      });
+      return _taken;
+    }
+
+  private:
+    /// The entities affected by each observed event so far.
+    Batches _batches;
+
+    /// The batches taken last, kept to reuse their memory.
+    Batches _taken;
+
+    /// The entities removed so far.
+    std::vector<Entity> _removed;
+
+    /// Adds an entity to the batches of all observations of an event it matches.
+    ///
+    /// @param entity The affected entity.
+    /// @param matches The callable returning whether the entity matches an observation, given its type as a `hana::type`.
+    /// @tparam event The event.
+    template<Event event>
+    void record(Entity entity, auto&& matches) {
+      hana::for_each(hana::make_range(hana::size_c<0>, hana::length(Info::observations)), [&](auto index) {
+        constexpr auto observation = Info::observations[index];
+        if constexpr (decltype(+observation)::type::trigger == event)
+          if (matches(observation)) _batches[index].push_back(entity);
+      });
+    }
+  };
+
+  /// Calls the observers with the batches of the events recorded since they were last called.
+  ///
+  /// Observers are called in the order of registration, but only if their batch is not empty.
+  /// If an observer returns a callable, it is called with the deferred manager.
+  /// @param scheduler The scheduler storing the systems.
+  /// @param events The event log to take the batches from.
+  /// @param storage The storage of the entities.
+  /// @param manager The deferred manager.
+  /// @param delta_time The time since the last frame.
+  static void run_observers(auto& scheduler, EventLog& events, const Storage& storage, const auto& manager, double delta_time) {
+    const auto& batches = events.take(storage);
+    hana::for_each(Info::systems, [&](auto system) {
+      using System = typename decltype(system)::type;
+      if constexpr (Info::template observer<System>) {
+        static_assert(hana::count_if(argtypes_of<System>, []<typename T>(T) { return hana::bool_c<is_observation<std::decay_t<typename T::type>>>; }) == hana::size_c<1>, "Observers can only observe a single event.");
+        // The batch of the observed event.
+        std::span<const Entity> batch;
+        auto args = hana::transform(argtypes_of<System>, [&](auto parameter) {
+          using ArgType = std::decay_t<typename decltype(parameter)::type>;
+          if constexpr (is_observation<ArgType>) {
+            static_assert(std::is_same_v<typename ArgType::Entity, Entity>, "Observers have to be passed the entity handle type of the storage.");
+            batch = batches[hana::index_if(Info::observations, hana::equal.to(hana::type_c<ArgType>)).value()];
+            return ArgType(batch);
+          }
+          // Check if the argument type is a stored system type.
+          else if constexpr (hana::contains(Info::systems, hana::type_c<ArgType>))
+            return std::ref(scheduler.template get_system<ArgType>());
+          // Check if the argument type is a floating point number, representing a delta time.
+          else if constexpr (hana::contains(hana::tuple_t<double, float>, hana::type_c<ArgType>))
+            return ArgType(delta_time);
+          else static_assert(!sizeof(ArgType), "Observers can only take an event batch, systems and the delta time.");
+        });
+        if (batch.empty()) return;
+        using ReturnType = ct::return_type_t<System>;
+        if constexpr (std::is_invocable_v<ReturnType, decltype(manager)>)
+          hana::unpack(args, scheduler.template get_system<System>())(manager);
+        else
+          hana::unpack(args, scheduler.template get_system<System>());
+      }
+    });
+  }
 
   /// The runtime manager to be passed into system executions.
   ///
@@ -61,6 +442,14 @@ protected:
       return _storage.template has_component<TComponent>(entity);
     }
 
+    /// Test whether or not an entity is still stored, i.e., it has not been removed and reclaimed.
+    ///
+    /// @param entity The entity to be queried.
+    inline bool has_entity(Entity entity) const {
+      static_assert(requires { _storage.has_entity(entity); }, "The storage does not support testing whether entities are stored.");
+      return _storage.has_entity(entity);
+    }
+
 
     // Deferred functions:
 
@@ -76,6 +465,20 @@ protected:
       });
     }
 
+    /// Creates multiple new entities with the same set of component types in the scene.
+    ///
+    /// When called, the entities are not created immediately,
+    /// but merely queued as a single deferred operation.
+    ///
+    /// @param count The number of entities to be created.
+    /// @param generator The callable returning the initial components of the `i`-th new entity as a `std::tuple`, given `i`.
+    /// It is copied into the deferred operation.
+    void new_entities(size_t count, auto&& generator) const {
+      defer([count, generator](const auto& manager) {
+        manager.new_entities(count, generator);
+      });
+    }
+
     /// Removes an entity from the scene.
     ///
     /// When called, the entity is not removed immediately,
@@ -88,6 +491,65 @@ protected:
       });
     }
 
+    /// Removes all entities with all required components attached which satisfy a predicate from the scene.
+    ///
+    /// When called, the entities are not removed immediately,
+    /// but merely queued as a single deferred operation.
+    ///
+    /// @tparam TRequiredComponents The set of component types required to be attached to an entity to be tested.
+    /// @param predicate The callable returning whether to remove an entity, given const references to its required components.
+    /// It is copied into the deferred operation.
+    template<typename... TRequiredComponents>
+    void remove_entities_if(auto&& predicate) const {
+      defer([predicate](const auto& manager) {
+        manager.template remove_entities_if<TRequiredComponents...>(predicate);
+      });
+    }
+
+    /// Removes all entities with all required components attached which satisfy a predicate from the scene.
+    /// Employs inner parallelism in storages supporting it.
+    ///
+    /// When called, the entities are not removed immediately,
+    /// but merely queued as a single deferred operation.
+    ///
+    /// @tparam TRequiredComponents The set of component types required to be attached to an entity to be tested.
+    /// @param predicate The callable returning whether to remove an entity, given const references to its required components.
+    /// It is copied into the deferred operation and may be called concurrently for different entities.
+    template<typename... TRequiredComponents>
+    void remove_entities_if_parallel(auto&& predicate) const {
+      defer([predicate](const auto& manager) {
+        manager.template remove_entities_if_parallel<TRequiredComponents...>(predicate);
+      });
+    }
+
+    /// Reorders the entities by a key over one of their components, to improve the locality of iteration.
+    ///
+    /// When called, the entities are not reordered immediately,
+    /// but merely queued as a single deferred operation.
+    ///
+    /// @tparam TComponent The component type the key is computed from.
+    /// @param key The callable returning the key of an entity, given a const reference to its component.
+    /// It is copied into the deferred operation.
+    template<typename TComponent>
+    void sort_entities(auto&& key) const {
+      defer([key](const auto& manager) {
+        manager.template sort_entities<TComponent>(key);
+      });
+    }
+
+    /// Saves a snapshot of the storage to a file.
+    ///
+    /// When called, the snapshot is not captured immediately, but at the end of the frame,
+    /// once all deferred operations have been executed and the storage has been refreshed.
+    /// It is then written to the file by a background thread, so that the frame only pays for the capture.
+    /// Only storages supporting snapshots (i.e., all but `Scattered` and `Entt`) can be saved.
+    ///
+    /// @param path The path of the file.
+    void save_snapshot(const std::filesystem::path& path) const {
+      static_assert(requires { _storage.snapshot(); }, "The storage does not support snapshots of these component types.");
+      _scheduler.request_snapshot(path);
+    }
+
     /// Attaches a component to an entity.
     ///
     /// When called, the entity is not removed immediately,
@@ -138,7 +600,11 @@ protected:
     ///
     /// @param scheduler The scheduler to be managed.
     /// @param storage The storage to be managed.
-    DeferredManager(TScheduler& scheduler, Storage& storage) : RuntimeManager<TScheduler>(scheduler, storage) {}
+    /// @param events The log to record the observed structural events in.
+    DeferredManager(TScheduler& scheduler, Storage& storage, EventLog& events) :
+      RuntimeManager<TScheduler>(scheduler, storage),
+      _events(events)
+    {}
 
     // Include scheduler manager functionality.
     using RuntimeManager<TScheduler>::get_entity_count;
@@ -146,17 +612,128 @@ protected:
     /// Creates a new entity in the scene.
     ///
     /// @param components The set of components to be initially associated with the new entity.
-    inline void new_entity(auto&&... components) const {
-      _storage.new_entity(std::forward<decltype(components)>(components)...);
+    /// @returns The handle of the new entity.
+    inline Entity new_entity(auto&&... components) const {
+      Entity entity = _storage.new_entity(std::forward<decltype(components)>(components)...);
+      _events.template created<std::decay_t<decltype(components)>...>(entity);
+      return entity;
+    }
+
+    /// Creates multiple new entities with the same set of component types in the scene.
+    ///
+    /// Storages supporting it create all entities at once, otherwise (or if creations are observed) they are created one by one.
+    /// @param count The number of entities to be created.
+    /// @param generator The callable returning the initial components of the `i`-th new entity as a `std::tuple`, given `i`.
+    inline void new_entities(size_t count, auto&& generator) const {
+      if constexpr (requires { _storage.new_entities(count, generator); } && !EventLog::template observes<Event::created>)
+        _storage.new_entities(count, generator);
+      else
+        for (size_t i = 0; i < count; ++i)
+          std::apply([&](auto&&... components) { new_entity(std::move(components)...); }, generator(i));
+    }
+
+    /// Creates multiple new entities with the same set of component types in the scene.
+    /// Employs inner parallelism in storages supporting it.
+    ///
+    /// @param count The number of entities to be created.
+    /// @param generator The callable returning the initial components of the `i`-th new entity as a `std::tuple`, given `i`.
+    /// It may be called concurrently for different `i`.
+    inline void new_entities_parallel(size_t count, auto&& generator) const {
+      if constexpr (requires { _storage.new_entities_parallel(count, generator); } && !EventLog::template observes<Event::created>)
+        _storage.new_entities_parallel(count, generator);
+      else
+        new_entities(count, generator);
+    }
+
+    /// Creates multiple new entities in the scene from columns of components.
+    ///
+    /// The `i`-th new entity is associated with the `i`-th component of each column.
+    /// Storages supporting it adopt the columns (or their elements) by move, otherwise (or if creations are observed)
+    /// the entities are created one by one.
+    /// @param columns The initial components of the new entities, one equally-sized vector per component type.
+    template<typename... TComponents>
+    inline void new_entities(std::vector<TComponents>&&... columns) const {
+      if constexpr (requires { _storage.new_entities(std::move(columns)...); } && !EventLog::template observes<Event::created>)
+        _storage.new_entities(std::move(columns)...);
+      else
+        for (size_t i = 0; i < std::get<0>(std::tie(columns...)).size(); ++i)
+          new_entity(std::move(columns[i])...);
     }
 
     /// Removes an entity from the scene.
     ///
     /// @param entity The entity to be removed.
     inline void remove_entity(Entity entity) const {
+      _events.removed(entity, _storage);
       _storage.remove_entity(entity);
     }
 
+    /// Removes all entities with all required components attached which satisfy a predicate from the scene.
+    ///
+    /// Storages supporting it mark the entities as removed in place, otherwise (or if any events are observed)
+    /// the matching entities are collected first and then removed one by one.
+    /// @tparam TRequiredComponents The set of component types required to be attached to an entity to be tested.
+    /// @param predicate The callable returning whether to remove an entity, given const references to its required components.
+    template<typename... TRequiredComponents>
+    inline void remove_entities_if(auto&& predicate) const {
+      if constexpr (requires { _storage.template remove_entities_if<TRequiredComponents...>(predicate); } && !EventLog::observing)
+        _storage.template remove_entities_if<TRequiredComponents...>(predicate);
+      else {
+        std::vector<Entity> removed;
+        _storage.template for_entities_with<TRequiredComponents...>([&](Entity entity) {
+          if (predicate(_storage.template get_component<TRequiredComponents>(entity)...)) removed.push_back(entity);
+        });
+        for (Entity entity : removed) remove_entity(entity);
+      }
+    }
+
+    /// Removes all entities with all required components attached which satisfy a predicate from the scene.
+    /// Employs inner parallelism in storages supporting it.
+    ///
+    /// @tparam TRequiredComponents The set of component types required to be attached to an entity to be tested.
+    /// @param predicate The callable returning whether to remove an entity, given const references to its required components.
+    /// It may be called concurrently for different entities.
+    template<typename... TRequiredComponents>
+    inline void remove_entities_if_parallel(auto&& predicate) const {
+      if constexpr (requires { _storage.template remove_entities_if_parallel<TRequiredComponents...>(predicate); } && !EventLog::observing)
+        _storage.template remove_entities_if_parallel<TRequiredComponents...>(predicate);
+      else
+        remove_entities_if<TRequiredComponents...>(predicate);
+    }
+
+    /// Reorders the entities by a key over one of their components, to improve the locality of iteration.
+    ///
+    /// Entities without the component attached are placed behind all others. Storages without an order
+    /// to speak of ignore this.
+    /// @tparam TComponent The component type the key is computed from.
+    /// @param key The callable returning the key of an entity, given a const reference to its component.
+    template<typename TComponent>
+    inline void sort_entities(auto&& key) const {
+      if constexpr (requires { _storage.template sort_entities<TComponent>(key); })
+        _storage.template sort_entities<TComponent>(key);
+    }
+
+    /// Backs the storage by files in a directory, so that it persists across runs.
+    ///
+    /// If no entity has been added yet, a storage saved to the directory before is adopted.
+    /// Storages which can not be backed by files ignore this.
+    /// @param directory The directory to store the files in.
+    inline void map_files(const std::filesystem::path& directory) const {
+      if constexpr (requires { _storage.map_files(directory); })
+        _storage.map_files(directory);
+    }
+
+    /// Replaces all entities by the ones of a snapshot saved before.
+    ///
+    /// Only storages supporting snapshots (i.e., all but `Scattered` and `Entt`) can be restored. The structural events
+    /// recorded before are dropped, and the restored entities are not observed as created.
+    /// @param path The path of the snapshot file.
+    inline void restore_snapshot(const std::filesystem::path& path) const {
+      static_assert(requires { _storage.restore(path); }, "The storage does not support snapshots of these component types.");
+      _storage.restore(path);
+      _events.clear();
+    }
+
     /// Attaches a component to an entity.
     ///
     /// @param entity The entity to which to attach the component.
@@ -164,6 +741,7 @@ protected:
     template<typename TComponent>
     inline void attach_component(Entity entity, TComponent&& component) const {
       _storage.attach_component(entity, std::forward<TComponent>(component));
+      _events.template attached<TComponent>(entity);
     }
 
     /// Detaches a component from an entity.
@@ -171,7 +749,8 @@ protected:
     /// @tparam TComponent The type of the component to be detached.
     /// @param entity The entity to be detached from.
     template<typename TComponent>
-    inline void detach_component(Entity entity) {
+    inline void detach_component(Entity entity) const {
+      _events.template detached<TComponent>(entity, _storage);
       _storage.template detach_component<TComponent>(entity);
     }
 
@@ -180,13 +759,15 @@ protected:
     /// @param entity The entity to be accessed.
     /// @tparam TComponent The component type to be queried.
     template<typename TComponent>
-    inline TComponent& get_component(Entity entity) const {
+    inline decltype(auto) get_component(Entity entity) const {
       return _storage.template get_component<TComponent>(entity);
     }
 
   protected:
     using RuntimeManager<TScheduler>::_scheduler;
     using RuntimeManager<TScheduler>::_storage;
+    /// The log to record the observed structural events in.
+    EventLog& _events;
   };
 };
 
@@ -1,8 +1,10 @@
 #pragma once
 
+#include <array>
 #include <type_traits>
 #include <tuple>
 #include <functional>
+#include <filesystem>
 #include <mutex>
 
 #include <taskflow/taskflow.hpp>
@@ -13,6 +15,7 @@
 #include "scanta/scaffold/scheduler.hpp"
 
 #include "scanta/util/timer.hpp"
+#include "scanta/util/snapshot.hpp"
 #include "scanta/util/to_hana_tuple_t.hpp"
 
 namespace hana = boost::hana;
@@ -46,7 +49,7 @@ public:
     // Systems are passed as references and stored in a scheduler-owned tuple.
     _systems(std::make_tuple(std::forward<TSystems>(systems)...)),
     _runtime_manager(*this, _storage),
-    _deferred_manager(*this, _storage)
+    _deferred_manager(*this, _storage, _events)
   {
     // As is, lvalue-referenced systems would be copied in.
     // Copying in the systems is almost never what a user wants.
@@ -59,8 +62,14 @@ public:
     // TODO: Statically assert system invocability.
     // TODO: Statically assert that no component type is specified more than once in system parameters.
 
+    // Let the storage cache the entities matching each system's required components, if it supports doing so.
+    (cache_query(Info::template component_argtypes<TSystems>), ...);
+    // Let the storage track the changes of the component types systems filter entities by.
+    Scheduler::track_changes(_storage);
+
     // Create a task for running each system. The result of this call is an std::tuple containing the tasks.
-    auto graph = _taskflow.emplace([&]() { run_system<TSystems>(); } ...);
+    // Observers are only run on the events of the frame, so their tasks are empty.
+    auto graph = _taskflow.emplace([&]() { if constexpr (!Info::template observer<TSystems>) run_system<TSystems>(); } ...);
 
     // Iterate each system, and for each system all the systems after it by counting up from the current index to
     // the amount of systems specified exclusively (e.g. with 4 systems, 0: 1-2-3; 1: 2-3; 2: 3).
@@ -99,39 +108,43 @@ public:
           // Determine component data read/write dependencies.
           //
           // Search the argument list of the first system for types that also exist in the second system.
-          // If both of them are references and at least one of them is non-const, a dependency is found.
+          // If both of them are references and at least one of them is non-const, a dependency is found,
+          // unless only one of them is non-const and the component type is double-buffered.
+          // Parameters wrapping component types (e.g., `Block`s) are compared by the component type they access.
           // This algorithm misbehaves when a component type is specified as parameter more than once,
           // since only the first instance is respected. This is not a problem because multiple references
           // are forbidden by the constructor.
-          || hana::find_if(argtypes_of<FirstSystem>, [](auto first_arg) consteval {
+          // Systems which are never called for the same entity (see `Without`) do not conflict on component data.
+          || (!Scheduler::template disjoint<FirstSystem, SecondSystem> && hana::find_if(argtypes_of<FirstSystem>, [](auto first_arg) consteval {
             // hana requires the result to be wrapped into an integral constant.
             return hana::bool_c<[&]() consteval {
+              // Declare a type alias for cleaner usage.
+              using FirstArg = ParameterTraits<typename decltype(first_arg)::type>;
               // If the argument type is not a reference, don't check for conflicts.
-              if constexpr (!std::is_reference_v<typename decltype(first_arg)::type>) return false;
+              if constexpr (!FirstArg::references) return false;
               // Search for the type in the second system's arguments.
               auto second_arg_index = hana::index_if(
-                hana::transform(argtypes_of<SecondSystem>, hana::traits::decay),
-                [&](auto argtype) consteval { return hana::bool_c<argtype == hana::traits::decay(first_arg)>; }
+                Info::template argtypes<SecondSystem>,
+                [&](auto argtype) consteval { return hana::bool_c<argtype == hana::type_c<typename FirstArg::Accessed>>; }
               );
               if constexpr (second_arg_index != hana::nothing) {
                 // Get the full (non-decayed) argument type of the second system.
                 auto second_arg = argtypes_of<SecondSystem>[second_arg_index.value()];
-                // Declare type aliases for cleaner usage.
-                using FirstArg = typename decltype(first_arg)::type;
-                using SecondArg = typename decltype(second_arg)::type;
+                using SecondArg = ParameterTraits<typename decltype(second_arg)::type>;
                 // If the argument type is not a reference, don't check for conflicts.
-                if constexpr (std::is_reference_v<SecondArg>) {
-                  // See if at least one of the arguments is non-const.
-                  if constexpr (
-                    !std::is_const_v<std::remove_reference_t<FirstArg>>
-                    || !std::is_const_v<std::remove_reference_t<SecondArg>>
-                  ) return true;
+                if constexpr (SecondArg::references) {
+                  // See if both arguments are non-const, or one of them is and the other one does not read a previous copy.
+                  // Readers of a double-buffered component type get the previous frame's copy, so they need not wait for writers.
+                  if constexpr (FirstArg::writes && SecondArg::writes) return true;
+                  else if constexpr (FirstArg::writes || SecondArg::writes)
+                    return !Scheduler::template reads_previous<typename decltype(first_arg)::type>
+                      && !Scheduler::template reads_previous<typename decltype(second_arg)::type>;
                 }
               }
               // No argument dependency has been found.
               return false;
             }()>;
-          }) != hana::nothing
+          }) != hana::nothing)
         ) {
           auto& first_task = std::get<first_index>(graph);
           auto& second_task = std::get<second_index>(graph);
@@ -157,6 +170,16 @@ public:
     _deferred_operations.push_back(operation);
   }
 
+  /// Requests a snapshot of the storage to be captured at the end of the current frame.
+  ///
+  /// @param path The path of the file to write the snapshot to.
+  inline void request_snapshot(const std::filesystem::path& path) {
+    // Lock the requested snapshots vector to avoid concurrent writes.
+    static std::mutex mutex;
+    std::scoped_lock lock(mutex);
+    _snapshot_paths.push_back(path);
+  }
+
   /// Executes and clears all currently queued deferred operations.
   inline void dispatch_deferred_operations() {
     for (auto& operation : _deferred_operations) operation(_deferred_manager);
@@ -171,18 +194,40 @@ public:
     // TODO: Only get delta_time if required by a system.
     // Get the time since the last call.
     _delta_time = _timer.reset();
+    ++_frame;
+
+    // Storages keeping copies of the previous frame's components of double-buffered types take them now,
+    // after all structural changes of the last frame (and in between frames) have been made.
+    if constexpr (requires { _storage.update_buffers(); })
+      _storage.update_buffers();
 
     _executor.run(_taskflow).wait();
 
+    // Stamp the structural changes of the deferred operations after the changes of all systems.
+    if constexpr (requires { _storage.set_change_tick(uint64_t{}); })
+      _storage.set_change_tick(Scheduler::change_tick(_frame, sizeof...(TSystems)));
+
     // Execute all currently queued deferred operations.
     dispatch_deferred_operations();
 
+    // Pass the structural events of the frame to the observers, and execute the operations they defer.
+    if constexpr (Scheduler::EventLog::observing) {
+      Scheduler::run_observers(*this, _events, _storage, _deferred_manager, _delta_time);
+      dispatch_deferred_operations();
+    }
+
     // Certain entity-component storages need to be refreshed periodically to restore
     // certain preconditions or optimizations.
     // Check whether the used storage supports it, by seeing if the expression
     // is well-formed. If so, call it.
     if constexpr (requires { _storage.refresh(); })
       _storage.refresh();
+
+    // Capture the requested snapshots now that the storage is consistent,
+    // and leave serializing and writing them to the background writer.
+    if constexpr (requires { _storage.snapshot(); })
+      for (const auto& path : _snapshot_paths) _snapshot_writer.write(path, _storage.snapshot(_snapshot_writer.recycle()));
+    _snapshot_paths.clear();
   }
 
 private:
@@ -192,6 +237,17 @@ private:
   /// The entity & component storage.
   typename Scheduler::Storage _storage;
 
+  /// The structural events of the current frame, passed to observers after the deferred operations.
+  typename Scheduler::EventLog _events;
+
+  /// The number of the current frame, counting from 1.
+  uint64_t _frame = 0;
+
+  /// The change tick of the last run of each system (see `Scheduler::change_tick`).
+  ///
+  /// Each system only accesses its own tick, so systems may run concurrently.
+  std::array<uint64_t, sizeof...(TSystems)> _change_ticks{};
+
   /// Tuple to store references to the systems.
   ///
   /// This tuple is iterated at execution time by `boost::hana` functions.
@@ -224,6 +280,12 @@ private:
   /// Timer for measuring frame times
   timing::Timer _timer;
 
+  /// The files to write snapshots of the storage to at the end of the current frame.
+  std::vector<std::filesystem::path> _snapshot_paths;
+
+  /// The background writer of snapshots.
+  SnapshotWriter _snapshot_writer;
+
   /// Field for temporarily storing the delta_time while systems execute.
   double _delta_time;
 
@@ -246,6 +308,42 @@ private:
       else
         return storage.template for_entities_with<TRequiredComponents...>(std::forward<decltype(callable)>(callable));
     }
+
+    /// Executes a block iteration with a callable on some storage.
+    ///
+    /// @param storage The storage to be accessed.
+    /// @param callable The operation to be executed for each block containing matching entities.
+    /// @tparam parallel Whether to use inner parallelism or iterate sequentially.
+    template<bool parallel>
+    static auto run_blocks(auto& storage, auto&& callable) {
+      static_assert(requires { storage.template for_blocks_with<TRequiredComponents...>(callable); }, "Systems taking blocks require a storage with AoSoA blocks.");
+      if constexpr (parallel)
+        return storage.template for_blocks_with_parallel<TRequiredComponents...>(std::forward<decltype(callable)>(callable));
+      else
+        return storage.template for_blocks_with<TRequiredComponents...>(std::forward<decltype(callable)>(callable));
+    }
+
+    /// Executes an iteration over runs of consecutive entities with a callable on some storage.
+    ///
+    /// @param storage The storage to be accessed.
+    /// @param callable The operation to be executed for each run of matching entities.
+    /// @tparam parallel Whether to use inner parallelism or iterate sequentially.
+    template<bool parallel>
+    static auto run_runs(auto& storage, auto&& callable) {
+      static_assert(requires { storage.template for_runs_with<TRequiredComponents...>(callable); }, "Systems taking spans require a storage with contiguous component vectors.");
+      if constexpr (parallel)
+        return storage.template for_runs_with_parallel<TRequiredComponents...>(std::forward<decltype(callable)>(callable));
+      else
+        return storage.template for_runs_with<TRequiredComponents...>(std::forward<decltype(callable)>(callable));
+    }
+
+    /// Registers the required components as a cached query with some storage, if the storage supports it.
+    ///
+    /// @param storage The storage to be accessed.
+    static void cache(auto& storage) {
+      if constexpr (requires { storage.template cache_query<TRequiredComponents...>(); })
+        storage.template cache_query<TRequiredComponents...>();
+    }
   };
 
   /// Executes an entity iteration with a set of required components.
@@ -266,26 +364,184 @@ private:
     return Instance::template run<parallel>(_storage, std::forward<decltype(callable)>(callable));
   }
 
+  /// Executes a block iteration with a set of required components.
+  ///
+  /// Translates the types given as a `boost::hana::tuple_t` to the corresponding template call, like `for_entities_with`.
+  /// @param component_argtypes The required component types matched against each entity as a `boost::hana::tuple_t`.
+  /// @param callable The operation to be executed for each block, with the block index and a bit mask of matching lanes.
+  /// @tparam parallel Whether to use inner parallelism or iterate sequentially.
+  template<bool parallel>
+  auto for_blocks_with(auto component_argtypes, auto&& callable) {
+    using Instance = typename decltype(hana::unpack(component_argtypes, hana::template_<ForEntitiesWith>))::type;
+    return Instance::template run_blocks<parallel>(_storage, std::forward<decltype(callable)>(callable));
+  }
+
+  /// Executes an iteration over runs of consecutive entities with a set of required components.
+  ///
+  /// Translates the types given as a `boost::hana::tuple_t` to the corresponding template call, like `for_entities_with`.
+  /// @param component_argtypes The required component types matched against each entity as a `boost::hana::tuple_t`.
+  /// @param callable The operation to be executed for each run, with the index of its first entity and its number of entities.
+  /// @tparam parallel Whether to use inner parallelism or iterate sequentially.
+  template<bool parallel>
+  auto for_runs_with(auto component_argtypes, auto&& callable) {
+    using Instance = typename decltype(hana::unpack(component_argtypes, hana::template_<ForEntitiesWith>))::type;
+    return Instance::template run_runs<parallel>(_storage, std::forward<decltype(callable)>(callable));
+  }
+
+  /// Registers a set of required components as a cached query with the storage.
+  ///
+  /// Translates the types given as a `boost::hana::tuple_t` to the corresponding template call, like `for_entities_with`.
+  /// @param component_argtypes The required component types as a `boost::hana::tuple_t`.
+  void cache_query(auto component_argtypes) {
+    using Instance = typename decltype(hana::unpack(component_argtypes, hana::template_<ForEntitiesWith>))::type;
+    Instance::cache(_storage);
+  }
+
   template<typename TSystem>
   void run_system() {
     // Extract the return type of the system call.
     // This is later used to determine whether a managed call needs to be done.
     using ReturnType = ct::return_type_t<TSystem>;
+    // The change tick of this run, and that of the last run, after which changes pass the system's change filters.
+    const uint64_t tick = Scheduler::change_tick(_frame, Scheduler::template system_index<TSystem>);
+    [[maybe_unused]] const uint64_t since = std::exchange(_change_ticks[Scheduler::template system_index<TSystem>], tick);
+    // Calls the system on a filled-in tuple of arguments.
+    auto invoke = [&](auto& args) {
+      // If the system execution returns a callable operation, it is called immediately
+      // with the runtime manager as an argument.
+      // This is necessary, since the system functions can not be template functions
+      // (because their parameter types are extracted and used here, requiring them to be concrete),
+      // however, the runtime manager type is not known at the time of system declaration.
+      // Thus, the system call may may return a template function (e.g., a lambda with `auto` parameter)
+      // which is then instantiated with the correct manager type.
+      if constexpr (std::is_invocable_v<ReturnType, const ParallelRuntimeManager&>) {
+        // Call the system on the filled-in tuple of arguments and call the result with the manager.
+        // `hana::unpack` applies the tuple of arguments as parameters to a function call.
+        // The function called here is implicitly `system.operator()` for objects.
+        hana::unpack(args, get_system<TSystem>())(_runtime_manager);
+      } else {
+        // If the system call result is not invocable, discard it.
+        hana::unpack(args, get_system<TSystem>());
+      }
+    };
+    // Systems taking blocks of components are called once per block.
+    static_assert(!Info::template filtered<TSystem> || !(Info::template blockwise<TSystem> || Info::template spanwise<TSystem>), "Systems taking blocks or spans can not filter entities by changes.");
+    static_assert(hana::is_empty(Info::template optional_argtypes<TSystem>) || !(Info::template blockwise<TSystem> || Info::template spanwise<TSystem>), "Systems taking blocks or spans can not take optional components.");
+    static_assert(hana::is_empty(Info::template excluded_argtypes<TSystem>) || Scheduler::matches_exclusions || !(Info::template blockwise<TSystem> || Info::template spanwise<TSystem>), "Systems taking blocks or spans can only exclude component types if the storage matches exclusions.");
+    if constexpr (Info::template blockwise<TSystem>) {
+      // Iterate all blocks containing entities with matching components associated with them.
+      for_blocks_with<Info::template parallelizable<TSystem>>(Scheduler::template query_argtypes<TSystem>, [&](size_t block, uint64_t lanes) {
+        // Transform the system-required parameter types to their filled-in values.
+        auto args = hana::transform(argtypes_of<TSystem>, [&](auto parameter) {
+          using Parameter = ParameterTraits<typename decltype(parameter)::type>;
+          using ArgType = typename Parameter::Accessed;
+          static_assert(Parameter::blockwise || is_exclusion<std::decay_t<typename decltype(parameter)::type>> || hana::find(Info::components, hana::type_c<ArgType>) == hana::nothing, "Systems taking blocks can only take components as blocks.");
+          static_assert(!std::is_same_v<ArgType, Entity>, "Systems taking blocks can not take entity handles.");
+          // Exclusions carry no data, the storage matched them already.
+          if constexpr (is_exclusion<std::decay_t<typename decltype(parameter)::type>>) {
+            return std::decay_t<typename decltype(parameter)::type>{};
+          }
+          // Get a storage-stored block of components as the argument.
+          if constexpr (Parameter::blockwise) {
+            return std::ref(_storage.template get_block<ArgType>(block));
+          }
+          // Check if the argument type is a stored system type.
+          if constexpr (hana::find(Info::systems, hana::type_c<ArgType>) != hana::nothing) {
+            return std::ref(get_system<ArgType>());
+          }
+          // Check if the argument type is a floating point number, representing a delta time.
+          if constexpr (hana::find(hana::tuple_t<double, float>, hana::type_c<ArgType>) != hana::nothing) {
+            return _delta_time;
+          }
+        });
+        // Blocks may contain entities the system does not apply to, whose components are preserved.
+        Scheduler::template preserve_unmatched_lanes<TSystem>(args, lanes, [&]() { invoke(args); });
+      });
+    } else if constexpr (Info::template spanwise<TSystem>) {
+      // Iterate all runs of consecutive entities with matching components associated with them.
+      for_runs_with<Info::template parallelizable<TSystem>>(Scheduler::template query_argtypes<TSystem>, [&](size_t begin, size_t count) {
+        // Transform the system-required parameter types to their filled-in values.
+        auto args = hana::transform(argtypes_of<TSystem>, [&](auto parameter) {
+          using Parameter = ParameterTraits<typename decltype(parameter)::type>;
+          using ArgType = typename Parameter::Accessed;
+          static_assert(Parameter::spanwise || is_exclusion<std::decay_t<typename decltype(parameter)::type>> || (hana::find(Info::components, hana::type_c<ArgType>) == hana::nothing && !std::is_same_v<ArgType, Entity>), "Systems taking spans can only take components and entity handles as spans.");
+          // Exclusions carry no data, the storage matched them already.
+          if constexpr (is_exclusion<std::decay_t<typename decltype(parameter)::type>>) {
+            return std::decay_t<typename decltype(parameter)::type>{};
+          }
+          // Get a span of entity handles as the argument.
+          if constexpr (Parameter::spanwise && std::is_same_v<ArgType, Entity>) {
+            return _storage.get_entity_span(begin, count);
+          }
+          // Get a span of the previous frame's copies of a double-buffered component type as the argument of a reader.
+          else if constexpr (Parameter::spanwise && Scheduler::template reads_previous<typename decltype(parameter)::type>) {
+            return _storage.template get_previous_span<ArgType>(begin, count);
+          }
+          // Get a span of storage-stored components as the argument, const-qualified like the parameter.
+          else if constexpr (Parameter::spanwise) {
+            return _storage.template get_span<std::conditional_t<Parameter::writes, ArgType, const ArgType>>(begin, count);
+          }
+          // Check if the argument type is a stored system type.
+          if constexpr (hana::find(Info::systems, hana::type_c<ArgType>) != hana::nothing) {
+            return std::ref(get_system<ArgType>());
+          }
+          // Check if the argument type is a floating point number, representing a delta time.
+          if constexpr (hana::find(hana::tuple_t<double, float>, hana::type_c<ArgType>) != hana::nothing) {
+            return _delta_time;
+          }
+        });
+        invoke(args);
+      });
+    } else {
     // Iterate all entities with matching components associated with them.
-    for_entities_with<Info::template parallelizable<TSystem>>(Info::template component_argtypes<TSystem>, [&](Entity entity) {
+    for_entities_with<Info::template parallelizable<TSystem>>(Scheduler::template query_argtypes<TSystem>, [&](Entity entity) {
+      // Skip entities with excluded component types attached, unless the storage did not match them already.
+      if constexpr (!Scheduler::matches_exclusions)
+        if (Scheduler::template excluded<TSystem>(_storage, entity)) return;
+      // Skip entities whose components did not change as required by the system's change filters.
+      if constexpr (Info::template filtered<TSystem>)
+        if (!Scheduler::template passes_filters<TSystem>(_storage, entity, since)) return;
       // Transform the system-required parameter types to their filled-in values.
       // E.g., if a component type is to be passed in, this fetches that component.
       // This `args` tuple then contains the actual parameters to be passed into the system call.
-      auto args = hana::transform(Info::template argtypes<TSystem>, [&](auto argtype) {
-        // Fetch the argument type value from the tuple and convert to a type alias.
-        using ArgType = typename decltype(argtype)::type;
+      auto args = hana::transform(argtypes_of<TSystem>, [&](auto parameter) {
+        // Fetch the accessed argument type from the (non-decayed) parameter type and convert to a type alias.
+        using Parameter = ParameterTraits<typename decltype(parameter)::type>;
+        using ArgType = typename Parameter::Accessed;
+        auto argtype = hana::type_c<ArgType>;
         // Check if the argument type is a stored component type.
         if constexpr (hana::find(Info::components, argtype) != hana::nothing) {
           // Get a storage-stored component reference as the argument.
           // Plain references can not be stored in a heterogenous container.
           // Thus, reference_wrapper (created by std::ref) is needed to store the reference in the args container
           // (to later be unpacked into the system call).
-          return std::ref(_storage.template get_component<ArgType>(entity));
+          // Exclusions carry no data.
+          if constexpr (is_exclusion<std::decay_t<typename decltype(parameter)::type>>)
+            return std::decay_t<typename decltype(parameter)::type>{};
+          // Optional components are passed as a pointer, which is null if the component is not attached.
+          else if constexpr (is_optional<std::decay_t<typename decltype(parameter)::type>>) {
+            using Wrapper = std::decay_t<typename decltype(parameter)::type>;
+            if (!_storage.template has_component<ArgType>(entity)) return Wrapper();
+            if constexpr (Scheduler::template reads_previous<typename decltype(parameter)::type>)
+              return Wrapper(&_storage.template get_previous_component<ArgType>(entity));
+            else {
+              static_assert(std::is_reference_v<decltype(_storage.template get_component<ArgType>(entity))>, "Optional components require components which can be referenced individually.");
+              return Wrapper(&_storage.template get_component<ArgType>(entity));
+            }
+          }
+          // Change filters wrap the component, which must be referenceable.
+          else if constexpr (is_change_filter<std::decay_t<typename decltype(parameter)::type>>) {
+            static_assert(std::is_reference_v<decltype(_storage.template get_component<ArgType>(entity))>, "Change filters require components which can be referenced individually.");
+            return std::decay_t<typename decltype(parameter)::type>(_storage.template get_component<ArgType>(entity));
+          }
+          // Readers of a double-buffered component type get the previous frame's copy, so they need not wait for writers.
+          else if constexpr (Scheduler::template reads_previous<typename decltype(parameter)::type>)
+            return std::cref(_storage.template get_previous_component<ArgType>(entity));
+          else if constexpr (std::is_reference_v<decltype(_storage.template get_component<ArgType>(entity))>)
+            return std::ref(_storage.template get_component<ArgType>(entity));
+          // Components which can not be referenced individually (e.g., in AoSoA blocks) are passed as a staged copy,
+          // which is written back after the call, unless the parameter is const.
+          else return _storage.template get_component<std::conditional_t<Parameter::writes, ArgType, const ArgType>>(entity);
         }
         // Check if the argument type is a stored system type.
         if constexpr (hana::find(Info::systems, argtype) != hana::nothing) {
@@ -302,23 +558,15 @@ private:
           return  _delta_time;
         }
       });
-      // If the system execution returns a callable operation, it is called immediately
-      // with the runtime manager as an argument.
-      // This is necessary, since the system functions can not be template functions
-      // (because their parameter types are extracted and used here, requiring them to be concrete),
-      // however, the runtime manager type is not known at the time of system declaration.
-      // Thus, the system call may may return a template function (e.g., a lambda with `auto` parameter)
-      // which is then instantiated with the correct manager type.
-      if constexpr (std::is_invocable_v<ReturnType, const ParallelRuntimeManager&>) {
-        // Call the system on the filled-in tuple of arguments and call the result with the manager.
-        // `hana::unpack` applies the tuple of arguments as parameters to a function call.
-        // The function called here is implicitly `system.operator()` for objects.
-        hana::unpack(args, get_system<TSystem>())(_runtime_manager);
-      } else {
-        // If the system call result is not invocable, discard it.
-        hana::unpack(args, get_system<TSystem>());
-      }
+      invoke(args);
+      // Systems filtering entities mark the changes of the entities they are called for.
+      if constexpr (Info::template filtered<TSystem>)
+        Scheduler::template mark_changes<TSystem>(_storage, tick, entity);
     });
+    }
+    // Mark the changes of all entities the system accessed mutably at once.
+    if constexpr (!Info::template filtered<TSystem>)
+      Scheduler::template mark_changes<TSystem>(_storage, tick);
   }
 
 public:
@@ -1,8 +1,10 @@
 #pragma once
 
+#include <array>
 #include <type_traits>
 #include <tuple>
 #include <functional>
+#include <filesystem>
 
 #include <boost/hana.hpp>
 #include <boost/hana/ext/std/tuple.hpp>
@@ -10,6 +12,7 @@
 #include "scanta/scaffold/scheduler.hpp"
 
 #include "scanta/util/timer.hpp"
+#include "scanta/util/snapshot.hpp"
 
 namespace hana = boost::hana;
 namespace ct = boost::callable_traits;
@@ -40,7 +43,7 @@ public:
     // Systems are passed as references and stored in a scheduler-owned tuple.
     _systems(std::make_tuple(std::forward<TSystems>(systems)...)),
     _runtime_manager(*this, _storage),
-    _deferred_manager(*this, _storage)
+    _deferred_manager(*this, _storage, _events)
   {
     // As is, lvalue-referenced systems would be copied in.
     // Copying in the systems is almost never what a user wants.
@@ -52,6 +55,11 @@ public:
     // TODO: Statically assert that no system is specified twice.
     // TODO: Statically assert system invocability.
     // TODO: Statically assert that no component type is specified more than once in system parameters.
+
+    // Let the storage cache the entities matching each system's required components, if it supports doing so.
+    (cache_query(Info::template component_argtypes<TSystems>), ...);
+    // Let the storage track the changes of the component types systems filter entities by.
+    Scheduler::track_changes(_storage);
   }
 
   /// Returns a reference to a stored system.
@@ -67,6 +75,13 @@ public:
     _deferred_operations.push_back(operation);
   }
 
+  /// Requests a snapshot of the storage to be captured at the end of the current frame.
+  ///
+  /// @param path The path of the file to write the snapshot to.
+  inline void request_snapshot(const std::filesystem::path& path) {
+    _snapshot_paths.push_back(path);
+  }
+
   /// Executes and clears all currently queued deferred operations.
   inline void dispatch_deferred_operations() {
     for (auto& operation : _deferred_operations) operation(_deferred_manager);
@@ -81,28 +96,159 @@ public:
     // TODO: Only get delta_time if required by a system.
     // Get the time since the last call.
     double delta_time = _timer.reset();
-    // Iterate each system stored.
-    hana::for_each(_systems, [&](auto& system) {
+    ++_frame;
+
+    // Storages keeping copies of the previous frame's components of double-buffered types take them now,
+    // after all structural changes of the last frame (and in between frames) have been made.
+    if constexpr (requires { _storage.update_buffers(); })
+      _storage.update_buffers();
+    // Runs a system for all entities matching its required components.
+    auto run_system = [&](auto& system) {
       // The system type as a type alias.
       using System = decltype(system);
       // Extract the return type of the system call.
       // This is later used to determine whether a managed call needs to be done.
       using ReturnType = ct::return_type_t<System>;
+      // The change tick of this run, and that of the last run, after which changes pass the system's change filters.
+      const uint64_t tick = Scheduler::change_tick(_frame, Scheduler::template system_index<System>);
+      [[maybe_unused]] const uint64_t since = std::exchange(_change_ticks[Scheduler::template system_index<System>], tick);
+      // Calls the system on a filled-in tuple of arguments.
+      auto invoke = [&](auto& args) {
+        // If the system execution returns a callable operation, it is called immediately
+        // with the runtime manager as an argument.
+        // This is necessary, since the system functions can not be template functions
+        // (because their parameter types are extracted and used here, requiring them to be concrete),
+        // however, the runtime manager type is not known at the time of system declaration.
+        // Thus, the system call may may return a template function (e.g., a lambda with `auto` parameter)
+        // which is then instantiated with the correct manager type.
+        if constexpr (std::is_invocable_v<ReturnType, const SequentialRuntimeManager&>) {
+          // Call the system on the filled-in tuple of arguments and call the result with the manager.
+          // `hana::unpack` applies the tuple of arguments as parameters to a function call.
+          // The function called here is implicitly `system.operator()` for objects.
+          hana::unpack(args, system)(_runtime_manager);
+        } else {
+          // If the system call result is not invocable, discard it.
+          hana::unpack(args, system);
+        }
+      };
+      // Systems taking blocks of components are called once per block.
+      static_assert(!Info::template filtered<System> || !(Info::template blockwise<System> || Info::template spanwise<System>), "Systems taking blocks or spans can not filter entities by changes.");
+      static_assert(hana::is_empty(Info::template optional_argtypes<System>) || !(Info::template blockwise<System> || Info::template spanwise<System>), "Systems taking blocks or spans can not take optional components.");
+      static_assert(hana::is_empty(Info::template excluded_argtypes<System>) || Scheduler::matches_exclusions || !(Info::template blockwise<System> || Info::template spanwise<System>), "Systems taking blocks or spans can only exclude component types if the storage matches exclusions.");
+      if constexpr (Info::template blockwise<System>) {
+        // Iterate all blocks containing entities with matching components associated with them.
+        for_blocks_with<Info::template parallelizable<System>>(Scheduler::template query_argtypes<System>, [&](size_t block, uint64_t lanes) {
+          // Transform the system-required parameter types to their filled-in values.
+          auto args = hana::transform(argtypes_of<System>, [&](auto parameter) {
+            using Parameter = ParameterTraits<typename decltype(parameter)::type>;
+            using ArgType = typename Parameter::Accessed;
+            static_assert(Parameter::blockwise || is_exclusion<std::decay_t<typename decltype(parameter)::type>> || hana::find(Info::components, hana::type_c<ArgType>) == hana::nothing, "Systems taking blocks can only take components as blocks.");
+            static_assert(!std::is_same_v<ArgType, Entity>, "Systems taking blocks can not take entity handles.");
+            // Exclusions carry no data, the storage matched them already.
+            if constexpr (is_exclusion<std::decay_t<typename decltype(parameter)::type>>) {
+              return std::decay_t<typename decltype(parameter)::type>{};
+            }
+            // Get a storage-stored block of components as the argument.
+            if constexpr (Parameter::blockwise) {
+              return std::ref(_storage.template get_block<ArgType>(block));
+            }
+            // Check if the argument type is a stored system type.
+            if constexpr (hana::find(Info::systems, hana::type_c<ArgType>) != hana::nothing) {
+              return std::ref(get_system<ArgType>());
+            }
+            // Check if the argument type is a floating point number, representing a delta time.
+            if constexpr (hana::find(hana::tuple_t<double, float>, hana::type_c<ArgType>) != hana::nothing) {
+              return delta_time;
+            }
+          });
+          // Blocks may contain entities the system does not apply to, whose components are preserved.
+          Scheduler::template preserve_unmatched_lanes<System>(args, lanes, [&]() { invoke(args); });
+        });
+      } else if constexpr (Info::template spanwise<System>) {
+        // Iterate all runs of consecutive entities with matching components associated with them.
+        for_runs_with<Info::template parallelizable<System>>(Scheduler::template query_argtypes<System>, [&](size_t begin, size_t count) {
+          // Transform the system-required parameter types to their filled-in values.
+          auto args = hana::transform(argtypes_of<System>, [&](auto parameter) {
+            using Parameter = ParameterTraits<typename decltype(parameter)::type>;
+            using ArgType = typename Parameter::Accessed;
+            static_assert(Parameter::spanwise || is_exclusion<std::decay_t<typename decltype(parameter)::type>> || (hana::find(Info::components, hana::type_c<ArgType>) == hana::nothing && !std::is_same_v<ArgType, Entity>), "Systems taking spans can only take components and entity handles as spans.");
+            // Exclusions carry no data, the storage matched them already.
+            if constexpr (is_exclusion<std::decay_t<typename decltype(parameter)::type>>) {
+              return std::decay_t<typename decltype(parameter)::type>{};
+            }
+            // Get a span of entity handles as the argument.
+            if constexpr (Parameter::spanwise && std::is_same_v<ArgType, Entity>) {
+              return _storage.get_entity_span(begin, count);
+            }
+            // Get a span of the previous frame's copies of a double-buffered component type as the argument of a reader.
+            else if constexpr (Parameter::spanwise && Scheduler::template reads_previous<typename decltype(parameter)::type>) {
+              return _storage.template get_previous_span<ArgType>(begin, count);
+            }
+            // Get a span of storage-stored components as the argument, const-qualified like the parameter.
+            else if constexpr (Parameter::spanwise) {
+              return _storage.template get_span<std::conditional_t<Parameter::writes, ArgType, const ArgType>>(begin, count);
+            }
+            // Check if the argument type is a stored system type.
+            if constexpr (hana::find(Info::systems, hana::type_c<ArgType>) != hana::nothing) {
+              return std::ref(get_system<ArgType>());
+            }
+            // Check if the argument type is a floating point number, representing a delta time.
+            if constexpr (hana::find(hana::tuple_t<double, float>, hana::type_c<ArgType>) != hana::nothing) {
+              return delta_time;
+            }
+          });
+          invoke(args);
+        });
+      } else {
       // Iterate all entities with matching components associated with them.
-      for_entities_with<Info::template parallelizable<System>>(Info::template component_argtypes<System>, [&](Entity entity) {
+      for_entities_with<Info::template parallelizable<System>>(Scheduler::template query_argtypes<System>, [&](Entity entity) {
+        // Skip entities with excluded component types attached, unless the storage did not match them already.
+        if constexpr (!Scheduler::matches_exclusions)
+          if (Scheduler::template excluded<System>(_storage, entity)) return;
+        // Skip entities whose components did not change as required by the system's change filters.
+        if constexpr (Info::template filtered<System>)
+          if (!Scheduler::template passes_filters<System>(_storage, entity, since)) return;
         // Transform the system-required parameter types to their filled-in values.
         // E.g., if a component type is to be passed in, this fetches that component.
         // This `args` tuple then contains the actual parameters to be passed into the system call.
-        auto args = hana::transform(Info::template argtypes<System>, [&](auto argtype) {
-          // Fetch the argument type value from the tuple and convert to a type alias.
-          using ArgType = typename decltype(argtype)::type;
+        auto args = hana::transform(argtypes_of<System>, [&](auto parameter) {
+          // Fetch the accessed argument type from the (non-decayed) parameter type and convert to a type alias.
+          using Parameter = ParameterTraits<typename decltype(parameter)::type>;
+          using ArgType = typename Parameter::Accessed;
+          auto argtype = hana::type_c<ArgType>;
           // Check if the argument type is a stored component type.
           if constexpr (hana::find(Info::components, argtype) != hana::nothing) {
             // Get a storage-stored component reference as the argument.
             // Plain references can not be stored in a heterogenous container.
             // Thus, reference_wrapper (created by std::ref) is needed to store the reference in the args container
             // (to later be unpacked into the system call).
-            return std::ref(_storage.template get_component<ArgType>(entity));
+            // Exclusions carry no data.
+            if constexpr (is_exclusion<std::decay_t<typename decltype(parameter)::type>>)
+              return std::decay_t<typename decltype(parameter)::type>{};
+            // Optional components are passed as a pointer, which is null if the component is not attached.
+            else if constexpr (is_optional<std::decay_t<typename decltype(parameter)::type>>) {
+              using Wrapper = std::decay_t<typename decltype(parameter)::type>;
+              if (!_storage.template has_component<ArgType>(entity)) return Wrapper();
+              if constexpr (Scheduler::template reads_previous<typename decltype(parameter)::type>)
+                return Wrapper(&_storage.template get_previous_component<ArgType>(entity));
+              else {
+                static_assert(std::is_reference_v<decltype(_storage.template get_component<ArgType>(entity))>, "Optional components require components which can be referenced individually.");
+                return Wrapper(&_storage.template get_component<ArgType>(entity));
+              }
+            }
+            // Change filters wrap the component, which must be referenceable.
+            else if constexpr (is_change_filter<std::decay_t<typename decltype(parameter)::type>>) {
+              static_assert(std::is_reference_v<decltype(_storage.template get_component<ArgType>(entity))>, "Change filters require components which can be referenced individually.");
+              return std::decay_t<typename decltype(parameter)::type>(_storage.template get_component<ArgType>(entity));
+            }
+            // Readers of a double-buffered component type get the previous frame's copy, so they need not wait for writers.
+            else if constexpr (Scheduler::template reads_previous<typename decltype(parameter)::type>)
+              return std::cref(_storage.template get_previous_component<ArgType>(entity));
+            else if constexpr (std::is_reference_v<decltype(_storage.template get_component<ArgType>(entity))>)
+              return std::ref(_storage.template get_component<ArgType>(entity));
+            // Components which can not be referenced individually (e.g., in AoSoA blocks) are passed as a staged copy,
+            // which is written back after the call, unless the parameter is const.
+            else return _storage.template get_component<std::conditional_t<Parameter::writes, ArgType, const ArgType>>(entity);
           }
           // Check if the argument type is a stored system type.
           if constexpr (hana::find(Info::systems, argtype) != hana::nothing) {
@@ -119,34 +265,46 @@ public:
             return  delta_time;
           }
         });
-        // If the system execution returns a callable operation, it is called immediately
-        // with the runtime manager as an argument.
-        // This is necessary, since the system functions can not be template functions
-        // (because their parameter types are extracted and used here, requiring them to be concrete),
-        // however, the runtime manager type is not known at the time of system declaration.
-        // Thus, the system call may may return a template function (e.g., a lambda with `auto` parameter)
-        // which is then instantiated with the correct manager type.
-        if constexpr (std::is_invocable_v<ReturnType, const SequentialRuntimeManager&>) {
-          // Call the system on the filled-in tuple of arguments and call the result with the manager.
-          // `hana::unpack` applies the tuple of arguments as parameters to a function call.
-          // The function called here is implicitly `system.operator()` for objects.
-          hana::unpack(args, system)(_runtime_manager);
-        } else {
-          // If the system call result is not invocable, discard it.
-          hana::unpack(args, system);
-        }
+        invoke(args);
+        // Systems filtering entities mark the changes of the entities they are called for.
+        if constexpr (Info::template filtered<System>)
+          Scheduler::template mark_changes<System>(_storage, tick, entity);
       });
+      }
+      // Mark the changes of all entities the system accessed mutably at once.
+      if constexpr (!Info::template filtered<System>)
+        Scheduler::template mark_changes<System>(_storage, tick);
+    };
+    // Iterate each system stored, except for observers, which are only run on the events of the frame.
+    hana::for_each(_systems, [&](auto& system) {
+      if constexpr (!Info::template observer<std::decay_t<decltype(system)>>) run_system(system);
     });
 
+    // Stamp the structural changes of the deferred operations after the changes of all systems.
+    if constexpr (requires { _storage.set_change_tick(uint64_t{}); })
+      _storage.set_change_tick(Scheduler::change_tick(_frame, sizeof...(TSystems)));
+
     // Execute all currently queued deferred operations.
     dispatch_deferred_operations();
 
+    // Pass the structural events of the frame to the observers, and execute the operations they defer.
+    if constexpr (Scheduler::EventLog::observing) {
+      Scheduler::run_observers(*this, _events, _storage, _deferred_manager, delta_time);
+      dispatch_deferred_operations();
+    }
+
     // Certain entity-component storages need to be refreshed periodically to restore
     // certain preconditions or optimizations.
     // Check whether the used storage supports it, by seeing if the expression
     // is well-formed. If so, call it.
     if constexpr (requires { _storage.refresh(); })
       _storage.refresh();
+
+    // Capture the requested snapshots now that the storage is consistent,
+    // and leave serializing and writing them to the background writer.
+    if constexpr (requires { _storage.snapshot(); })
+      for (const auto& path : _snapshot_paths) _snapshot_writer.write(path, _storage.snapshot(_snapshot_writer.recycle()));
+    _snapshot_paths.clear();
   }
 
 private:
@@ -156,6 +314,15 @@ private:
   /// The entity & component storage.
   typename Scheduler::Storage _storage;
 
+  /// The structural events of the current frame, passed to observers after the deferred operations.
+  typename Scheduler::EventLog _events;
+
+  /// The number of the current frame, counting from 1.
+  uint64_t _frame = 0;
+
+  /// The change tick of the last run of each system (see `Scheduler::change_tick`).
+  std::array<uint64_t, sizeof...(TSystems)> _change_ticks{};
+
   /// Tuple to store references to the systems.
   ///
   /// This tuple is iterated at execution time by `boost::hana` functions.
@@ -182,6 +349,12 @@ private:
   /// Timer for measuring frame times
   timing::Timer _timer;
 
+  /// The files to write snapshots of the storage to at the end of the current frame.
+  std::vector<std::filesystem::path> _snapshot_paths;
+
+  /// The background writer of snapshots.
+  SnapshotWriter _snapshot_writer;
+
   /// Struct encapsulating a function call to iterate over entities in the storage
   /// with a set of required components.
   ///
@@ -201,6 +374,42 @@ private:
       else
         return storage.template for_entities_with<TRequiredComponents...>(std::forward<decltype(callable)>(callable));
     }
+
+    /// Executes a block iteration with a callable on some storage.
+    ///
+    /// @param storage The storage to be accessed.
+    /// @param callable The operation to be executed for each block containing matching entities.
+    /// @tparam parallel Whether to use inner parallelism or iterate sequentially.
+    template<bool parallel>
+    static auto run_blocks(auto& storage, auto&& callable) {
+      static_assert(requires { storage.template for_blocks_with<TRequiredComponents...>(callable); }, "Systems taking blocks require a storage with AoSoA blocks.");
+      if constexpr (parallel)
+        return storage.template for_blocks_with_parallel<TRequiredComponents...>(std::forward<decltype(callable)>(callable));
+      else
+        return storage.template for_blocks_with<TRequiredComponents...>(std::forward<decltype(callable)>(callable));
+    }
+
+    /// Executes an iteration over runs of consecutive entities with a callable on some storage.
+    ///
+    /// @param storage The storage to be accessed.
+    /// @param callable The operation to be executed for each run of matching entities.
+    /// @tparam parallel Whether to use inner parallelism or iterate sequentially.
+    template<bool parallel>
+    static auto run_runs(auto& storage, auto&& callable) {
+      static_assert(requires { storage.template for_runs_with<TRequiredComponents...>(callable); }, "Systems taking spans require a storage with contiguous component vectors.");
+      if constexpr (parallel)
+        return storage.template for_runs_with_parallel<TRequiredComponents...>(std::forward<decltype(callable)>(callable));
+      else
+        return storage.template for_runs_with<TRequiredComponents...>(std::forward<decltype(callable)>(callable));
+    }
+
+    /// Registers the required components as a cached query with some storage, if the storage supports it.
+    ///
+    /// @param storage The storage to be accessed.
+    static void cache(auto& storage) {
+      if constexpr (requires { storage.template cache_query<TRequiredComponents...>(); })
+        storage.template cache_query<TRequiredComponents...>();
+    }
   };
 
   /// Executes an entity iteration with a set of required components.
@@ -221,6 +430,39 @@ private:
     return Instance::template run<parallel>(_storage, std::forward<decltype(callable)>(callable));
   }
 
+  /// Executes a block iteration with a set of required components.
+  ///
+  /// Translates the types given as a `boost::hana::tuple_t` to the corresponding template call, like `for_entities_with`.
+  /// @param component_argtypes The required component types matched against each entity as a `boost::hana::tuple_t`.
+  /// @param callable The operation to be executed for each block, with the block index and a bit mask of matching lanes.
+  /// @tparam parallel Whether to use inner parallelism or iterate sequentially.
+  template<bool parallel>
+  auto for_blocks_with(auto component_argtypes, auto&& callable) {
+    using Instance = typename decltype(hana::unpack(component_argtypes, hana::template_<ForEntitiesWith>))::type;
+    return Instance::template run_blocks<parallel>(_storage, std::forward<decltype(callable)>(callable));
+  }
+
+  /// Executes an iteration over runs of consecutive entities with a set of required components.
+  ///
+  /// Translates the types given as a `boost::hana::tuple_t` to the corresponding template call, like `for_entities_with`.
+  /// @param component_argtypes The required component types matched against each entity as a `boost::hana::tuple_t`.
+  /// @param callable The operation to be executed for each run, with the index of its first entity and its number of entities.
+  /// @tparam parallel Whether to use inner parallelism or iterate sequentially.
+  template<bool parallel>
+  auto for_runs_with(auto component_argtypes, auto&& callable) {
+    using Instance = typename decltype(hana::unpack(component_argtypes, hana::template_<ForEntitiesWith>))::type;
+    return Instance::template run_runs<parallel>(_storage, std::forward<decltype(callable)>(callable));
+  }
+
+  /// Registers a set of required components as a cached query with the storage.
+  ///
+  /// Translates the types given as a `boost::hana::tuple_t` to the corresponding template call, like `for_entities_with`.
+  /// @param component_argtypes The required component types as a `boost::hana::tuple_t`.
+  void cache_query(auto component_argtypes) {
+    using Instance = typename decltype(hana::unpack(component_argtypes, hana::template_<ForEntitiesWith>))::type;
+    Instance::cache(_storage);
+  }
+
 public:
 
   /// Constant reference to the deferred manager.
@@ -0,0 +1,614 @@
+#pragma once
+
+#include <iostream>
+#include <tuple>
+#include <vector>
+#include <array>
+#include <cassert>
+#include <algorithm>
+#include <filesystem>
+#include <iterator>
+#include <memory>
+#include <stdexcept>
+#include <type_traits>
+#include <unordered_map>
+
+#include <bitset2/bitset2.hpp>
+
+#include <boost/hana.hpp>
+namespace hana = boost::hana;
+using namespace hana::literals;
+
+#include "scanta/util/type_index.hpp"
+#include "scanta/util/query.hpp"
+#include "scanta/util/snapshot.hpp"
+
+namespace scanta::storage {
+
+/// Stores components in chunks grouped by the exact entity signature (_archetype_).
+///
+/// Every distinct combination of attached component types has its own chunk.
+/// Inside a chunk, components are stored in one vector per component type, but only
+/// for the component types actually contained in the chunk's signature.
+/// Iteration only visits chunks whose signature is a superset of the required components.
+///
+/// @tparam TAllocator The allocator template allocating the component vectors (see `allocator.hpp`).
+/// @tparam TStoredComponents The component types to be stored.
+template<template<typename> typename TAllocator, typename... TStoredComponents>
+class BasicArchetype {
+private:
+  /// The list of stored component types as a hana::tuple_t.
+  ///
+  /// This allows handling the type list as a value instead of a template parameter pack,
+  /// making it iterable and mutable with boost::hana functions.
+  static constexpr auto _component_types = hana::tuple_t<TStoredComponents...>;
+
+  /// The entity signature type.
+  ///
+  /// A bitset with a single bit for each component type.
+  using Signature = Bitset2::bitset2<sizeof...(TStoredComponents)>;
+
+  /// The vector type storing the components of a single type within a chunk.
+  ///
+  /// @tparam T The component type.
+  template<typename T>
+  using Vector = std::vector<T, TAllocator<T>>;
+
+  /// Field for accessing the index of a component type within the list of stored component types.
+  ///
+  /// @tparam TComponent The component type to access the index of.
+  template<typename TComponent>
+  static constexpr size_t _component_index = type_index<TComponent, TStoredComponents...>;
+
+  /// An entity signature generated from a set of component types.
+  ///
+  /// The bit of each component type passed in is set, while all other bits stay off.
+  /// @tparam TComponents The component types to be represented in the signature.
+  template<typename... TComponents>
+  // Use a fold expression (https://en.cppreference.com/w/cpp/language/fold) to construct the signature.
+  // The bitset accumulator starts out at all zero. For each component type a corresponding signature
+  // with just that bit set is created by shifting and included in the accumulator using a bitwise OR.
+  static constexpr Signature signature_of = (Signature(0) |= ... |= (Signature(1) << _component_index<TComponents>));
+
+  /// The signature of the component types required by a query, i.e., of all entries except for exclusions (see `QueryTraits`).
+  ///
+  /// @tparam TQuery The entries of the query, each a component type or `Without` one.
+  template<typename... TQuery>
+  static constexpr Signature required_of = (Signature(0) |= ... |= (QueryTraits<TQuery>::excluded ? Signature(0) : signature_of<typename QueryTraits<TQuery>::Component>));
+
+  /// The signature of the component types excluded by a query.
+  ///
+  /// @tparam TQuery The entries of the query, each a component type or `Without` one.
+  template<typename... TQuery>
+  static constexpr Signature excluded_of = (Signature(0) |= ... |= (QueryTraits<TQuery>::excluded ? signature_of<typename QueryTraits<TQuery>::Component> : Signature(0)));
+
+  /// Marker for chunk indices and transitions that have not been determined (yet).
+  static constexpr size_t _none = SIZE_MAX;
+public:
+  /// The handle type for systems to reference entities with.
+  ///
+  /// Entity handles are indices into the location table and stay valid when
+  /// the entity moves between chunks.
+  using Entity = size_t;
+
+  /// Queries may exclude component types by listing them wrapped into `Without`, which is folded into matching chunk signatures.
+  static constexpr bool matches_exclusions = true;
+
+  /// Constructs a storage with no components initially stored.
+  ///
+  /// @param capacity The initial entity capacity for which to allocate memory for.
+  BasicArchetype(size_t capacity = 32) {
+    _locations.reserve(capacity);
+  }
+
+  /// Returns the number of active entities currently stored.
+  ///
+  /// @returns The number of active entities currently stored.
+  size_t get_size() {
+    return _size;
+  }
+
+  /// Test whether or not a component of some type is attached to an entity.
+  ///
+  /// @param entity The entity to be queried.
+  /// @tparam TComponent The component type to be queried.
+  template<typename TComponent>
+  bool has_component(Entity entity) const {
+    // TODO: static_assert component type handled
+    return _chunks[_locations[entity].chunk].signature[_component_index<TComponent>];
+  }
+
+  /// Returns a reference to a single component of some entity.
+  ///
+  /// @param entity The entity to be accessed.
+  /// @tparam TComponent The component type to be queried.
+  template<typename TComponent>
+  TComponent& get_component(Entity entity) {
+    // TODO: static_assert component type handled
+    const EntityLocation& location = _locations[entity];
+    return std::get<Vector<TComponent>>(_chunks[location.chunk].components)[location.row];
+  }
+
+  /// Sets the component data for a single component of some entity.
+  ///
+  /// If the component is not attached yet, the entity is moved to the chunk of its new signature.
+  /// All other components attached to this entity remain attached and unchanged.
+  /// @param entity The entity to which to attach the component.
+  /// @param component The component data to be assigned.
+  template<typename TComponent>
+  void attach_component(Entity entity, TComponent&& component) {
+    // TODO: static_assert component type stored
+    using Component = std::decay_t<TComponent>;
+    // Move the entity to the chunk including the component type, if it is not attached yet.
+    if (!has_component<Component>(entity))
+      move_entity(entity, transition(_locations[entity].chunk, _component_index<Component>));
+    // Assign component from the parameter.
+    get_component<Component>(entity) = std::forward<TComponent>(component);
+  }
+
+  /// Sets the component data for some entity.
+  ///
+  /// Any components previously attached to the entity and not passed in again are detached.
+  /// The passed in components make up the new complete set of components attached to that entity.
+  /// @param entity The entity for which to set the components.
+  /// @param components The components to be assigned.
+  template<typename... TComponents>
+  void set_components(Entity entity, TComponents&&... components) {
+    // TODO: static_assert component type stored
+    // Move the entity to the chunk with exactly the passed in component types.
+    size_t chunk = find_chunk(signature_of<std::decay_t<TComponents>...>);
+    if (chunk != _locations[entity].chunk) move_entity(entity, chunk);
+    // Assign all passed in components using a fold expression.
+    ((get_component<std::decay_t<TComponents>>(entity) = std::forward<TComponents>(components)), ...);
+  }
+
+  /// Detaches a component from an entity.
+  ///
+  /// This moves the entity to the chunk of its new signature, destroying the component data.
+  /// This operation is idempotent.
+  ///
+  /// @tparam TComponent The type of the component to be detached.
+  /// @param entity The entity to be detached from.
+  template<typename TComponent>
+  void detach_component(Entity entity) {
+    // TODO: static_assert component type stored
+    using Component = std::decay_t<TComponent>;
+    if (has_component<Component>(entity))
+      move_entity(entity, transition(_locations[entity].chunk, _component_index<Component>));
+  }
+
+  /// Creates and activates a new entity.
+  ///
+  /// @param components The set of components to be initially associated with the new entity.
+  /// @returns The handle of the new entity.
+  template<typename... TComponents>
+  Entity new_entity(TComponents&&... components) {
+    // Reuse a previously freed entity handle or create a new one.
+    Entity entity;
+    if (!_free.empty()) {
+      entity = _free.back();
+      _free.pop_back();
+    } else {
+      entity = _locations.size();
+      _locations.emplace_back();
+    }
+    // Find the chunk matching the exact signature of the passed in components.
+    size_t index = find_chunk(signature_of<std::decay_t<TComponents>...>);
+    Chunk& chunk = _chunks[index];
+    // Push the initial components into the chunk's vectors.
+    (std::get<Vector<std::decay_t<TComponents>>>(chunk.components).push_back(std::forward<TComponents>(components)), ...);
+    chunk.entities.push_back(entity);
+    _locations[entity] = EntityLocation{index, chunk.entities.size() - 1, true};
+    ++_size;
+    return entity;
+  }
+
+  /// Creates and activates multiple new entities with the same set of component types.
+  ///
+  /// The chunk of the new entities is found once and memory is reserved once for all of them.
+  /// @param count The number of entities to be created.
+  /// @param generator The callable returning the initial components of the `i`-th new entity as a `std::tuple`, given `i`.
+  void new_entities(size_t count, auto&& generator) {
+    generate_entities<false>(count, generator);
+  }
+
+  /// Creates and activates multiple new entities with the same set of component types.
+  /// Employs inner parallelism.
+  ///
+  /// The chunk of the new entities is found once and memory is reserved once for all of them.
+  /// @param count The number of entities to be created.
+  /// @param generator The callable returning the initial components of the `i`-th new entity as a `std::tuple`, given `i`.
+  /// It is called concurrently for different `i`.
+  void new_entities_parallel(size_t count, auto&& generator) {
+    generate_entities<true>(count, generator);
+  }
+
+  /// Creates and activates multiple new entities from columns of components.
+  ///
+  /// The `i`-th new entity is associated with the `i`-th component of each column.
+  /// The columns are adopted as a whole by the chunk of the new entities if it is empty (and no other allocator is configured),
+  /// and have their elements moved otherwise.
+  /// @param columns The initial components of the new entities, one equally-sized vector per component type.
+  template<typename... TComponents>
+  void new_entities(std::vector<TComponents>&&... columns) {
+    const size_t count = std::get<0>(std::tie(columns...)).size();
+    assert(((columns.size() == count) && ...));
+    Chunk& chunk = _chunks[append_entities<TComponents...>(count)];
+    ([&]() {
+      auto& column = std::get<Vector<TComponents>>(chunk.components);
+      // Vectors of other allocators can not be adopted.
+      if constexpr (std::is_same_v<Vector<TComponents>, std::vector<TComponents>>)
+        if (column.empty()) {
+          column = std::move(columns);
+          return;
+        }
+      column.insert(column.end(), std::make_move_iterator(columns.begin()), std::make_move_iterator(columns.end()));
+    }(), ...);
+  }
+
+  /// Removes an entity from the storage.
+  ///
+  /// This merely sets the entity as inactive. Refreshing will later reclaim its chunk row and handle.
+  void remove_entity(Entity entity) {
+    // Ignore repeated removals of the same entity.
+    if (!_locations[entity].active) return;
+    // Set the entity as inactive.
+    _locations[entity].active = false;
+    // Queue the entity for being reclaimed.
+    _removed.push_back(entity);
+    --_size;
+  }
+
+  /// Executes a callable on each entity with all required components attached.
+  ///
+  /// Only chunks with a signature that is a superset of the required components and disjoint from the excluded ones are visited.
+  /// @tparam TRequiredComponents The set of component types required to be attached to an entity to be processed,
+  /// and those required to be detached, wrapped into `Without`.
+  /// @param callable The callable to be executed with each matched entity's handle as an argument.
+  template<typename... TRequiredComponents>
+  void for_entities_with(auto&& callable) const {
+    /// If the list of required component types is empty, the callable is called exactly once.
+    if constexpr (sizeof...(TRequiredComponents) > 0) {
+      // TODO: static_assert component types handled
+      // Construct a signature to be matched against from the required component types.
+      constexpr Signature signature = required_of<TRequiredComponents...>;
+      // The bits compared, such that the bits of excluded component types must be off.
+      constexpr Signature mask = signature | excluded_of<TRequiredComponents...>;
+      for (const Chunk& chunk : _chunks) {
+        // Skip the whole chunk if its signature does not include all required component types, or any excluded one.
+        if ((chunk.signature & mask) != signature) continue;
+        // Every entity in a matching chunk matches.
+        for (Entity entity : chunk.entities)
+          callable(Entity{entity});
+      }
+    } else callable(Entity{SIZE_MAX}); // TODO: move check to scheduler to avoid -1-reservation (and also execute if ECS::Entity is required)
+  }
+
+  /// Executes a callable on each entity with all required components attached.
+  /// Employs inner parallelism.
+  ///
+  /// Only chunks with a signature that is a superset of the required components and disjoint from the excluded ones are visited.
+  /// The entities of each matching chunk are distributed among the threads of a single parallel region.
+  /// @tparam TRequiredComponents The set of component types required to be attached to an entity to be processed,
+  /// and those required to be detached, wrapped into `Without`.
+  /// @param callable The callable to be executed with each matched entity's handle as an argument.
+  // TODO: parametrize parallelization
+  template<typename... TRequiredComponents>
+  void for_entities_with_parallel(auto&& callable) const {
+    if constexpr (sizeof...(TRequiredComponents) > 0) {
+      // TODO: static_assert component types handled
+      static constexpr Signature signature = required_of<TRequiredComponents...>;
+      static constexpr Signature mask = signature | excluded_of<TRequiredComponents...>;
+      #pragma omp parallel
+      for (const Chunk& chunk : _chunks) {
+        if ((chunk.signature & mask) != signature) continue;
+        // Every thread encounters the same chunks in the same order, so the work-sharing loop is well-formed.
+        #pragma omp for
+        for (size_t row = 0; row < chunk.entities.size(); ++row)
+          callable(Entity{chunk.entities[row]});
+      }
+    } else callable(Entity{SIZE_MAX}); // TODO: move check to scheduler
+  }
+
+  /// Refreshes the storage to reclaim the rows and handles of removed entities.
+  ///
+  /// Handles are only made available for reuse by the refresh after the one reclaiming them. Observers of the frame
+  /// in between may thus be passed the removal of a handle (e.g., by an operation deferred by an observer), which is
+  /// not reused by an entity created in the same frame.
+  auto refresh() {
+    // The handles reclaimed by the last refresh have been passed to the observers of their removal by now.
+    _free.insert(_free.end(), _released.begin(), _released.end());
+    _released.clear();
+    for (Entity entity : _removed) {
+      // Remove the entity's row from its chunk.
+      erase_row(_locations[entity].chunk, _locations[entity].row);
+      // Make the handle available for reuse after the next refresh.
+      _released.push_back(entity);
+    }
+    _removed.clear();
+  }
+
+  /// Captures a consistent copy of the storage, to be written to a file off the frame thread.
+  ///
+  /// The storage is refreshed first. Each chunk is captured as its entity handles followed by one section per
+  /// component type, which is empty for types not in its archetype. Component vectors of trivially copyable types
+  /// are thus captured with a single bulk copy per archetype.
+  /// @param snapshot A snapshot written before, whose memory is reused (see `SnapshotWriter::recycle`).
+  /// @returns The snapshot, to be written by `Snapshot::write` or a `SnapshotWriter`.
+  Snapshot snapshot(Snapshot snapshot = {}) requires (is_serializable<TStoredComponents> && ...) {
+    refresh();
+    snapshot.clear();
+    snapshot.capture(_locations);
+    // The handles held back from reuse are free as well.
+    std::vector<Entity> free = _free;
+    free.insert(free.end(), _released.begin(), _released.end());
+    snapshot.capture(free);
+    std::vector<Signature> signatures;
+    for (const Chunk& chunk : _chunks) signatures.push_back(chunk.signature);
+    snapshot.capture(signatures);
+    for (const Chunk& chunk : _chunks) {
+      snapshot.capture(chunk.entities);
+      (snapshot.capture(std::get<Vector<TStoredComponents>>(chunk.components)), ...);
+    }
+    return snapshot;
+  }
+
+  /// Replaces all entities by the ones captured in a snapshot file.
+  ///
+  /// Handles of the captured entities are valid again afterwards.
+  /// @param path The path of the snapshot file, captured from a storage of the same component types.
+  /// @throws std::runtime_error when the file does not hold a snapshot of such a storage, in which case the storage
+  /// is left in an unspecified state.
+  void restore(const std::filesystem::path& path) requires (is_serializable<TStoredComponents> && ...) {
+    SnapshotReader reader(path);
+    _removed.clear();
+    _released.clear();
+    _chunks.clear();
+    _chunk_indices.clear();
+    reader.read(_locations);
+    reader.read(_free);
+    const auto signatures = reader.template read<Signature>();
+    bool complete = true;
+    _size = 0;
+    for (const Signature& signature : signatures) {
+      // Each signature has to belong to a single chunk.
+      complete = _chunk_indices.emplace(signature, _chunks.size()).second && complete;
+      Chunk& chunk = _chunks.emplace_back(signature);
+      reader.read(chunk.entities);
+      ([&]() {
+        auto& vector = std::get<Vector<TStoredComponents>>(chunk.components);
+        reader.read(vector);
+        complete = complete && vector.size() == (signature[_component_index<TStoredComponents>] ? chunk.entities.size() : 0);
+      }(), ...);
+      // Each entity of the chunk has to be located at its row.
+      for (size_t row = 0; row < chunk.entities.size(); ++row) {
+        const Entity entity = chunk.entities[row];
+        complete = complete && entity < _locations.size() && _locations[entity].active
+          && _locations[entity].chunk == _chunks.size() - 1 && _locations[entity].row == row;
+      }
+      _size += chunk.entities.size();
+    }
+    if (!complete) throw std::runtime_error("Incomplete snapshot in " + path.string());
+  }
+
+private:
+  /// A chunk storing all entities of a single archetype (i.e., with the exact same signature).
+  struct Chunk {
+    /// The signature shared by all entities in this chunk.
+    Signature signature;
+
+    /// The entity handle of each row.
+    std::vector<Entity> entities;
+
+    /// The vectors storing component data, arranged in a tuple.
+    ///
+    /// Only the vectors of component types included in the signature are used.
+    /// All used vectors always have the same size, equal to the size of the entity vector.
+    std::tuple<Vector<TStoredComponents>...> components;
+
+    /// Cached transitions to other chunks.
+    ///
+    /// The element at a component index is the index of the chunk whose signature
+    /// differs from this one only in that component's bit.
+    std::array<size_t, sizeof...(TStoredComponents)> transitions;
+
+    /// Constructs an empty chunk for some signature.
+    Chunk(Signature signature) : signature(signature) {
+      transitions.fill(_none);
+    }
+  };
+
+  /// The location of an entity within the chunks.
+  struct EntityLocation {
+    /// The index of the chunk storing the entity.
+    size_t chunk = _none;
+    /// The row of the entity within that chunk.
+    size_t row = _none;
+    /// The entity's activeness. Inactive entities are reclaimed on refresh.
+    bool active = false;
+  };
+
+  /// The chunks of all archetypes encountered so far.
+  ///
+  /// Chunks are never removed, so that chunk indices stay valid.
+  std::vector<Chunk> _chunks;
+
+  /// The index of each chunk, keyed by its signature.
+  std::unordered_map<Signature, size_t> _chunk_indices;
+
+  /// The location of each entity, indexed by entity handle.
+  std::vector<EntityLocation> _locations;
+
+  /// Handles of reclaimed entities, available for reuse.
+  std::vector<Entity> _free;
+
+  /// Handles reclaimed by the last refresh, available for reuse after the next one.
+  std::vector<Entity> _released;
+
+  /// Handles of entities removed since the last refresh.
+  std::vector<Entity> _removed;
+
+  /// The number of active entities.
+  size_t _size = 0;
+
+  /// Appends multiple new entities with the same set of component types to their chunk.
+  ///
+  /// Entity handles and locations are assigned, but the component vectors of the chunk are not grown.
+  /// @tparam TComponents The component types to be attached to the new entities.
+  /// @param count The number of entities to be appended.
+  /// @returns The index of the chunk of the new entities, in which they are the last `count` rows.
+  template<typename... TComponents>
+  size_t append_entities(size_t count) {
+    const size_t index = find_chunk(signature_of<TComponents...>);
+    Chunk& chunk = _chunks[index];
+    // Reserve at least geometrically, so that repeated small batches do not reallocate every time.
+    auto reserve = [size = chunk.entities.size() + count](auto& vector) {
+      if (vector.capacity() < size) vector.reserve(std::max(size, 2 * vector.capacity()));
+    };
+    reserve(chunk.entities);
+    (reserve(std::get<Vector<TComponents>>(chunk.components)), ...);
+    for (size_t i = 0; i < count; ++i) {
+      // Reuse a previously freed entity handle or create a new one.
+      Entity entity;
+      if (!_free.empty()) {
+        entity = _free.back();
+        _free.pop_back();
+      } else {
+        entity = _locations.size();
+        _locations.emplace_back();
+      }
+      chunk.entities.push_back(entity);
+      _locations[entity] = EntityLocation{index, chunk.entities.size() - 1, true};
+    }
+    _size += count;
+    return index;
+  }
+
+  /// Creates and activates multiple new entities with components returned by a generator.
+  ///
+  /// @tparam parallel Whether to call the generator and assign the components concurrently.
+  /// @param count The number of entities to be created.
+  /// @param generator The callable returning the initial components of the `i`-th new entity as a `std::tuple`, given `i`.
+  template<bool parallel>
+  void generate_entities(size_t count, auto& generator) {
+    using Components = std::decay_t<decltype(generator(size_t{0}))>;
+    [&]<typename... TComponents>(std::tuple<TComponents...>*) {
+      Chunk& chunk = _chunks[append_entities<TComponents...>(count)];
+      const size_t begin = chunk.entities.size() - count;
+      (std::get<Vector<TComponents>>(chunk.components).resize(begin + count), ...);
+      // Assign the generated components of a single entity.
+      auto generate = [&](size_t i) {
+        std::apply([&](auto&&... components) {
+          ((std::get<Vector<TComponents>>(chunk.components)[begin + i] = std::move(components)), ...);
+        }, generator(i));
+      };
+      if constexpr (parallel) {
+        #pragma omp parallel for
+        for (size_t i = 0; i < count; ++i) generate(i);
+      } else {
+        for (size_t i = 0; i < count; ++i) generate(i);
+      }
+    }(static_cast<Components*>(nullptr));
+  }
+
+  /// Returns the index of the chunk with exactly some signature, creating it if necessary.
+  ///
+  /// @param signature The signature of the chunk.
+  size_t find_chunk(const Signature& signature) {
+    const auto [it, inserted] = _chunk_indices.try_emplace(signature, _chunks.size());
+    if (inserted) _chunks.emplace_back(signature);
+    return it->second;
+  }
+
+  /// Returns the index of the chunk whose signature differs in exactly one component bit from some other chunk.
+  ///
+  /// The result is cached in the originating chunk, so that repeated attaching and detaching does not search.
+  /// @param chunk The index of the originating chunk.
+  /// @param component_index The index of the component type to be toggled.
+  size_t transition(size_t chunk, size_t component_index) {
+    if (_chunks[chunk].transitions[component_index] == _none) {
+      Signature signature = _chunks[chunk].signature ^ (Signature(1) << component_index);
+      size_t target = find_chunk(signature);
+      // Chunk references may be invalidated by `find_chunk`, so index again.
+      _chunks[chunk].transitions[component_index] = target;
+      _chunks[target].transitions[component_index] = chunk;
+    }
+    return _chunks[chunk].transitions[component_index];
+  }
+
+  /// Moves an entity to another chunk.
+  ///
+  /// Component data of types contained in both chunks is moved over, components of types
+  /// only contained in the target chunk are default-constructed and all others are destroyed.
+  /// @param entity The entity to be moved.
+  /// @param target The index of the target chunk.
+  void move_entity(Entity entity, size_t target) {
+    EntityLocation& location = _locations[entity];
+    Chunk& from = _chunks[location.chunk];
+    Chunk& to = _chunks[target];
+    // Push the component data into the target chunk using a fold expression.
+    // The lambda is called for every stored component type.
+    ([&]() {
+      if (!to.signature[_component_index<TStoredComponents>]) return;
+      auto& to_vector = std::get<Vector<TStoredComponents>>(to.components);
+      if (from.signature[_component_index<TStoredComponents>])
+        to_vector.push_back(std::move(std::get<Vector<TStoredComponents>>(from.components)[location.row]));
+      else
+        to_vector.emplace_back();
+    }(), ...);
+    to.entities.push_back(entity);
+    // Remove the entity's row from the originating chunk.
+    erase_row(location.chunk, location.row);
+    location.chunk = target;
+    location.row = to.entities.size() - 1;
+  }
+
+  /// Removes a row from a chunk by moving the last row into its place.
+  ///
+  /// @param chunk The index of the chunk.
+  /// @param row The row to be removed.
+  void erase_row(size_t chunk, size_t row) {
+    Chunk& from = _chunks[chunk];
+    size_t last = from.entities.size() - 1;
+    ([&]() {
+      if (!from.signature[_component_index<TStoredComponents>]) return;
+      auto& vector = std::get<Vector<TStoredComponents>>(from.components);
+      if (row != last) vector[row] = std::move(vector[last]);
+      vector.pop_back();
+    }(), ...);
+    if (row != last) {
+      // Update the location of the entity moved into the vacated row.
+      from.entities[row] = from.entities[last];
+      _locations[from.entities[row]].row = row;
+    }
+    from.entities.pop_back();
+  }
+};
+
+namespace internal {
+
+  /// Archetype storage configuration class.
+  template<template<typename> typename TAllocator = std::allocator>
+  class ArchetypeCustom {
+  public:
+    /// The configured storage.
+    template<typename... TComponents>
+    using Storage = BasicArchetype<TAllocator, TComponents...>;
+
+    /// This class but with the component vectors allocated by another allocator (e.g., `AlignedAllocator`).
+    template<template<typename> typename TOtherAllocator>
+    using WithAllocator = ArchetypeCustom<TOtherAllocator>;
+  };
+
+}
+
+/// Archetype storage with custom options.
+///
+/// This avoids having to write `<>` after ArchetypeCustom when using.
+using ArchetypeCustom = internal::ArchetypeCustom<>;
+
+/// Archetype storage with default options.
+template<typename... TStoredComponents>
+using Archetype = BasicArchetype<std::allocator, TStoredComponents...>;
+
+}
@@ -44,6 +44,15 @@ public:
     return _registry.alive();
   }
 
+  /// Test whether or not a component of some type is attached to an entity.
+  ///
+  /// @param entity The entity to be queried.
+  /// @tparam TComponent The component type to be queried.
+  template<typename TComponent>
+  bool has_component(Entity entity) const {
+    return _registry.template try_get<TComponent>(entity) != nullptr;
+  }
+
   /// Returns a reference to a single component of some entity.
   ///
   /// @param entity The entity to be accessed.
@@ -92,14 +101,15 @@ public:
     _registry.remove<TComponent>(entity);
   }
 
-  // TODO: return entity?
   /// Creates a new entity.
   ///
   /// @param components The set of components to be initially associated with the new entity.
-  void new_entity(auto&&... components) {
+  /// @returns The handle of the new entity.
+  Entity new_entity(auto&&... components) {
     // Set the initial components from the parameters.
     Entity entity = _registry.create();
     set_components(entity, std::forward<decltype(components)>(components)...);
+    return entity;
   }
 
   /// Removes an entity from the storage.
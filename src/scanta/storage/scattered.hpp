@@ -6,7 +6,10 @@
 #include <unordered_set>
 #include <memory>
 #include <type_traits>
+#include <utility>
 
+#include "scanta/util/slab_pool.hpp"
+#include "scanta/util/handle_table.hpp"
 
 #include <boost/hana.hpp>
 namespace hana = boost::hana;
@@ -27,15 +30,29 @@ namespace scanta::storage {
     const bool smart_pointers = false;
     /// Whether to use a set or a vector for storing entity metadata.
     const bool entity_set = false;
+    /// Whether to allocate entity metadata and components from slab pools owned by the storage instead of the configured allocator.
+    const bool pools = false;
+    /// Whether to store entity metadata contiguously by value instead of behind individual pointers.
+    const bool contiguous_metadata = false;
 
     /// Copies the options but with smart pointers configured.
     consteval ScatteredOptions use_smart_pointers() const {
-      return ScatteredOptions{true, this->entity_set};
+      return ScatteredOptions{true, this->entity_set, this->pools, this->contiguous_metadata};
     }
 
     /// Copies the options but with entity set configured.
     consteval ScatteredOptions use_entity_set() const {
-      return ScatteredOptions{this->smart_pointers, true};
+      return ScatteredOptions{this->smart_pointers, true, this->pools, this->contiguous_metadata};
+    }
+
+    /// Copies the options but with slab pools configured.
+    consteval ScatteredOptions use_pools() const {
+      return ScatteredOptions{this->smart_pointers, this->entity_set, true, this->contiguous_metadata};
+    }
+
+    /// Copies the options but with contiguous entity metadata configured.
+    consteval ScatteredOptions use_contiguous_metadata() const {
+      return ScatteredOptions{this->smart_pointers, this->entity_set, this->pools, true};
     }
   } scattered_options;
 
@@ -47,7 +64,7 @@ namespace scanta::storage {
     template <bool smart_pointers>
     class EntityReference {
       // All other Scattered classes are friends, so they can access the void-pointer for casting.
-      template<ScatteredOptions, typename...>
+      template<ScatteredOptions, template<typename> typename, typename...>
       friend class Scattered;
 
       template<bool>
@@ -78,7 +95,7 @@ namespace scanta::storage {
     };
 
   /// Base declaration for partial specialization.
-  template<ScatteredOptions options, typename... TStoredComponents>
+  template<ScatteredOptions options, template<typename> typename TAllocator, typename... TStoredComponents>
   class Scattered;
 
   /// Partial specialization for the case of no stored components.
@@ -86,11 +103,19 @@ namespace scanta::storage {
   /// This is required because an entity handle type needs to be exposed
   /// to the scaffold before the list of stored components is known.
   /// @tparam options The scattered storage options to be used.
-  template<ScatteredOptions options>
-  class Scattered<options> {
+  /// @tparam TAllocator The allocator template allocating entity metadata and components.
+  template<ScatteredOptions options, template<typename> typename TAllocator>
+  class Scattered<options, TAllocator> {
   public:
+    static_assert(!(options.contiguous_metadata && options.entity_set), "Contiguous entity metadata cannot be stored in an entity set.");
 
-    using Entity = EntityReference<options.smart_pointers>;
+    /// With contiguous metadata, entities are referenced by generational handles resolving to their metadata index.
+    /// Otherwise, the metadata pointer is wrapped in a reference.
+    using Entity = std::conditional_t<
+      options.contiguous_metadata,
+      GenerationalHandle,
+      EntityReference<options.smart_pointers>
+    >;
 
     /// Executes a callable on each entity with all required components attached.
     ///
@@ -99,7 +124,7 @@ namespace scanta::storage {
     template<typename... TRequiredComponents>
     void for_entities_with(auto&& callable) const {
       if (sizeof...(TRequiredComponents) == 0)
-        callable(Entity(nullptr));
+        callable(Entity{});
     }
 
     /// Executes a callable on each entity with all required components attached.
@@ -109,18 +134,21 @@ namespace scanta::storage {
     template<typename... TRequiredComponents>
     void for_entities_with_parallel(auto&& callable) const {
       if (sizeof...(TRequiredComponents) == 0)
-        callable(Entity(nullptr));
+        callable(Entity{});
     }
 
-    void new_entity(auto&&...) const {}
+    Entity new_entity(auto&&...) const {
+      return Entity{};
+    }
   };
 
   /// Stores components and entity metadata in dynamically allocated and scattered heap regions.
   ///
   /// @tparam options The scattered storage options to be used.
+  /// @tparam TAllocator The allocator template allocating entity metadata and components, unless pools are configured.
   /// @tparam TStoredComponents The component types to be stored.
-  template<ScatteredOptions options, typename... TStoredComponents>
-  class Scattered : Scattered<options> {
+  template<ScatteredOptions options, template<typename> typename TAllocator, typename... TStoredComponents>
+  class Scattered : Scattered<options, TAllocator> {
   private:
     /// The list of stored component types as a hana::tuple_t.
     ///
@@ -135,6 +163,63 @@ namespace scanta::storage {
     /// When using smart pointers, a shared pointer is used, otherwise a regular pointer is used.
     template<typename T>
     using Pointer = typename std::conditional<options.smart_pointers, std::shared_ptr<T>, T*>::type;
+
+    /// Allocates and constructs an object, depending on the storage options.
+    ///
+    /// With pools configured, memory is taken from the storage's slab pools (including
+    /// the control block when using smart pointers). Otherwise, the configured allocator is used.
+    /// @tparam T The type of the object.
+    /// @param pools The slab pools of the storage, if configured.
+    /// @param arguments The constructor arguments.
+    template<typename T>
+    static Pointer<T> create([[maybe_unused]] const std::shared_ptr<SlabPools>& pools, auto&&... arguments) {
+      if constexpr (options.smart_pointers && options.pools)
+        return std::allocate_shared<T>(SlabAllocator<T>(pools), std::forward<decltype(arguments)>(arguments)...);
+      else if constexpr (options.smart_pointers)
+        return std::allocate_shared<T>(TAllocator<T>{}, std::forward<decltype(arguments)>(arguments)...);
+      else if constexpr (options.pools) {
+        SlabPool& pool = pools->template of<T>();
+        void* pointer = pool.allocate();
+        try {
+          return new (pointer) T(std::forward<decltype(arguments)>(arguments)...);
+        } catch (...) {
+          pool.deallocate(pointer);
+          throw;
+        }
+      } else {
+        TAllocator<T> allocator;
+        T* pointer = std::allocator_traits<TAllocator<T>>::allocate(allocator, 1);
+        try {
+          std::allocator_traits<TAllocator<T>>::construct(allocator, pointer, std::forward<decltype(arguments)>(arguments)...);
+        } catch (...) {
+          std::allocator_traits<TAllocator<T>>::deallocate(allocator, pointer, 1);
+          throw;
+        }
+        return pointer;
+      }
+    }
+
+    /// Destroys an object created by `create` and sets the pointer to null.
+    ///
+    /// When using smart pointers, the object is only destroyed once the last reference is released.
+    /// @param pointer The pointer to the object. May be null.
+    /// @param pools The slab pools the object has been created from, if configured and without smart pointers.
+    template<typename T>
+    static void destroy(Pointer<T>& pointer, [[maybe_unused]] SlabPools* pools) {
+      if constexpr (!options.smart_pointers && options.pools) {
+        if (pointer) {
+          pointer->~T();
+          pools->template of<T>().deallocate(pointer);
+        }
+      } else if constexpr (!options.smart_pointers) {
+        if (pointer) {
+          TAllocator<T> allocator;
+          std::allocator_traits<TAllocator<T>>::destroy(allocator, pointer);
+          std::allocator_traits<TAllocator<T>>::deallocate(allocator, pointer, 1);
+        }
+      }
+      pointer = nullptr;
+    }
   public:
     /// Entity metadata used by the storage internally.
     struct EntityMetadata {
@@ -143,41 +228,69 @@ namespace scanta::storage {
       /// When no component of a type is attached to the entity, that pointer is null.
       std::tuple<Pointer<TStoredComponents>...> components;
 
-      EntityMetadata& operator=(EntityMetadata&& other) {
-        components = std::move(other.components);
+      /// The handle of the entity, used to update its back-index when the metadata is moved.
+      /// Only stored with contiguous metadata.
+      [[no_unique_address]] std::conditional_t<options.contiguous_metadata, GenerationalHandle, std::tuple<>> handle;
+
+      /// The slab pools the components are created from, to which they are returned on deletion.
+      /// Only stored with pools and without smart pointers, whose components return themselves.
+      [[no_unique_address]] std::conditional_t<options.pools && !options.smart_pointers, SlabPools*, std::tuple<>> pools{};
+
+      EntityMetadata() = default;
+
+      /// Constructs metadata without components.
+      ///
+      /// @param pools The slab pools of the storage, if configured.
+      explicit EntityMetadata([[maybe_unused]] SlabPools* pools) {
+        if constexpr (options.pools && !options.smart_pointers) this->pools = pools;
+      }
+
+      /// Move constructor taking over the components of another entity, leaving it without components.
+      EntityMetadata(EntityMetadata&& other) noexcept
+        : components(std::exchange(other.components, {})), handle(other.handle), pools(other.pools) {}
+
+      /// Move assignment operator deleting all own components and taking over those of another entity.
+      EntityMetadata& operator=(EntityMetadata&& other) noexcept {
+        if (this != &other) {
+          clear_components();
+          components = std::exchange(other.components, {});
+          handle = other.handle;
+          pools = other.pools;
+        }
         return *this;
       }
 
       /// Destructor which deletes all components.
       ~EntityMetadata() {
-        if constexpr (!options.smart_pointers)
-          ((delete std::get<Pointer<std::decay_t<TStoredComponents>>>(components)), ...);
+        clear_components();
       }
 
       /// Deletes all components associated with this entity.
       void clear_components() {
-        // If regular pointers are used, memory needs to be freed first using `delete`.
-        if constexpr (!options.smart_pointers)
-          ((delete std::get<Pointer<std::decay_t<TStoredComponents>>>(components)), ...);
-        // Set all pointer to null using a fold-expression.
-        ((std::get<Pointer<std::decay_t<TStoredComponents>>>(components) = nullptr), ...);
+        // Free the memory of each component and set its pointer to null using a fold-expression.
+        SlabPools* component_pools = nullptr;
+        if constexpr (options.pools && !options.smart_pointers) component_pools = pools;
+        (destroy<TStoredComponents>(std::get<Pointer<TStoredComponents>>(components), component_pools), ...);
       }
     };
 
-    /// The entity handle type of the scattered storage.
+    /// The entity handle type of the scattered storage when metadata is referenced by pointers.
     ///
     /// This entity handle type encapsulates the entity metadata with respect to the stored component types.
     /// In system definitions the base storage handle type is used. Both handle types are implicitly convertible.
-    class Entity {
+    class MetadataReference {
     private:
       /// The underlying metadata pointer.
-      Pointer<EntityMetadata> _pointer;
+      Pointer<EntityMetadata> _pointer{};
     public:
+      /// Default constructor for a null handle.
+      MetadataReference() = default;
+
       /// Constructor for converting from plain pointers.
-      Entity(Pointer<EntityMetadata> pointer) : _pointer(pointer) {}
+      MetadataReference(Pointer<EntityMetadata> pointer) : _pointer(pointer) {}
 
       /// Constructor for converting from the base entity handle type (used in system definitions).
-      Entity(typename Scattered<options /* no stored component types */>::Entity other) {
+      MetadataReference(typename Scattered<options, TAllocator /* no stored component types */>::Entity other) {
         // Cast the void-pointer in the base handle to the appropriate handle from this storage.
         if constexpr (options.smart_pointers)
           _pointer = std::static_pointer_cast<EntityMetadata>(other._pointer);
@@ -186,12 +299,12 @@ namespace scanta::storage {
       }
 
       /// Conversion operator for converting to a base handle.
-      operator typename Scattered<options>::Entity() {
+      operator typename Scattered<options, TAllocator>::Entity() {
         // Construct a base handle from the metadata handle.
         if constexpr (options.smart_pointers)
-          return std::static_pointer_cast<Scattered<options>::Entity>(_pointer);
+          return typename Scattered<options, TAllocator>::Entity(std::static_pointer_cast<void>(_pointer));
         else
-          return static_cast<typename Scattered<options>::Entity>(_pointer);
+          return static_cast<typename Scattered<options, TAllocator>::Entity>(_pointer);
       }
 
       /// Conversion operator for converting to a plain pointer.
@@ -205,20 +318,47 @@ namespace scanta::storage {
       }
     };
 
+    /// The entity handle type of the scattered storage.
+    ///
+    /// With contiguous metadata, this is the same generational handle as the base handle type.
+    using Entity = std::conditional_t<
+      options.contiguous_metadata,
+      typename Scattered<options, TAllocator>::Entity,
+      MetadataReference
+    >;
+
     ~Scattered() {
-      // If smart pointers are not used, delete all entities.
-      if constexpr (!options.smart_pointers)
-        for (auto entity : _entities) delete entity;
+      // If smart pointers are not used, delete all entities. Contiguous metadata is destroyed with its vector.
+      if constexpr (!options.smart_pointers && !options.contiguous_metadata)
+        for (Pointer<EntityMetadata> entity : _entities) destroy<EntityMetadata>(entity, _pools.get());
+    }
+
+    /// Test whether or not an entity is stored, i.e., it has not been removed.
+    ///
+    /// With contiguous metadata, handles of removed entities stay invalid when their slot is reused.
+    /// Otherwise, the entity's metadata pointer is looked up, which is O(N) unless stored in an entity set,
+    /// and a removed entity is indistinguishable from a new one created at the same address.
+    /// @param entity The entity to be queried.
+    bool has_entity(Entity entity) const {
+      if constexpr (options.contiguous_metadata)
+        return _handles.is_valid(entity);
+      else if constexpr (options.entity_set)
+        return _entities.contains(entity);
+      else
+        return std::find(_entities.begin(), _entities.end(), static_cast<Pointer<EntityMetadata>>(entity)) != _entities.end();
     }
 
     /// Test whether or not a component of some type is attached to an entity.
     ///
+    /// With contiguous metadata, this is false for removed entities.
     /// @param entity The entity to be queried.
     /// @tparam TComponent The component type to be queried.
     template<typename TComponent>
     bool has_component(Entity entity) const {
       // TODO: static_assert component type handled
-      return std::get<Pointer<TComponent>>(entity->components);
+      if constexpr (options.contiguous_metadata)
+        if (!has_entity(entity)) return false;
+      return std::get<Pointer<TComponent>>(metadata_of(entity).components) != nullptr;
     }
 
     /// Returns a reference to a single component of some entity.
@@ -230,7 +370,7 @@ namespace scanta::storage {
     TComponent& get_component(Entity entity) {
       // TODO: static_assert component type handled
       // Fetch the component pointer from the entity metadata tuple and dereference it.
-      return *std::get<Pointer<TComponent>>(entity->components);
+      return *std::get<Pointer<TComponent>>(metadata_of(entity).components);
     }
 
     /// Returns the number of active entities currently stored.
@@ -249,13 +389,13 @@ namespace scanta::storage {
     template<typename TComponent>
     void attach_component(Entity entity, TComponent&& component) {
       // TODO: static_assert component type stored
-      // Copy component from parameter.
-      if constexpr (options.smart_pointers)
-        // Use make_shared to create a shared smart pointer.
-        std::get<Pointer<std::decay_t<TComponent>>>(entity->components) = std::make_shared<TComponent>(std::forward<TComponent>(component));
+      auto& pointer = std::get<Pointer<std::decay_t<TComponent>>>(metadata_of(entity).components);
+      if (pointer)
+        // Reuse the memory of an already attached component.
+        *pointer = std::forward<TComponent>(component);
       else
-        // Use `new` to directly allocate memory for the component.
-        std::get<Pointer<std::decay_t<TComponent>>>(entity->components) = new TComponent(std::forward<TComponent>(component));
+        // Copy component from parameter into newly allocated memory.
+        pointer = create<std::decay_t<TComponent>>(_pools, std::forward<TComponent>(component));
     }
 
     /// Sets the component data for some entity.
@@ -270,7 +410,7 @@ namespace scanta::storage {
     void set_components(Entity entity, TComponents&&... components) {
       // TODO: static_assert component type handled
       // Remove all components from the entity.
-      entity->clear_components();
+      metadata_of(entity).clear_components();
 
       // The component rvalue parameter-pack is unpacked using a fold-expression.
       (
@@ -289,58 +429,76 @@ namespace scanta::storage {
     template<typename TComponent>
     void detach_component(Entity entity) {
       // TODO: static_assert component type stored
-      // If regular pointers are used, memory needs to be freed first using `delete`.
-      if constexpr (!options.smart_pointers)
-        (delete std::get<Pointer<std::decay_t<TComponent>>>(entity->components));
-      // Set the component pointer to null, indicating that the component is detached.
-      (std::get<Pointer<std::decay_t<TComponent>>>(entity->components) = nullptr);
+      // Free the component memory and set the pointer to null, indicating that the component is detached.
+      destroy<std::decay_t<TComponent>>(std::get<Pointer<std::decay_t<TComponent>>>(metadata_of(entity).components), _pools.get());
     }
 
-    // TODO: return entity?
     /// Create a new entity.
     ///
-    /// Allocates new memory for the entity metadata.
+    /// Allocates new memory for the entity metadata, unless it is stored contiguously.
     /// @param components The set of components to be initially associated with the new entity.
-    void new_entity(auto&&... components) {
-      // Pointer to the new entity metadata.
-      Pointer<EntityMetadata> entity_data;
-      // Construct either shared or plain.
-      if constexpr (options.smart_pointers)
-        entity_data = std::make_shared<EntityMetadata>();
-      else
-        entity_data = new EntityMetadata();
-      if constexpr (!options.entity_set) {
-        // Add the new metadata pointer to the entity vector. This is O(1).
-        _entities.push_back(entity_data);
+    /// @returns The handle of the new entity.
+    Entity new_entity(auto&&... components) {
+      if constexpr (options.contiguous_metadata) {
+        // Append the new metadata to the entity vector and register its index in the handle table. This is O(1).
+        EntityMetadata& entity_data = _entities.emplace_back(_pools.get());
+        entity_data.handle = _handles.create(_entities.size() - 1);
+        set_components(entity_data.handle, std::forward<decltype(components)>(components)...);
+        return entity_data.handle;
       } else {
-        // Add the new metadata pointer to the entity set. This is worst-case O(N).
-        _entities.insert(entity_data);
+        // Pointer to the new entity metadata, constructed either shared or plain.
+        Pointer<EntityMetadata> entity_data = create<EntityMetadata>(_pools, _pools.get());
+        if constexpr (!options.entity_set) {
+          // Add the new metadata pointer to the entity vector. This is O(1).
+          _entities.push_back(entity_data);
+        } else {
+          // Add the new metadata pointer to the entity set. This is worst-case O(N).
+          _entities.insert(entity_data);
+        }
+        // Set initial components by forwarding them (retaining references without copy).
+        set_components(entity_data, std::forward<decltype(components)>(components)...);
+        return entity_data;
       }
-      // Set initial components by forwarding them (retaining references without copy).
-      set_components(entity_data, std::forward<decltype(components)>(components)...);
     }
 
     /// Removes an entity from the storage.
     ///
     /// Frees any memory for the entity metadata and associated components.
     void remove_entity(Entity entity) {
-      if constexpr (!options.entity_set) {
-        // Find the entity in the vector of pointers. This is O(N).
-        auto it = std::find(_entities.begin(), _entities.end(), static_cast<Pointer<EntityMetadata>>(entity));
-        // If the entity has been found (/ is stored).
-        if (it != _entities.end()) {
-          // Remove it from the entity vector.
-          if (it < _entities.end() - 1)
-            *it = std::move(_entities.back());
-          _entities.pop_back();
+      if constexpr (options.contiguous_metadata) {
+        // Ignore repeated removals of the same entity.
+        if (!_handles.is_valid(entity)) return;
+        // Look up the entity's index in the handle table. This is O(1).
+        size_t index = _handles.index_of(entity);
+        if (index < _entities.size() - 1) {
+          // Move the last entity into the gap, deleting the removed entity's components, and update its index.
+          _entities[index] = std::move(_entities.back());
+          _handles.relocate(_entities[index].handle, index);
         }
-        // TODO: else: entity not found
+        // Destroy the metadata at the back. This deletes the components still attached to it.
+        _entities.pop_back();
+        // Invalidate the handle of the removed entity.
+        _handles.release(entity);
       } else {
-        // Remove the entity from the map. This is on average O(1).
-        _entities.erase(entity);
+        if constexpr (!options.entity_set) {
+          // Find the entity in the vector of pointers. This is O(N).
+          auto it = std::find(_entities.begin(), _entities.end(), static_cast<Pointer<EntityMetadata>>(entity));
+          // If the entity has been found (/ is stored).
+          if (it != _entities.end()) {
+            // Remove it from the entity vector.
+            if (it < _entities.end() - 1)
+              *it = std::move(_entities.back());
+            _entities.pop_back();
+          }
+          // TODO: else: entity not found
+        } else {
+          // Remove the entity from the map. This is on average O(1).
+          _entities.erase(entity);
+        }
+        // Delete the entity. This also deletes all components.
+        Pointer<EntityMetadata> entity_data = entity;
+        destroy<EntityMetadata>(entity_data, _pools.get());
       }
-      // Delete the entity. This also deletes all components.
-      if constexpr (!options.smart_pointers) delete entity;
     }
 
     /// Executes a callable on each entity with all required components attached.
@@ -352,17 +510,24 @@ namespace scanta::storage {
       /// If the list of required component types is empty, the callable is called exactly once.
       if constexpr (sizeof...(TRequiredComponents) > 0) {
         // TODO: static_assert component types handled
-        // Iterate all stored entities.
-        for (Pointer<EntityMetadata> entity_data : _entities) {
-          // Check the entity signature by seeing if all required component pointers are non-null.
-          // This is done using a fold-expression with the boolean AND operator. Since any non-null pointer
-          // is truthy and null-pointers are falsey, this is equivalent to a signature match.
-          if ((... && std::get<Pointer<TRequiredComponents>>(entity_data->components)))
-            // Cast the entity handle to the base handle type for systems to process them.
-            callable(static_cast<typename Scattered<options>::Entity>(entity_data));
+        if constexpr (options.contiguous_metadata) {
+          // Iterate the entity metadata in place, skipping the metadata pointer indirection.
+          for (const EntityMetadata& entity_data : _entities)
+            if ((... && std::get<Pointer<TRequiredComponents>>(entity_data.components)))
+              callable(entity_data.handle);
+        } else {
+          // Iterate all stored entities.
+          for (Pointer<EntityMetadata> entity_data : _entities) {
+            // Check the entity signature by seeing if all required component pointers are non-null.
+            // This is done using a fold-expression with the boolean AND operator. Since any non-null pointer
+            // is truthy and null-pointers are falsey, this is equivalent to a signature match.
+            if ((... && std::get<Pointer<TRequiredComponents>>(entity_data->components)))
+              // Cast the entity handle to the base handle type for systems to process them.
+              callable(static_cast<typename Scattered<options, TAllocator>::Entity>(entity_data));
+          }
         }
         // Single-fire systems get a null-pointer as the entity handle.
-      } else callable(typename Scattered<options>::Entity(nullptr)); // TODO: move check to scheduler to avoid 0-reservation
+      } else callable(typename Scattered<options, TAllocator>::Entity{}); // TODO: move check to scheduler to avoid 0-reservation
     }
 
     /// Executes a callable on each entity with all required components attached.
@@ -376,7 +541,15 @@ namespace scanta::storage {
       if constexpr (sizeof...(TRequiredComponents) > 0) {
         // TODO: static_assert component types handled
         // Iterate all stored entities.
-        if constexpr (!options.entity_set) {
+        if constexpr (options.contiguous_metadata) {
+          // Iterate the entity metadata in place, skipping the metadata pointer indirection.
+          #pragma omp parallel for
+          for (size_t index = 0; index < _entities.size(); ++index) {
+            const EntityMetadata& entity_data = _entities[index];
+            if ((... && std::get<Pointer<TRequiredComponents>>(entity_data.components)))
+              callable(entity_data.handle);
+          }
+        } else if constexpr (!options.entity_set) {
           #pragma omp parallel for
           for (Pointer<EntityMetadata> entity_data : _entities) {
             // Check the entity signature by seeing if all required component pointers are non-null.
@@ -384,7 +557,7 @@ namespace scanta::storage {
             // is truthy and null-pointers are falsey, this is equivalent to a signature match.
             if ((... && std::get<Pointer<TRequiredComponents>>(entity_data->components)))
               // Cast the entity handle to the base handle type for systems to process them.
-              callable(static_cast<typename Scattered<options>::Entity>(entity_data));
+              callable(static_cast<typename Scattered<options, TAllocator>::Entity>(entity_data));
           }
         } else {
           // Iterate all buckets in the set in parallel.
@@ -398,37 +571,80 @@ namespace scanta::storage {
               // is truthy and null-pointers are falsey, this is equivalent to a signature match.
               if ((... && std::get<Pointer<TRequiredComponents>>(entity->components)))
                 // Cast the entity handle to the base handle type for systems to process them.
-                callable(static_cast<typename Scattered<options>::Entity>(entity));
+                callable(static_cast<typename Scattered<options, TAllocator>::Entity>(entity));
             }
           }
         }
         // Single-fire systems get a null-pointer as the entity handle.
-      } else callable(typename Scattered<options>::Entity(nullptr)); // TODO: move check to scheduler to avoid 0-reservation
+      } else callable(typename Scattered<options, TAllocator>::Entity{}); // TODO: move check to scheduler to avoid 0-reservation
     }
 
   private:
+    /// The slab pools entity metadata and components are created from, if configured.
+    ///
+    /// Declared before the entities, so that it is destroyed after them. With smart pointers, the pools
+    /// are shared with every object created from them and thus released once the last object is.
+    std::shared_ptr<SlabPools> _pools = options.pools ? std::make_shared<SlabPools>() : nullptr;
+
     /// Entity metadata storage.
     ///
-    /// Depending on the storage options `entity_set`, either a vector or a set of pointers.
+    /// Depending on the storage options `entity_set` and `contiguous_metadata`,
+    /// either a vector or a set of pointers, or a vector of the metadata itself.
     std::conditional<
-      options.entity_set,
-      std::unordered_set<Pointer<EntityMetadata>>,
-      std::vector<Pointer<EntityMetadata>>
+      options.contiguous_metadata,
+      std::vector<EntityMetadata, TAllocator<EntityMetadata>>,
+      typename std::conditional<
+        options.entity_set,
+        std::unordered_set<Pointer<EntityMetadata>>,
+        std::vector<Pointer<EntityMetadata>>
+      >::type
     >::type _entities;
+
+    /// Back-index from entity handles to their index in the contiguous entity metadata vector.
+    ///
+    /// Only used with contiguous metadata.
+    HandleTable _handles;
+
+    /// Returns the metadata of an entity.
+    ///
+    /// @param entity The entity to be accessed.
+    EntityMetadata& metadata_of(Entity entity) {
+      if constexpr (options.contiguous_metadata)
+        return _entities[_handles.index_of(entity)];
+      else
+        return *static_cast<Pointer<EntityMetadata>>(entity);
+    }
+
+    /// Returns the metadata of an entity.
+    ///
+    /// @param entity The entity to be accessed.
+    const EntityMetadata& metadata_of(Entity entity) const {
+      if constexpr (options.contiguous_metadata)
+        return _entities[_handles.index_of(entity)];
+      else
+        return *static_cast<Pointer<EntityMetadata>>(entity);
+    }
   };
 
   /// Scattered storage configuration class.
-  template<ScatteredOptions options = scattered_options>
+  template<ScatteredOptions options = scattered_options, template<typename> typename TAllocator = std::allocator>
   class ScatteredCustom {
   public:
     /// The configured storage.
     template<typename... TComponents>
-    using Storage = internal::Scattered<options, TComponents...>;
+    using Storage = internal::Scattered<options, TAllocator, TComponents...>;
 
     /// This class but with smart pointers configured.
-    using WithSmartPointers = ScatteredCustom<options.use_smart_pointers()>;
+    using WithSmartPointers = ScatteredCustom<options.use_smart_pointers(), TAllocator>;
     /// This class but with entity set configured.
-    using WithEntitySet = ScatteredCustom<options.use_entity_set()>;
+    using WithEntitySet = ScatteredCustom<options.use_entity_set(), TAllocator>;
+    /// This class but with slab pools configured.
+    using WithPools = ScatteredCustom<options.use_pools(), TAllocator>;
+    /// This class but with contiguous entity metadata configured.
+    using WithContiguousMetadata = ScatteredCustom<options.use_contiguous_metadata(), TAllocator>;
+    /// This class but with another allocator (e.g., `AlignedAllocator`) configured. Slab pools take precedence over it.
+    template<template<typename> typename TOtherAllocator>
+    using WithAllocator = ScatteredCustom<options, TOtherAllocator>;
   };
 
   }
@@ -440,7 +656,7 @@ using ScatteredCustom = internal::ScatteredCustom<>;
 
 /// Scattered storage with default options.
 template<typename... TComponents>
-using Scattered = internal::Scattered<internal::scattered_options, TComponents...>;
+using Scattered = internal::Scattered<internal::scattered_options, std::allocator, TComponents...>;
 
 }
 
@@ -0,0 +1,389 @@
+#pragma once
+
+#include <iostream>
+#include <tuple>
+#include <vector>
+#include <memory>
+#include <cassert>
+#include <algorithm>
+#include <cstdint>
+#include <filesystem>
+#include <stdexcept>
+
+#include <boost/hana.hpp>
+namespace hana = boost::hana;
+using namespace hana::literals;
+
+#include "scanta/util/type_index.hpp"
+#include "scanta/util/snapshot.hpp"
+
+namespace scanta::storage {
+
+/// Stores components in one sparse set per component type.
+///
+/// Each sparse set (_pool_) keeps its components packed in a dense vector alongside
+/// the owning entity handles, plus a sparse index from entity handle to dense position.
+/// Attaching and detaching components is O(1) and iteration is driven by the
+/// smallest pool among the required component types.
+///
+/// @tparam TAllocator The allocator template allocating the packed component vectors (see `allocator.hpp`).
+/// @tparam TStoredComponents The component types to be stored.
+template<template<typename> typename TAllocator, typename... TStoredComponents>
+class BasicSparseSet {
+private:
+  /// The list of stored component types as a hana::tuple_t.
+  ///
+  /// This allows handling the type list as a value instead of a template parameter pack,
+  /// making it iterable and mutable with boost::hana functions.
+  static constexpr auto _component_types = hana::tuple_t<TStoredComponents...>;
+
+  /// Marker for sparse index entries of entities without a component in a pool.
+  static constexpr size_t _none = SIZE_MAX;
+public:
+  /// The handle type for systems to reference entities with.
+  using Entity = size_t;
+
+  /// Constructs a storage with no components initially stored.
+  ///
+  /// @param capacity The initial entity capacity for which to allocate memory for.
+  BasicSparseSet(size_t capacity = 32) {
+    _active.reserve(capacity);
+  }
+
+  /// Returns the number of active entities currently stored.
+  ///
+  /// @returns The number of active entities currently stored.
+  size_t get_size() {
+    return _size;
+  }
+
+  /// Test whether or not a component of some type is attached to an entity.
+  ///
+  /// @param entity The entity to be queried.
+  /// @tparam TComponent The component type to be queried.
+  template<typename TComponent>
+  bool has_component(Entity entity) const {
+    // TODO: static_assert component type handled
+    return pool<TComponent>().contains(entity);
+  }
+
+  /// Returns a reference to a single component of some entity.
+  ///
+  /// @param entity The entity to be accessed.
+  /// @tparam TComponent The component type to be queried.
+  template<typename TComponent>
+  TComponent& get_component(Entity entity) {
+    // TODO: static_assert component type handled
+    auto& component_pool = pool<TComponent>();
+    return component_pool.data[component_pool.sparse[entity]];
+  }
+
+  /// Sets the component data for a single component of some entity.
+  ///
+  /// All other components attached to this entity remain attached and unchanged.
+  /// @param entity The entity to which to attach the component.
+  /// @param component The component data to be assigned.
+  template<typename TComponent>
+  void attach_component(Entity entity, TComponent&& component) {
+    // TODO: static_assert component type stored
+    auto& component_pool = pool<std::decay_t<TComponent>>();
+    if (component_pool.contains(entity))
+      component_pool.data[component_pool.sparse[entity]] = std::forward<TComponent>(component);
+    else
+      component_pool.insert(entity, std::forward<TComponent>(component));
+  }
+
+  /// Sets the component data for some entity.
+  ///
+  /// Any components previously attached to the entity and not passed in again are detached.
+  /// The passed in components make up the new complete set of components attached to that entity.
+  /// @param entity The entity for which to set the components.
+  /// @param components The components to be assigned.
+  template<typename... TComponents>
+  void set_components(Entity entity, TComponents&&... components) {
+    // TODO: static_assert component type stored
+    // Detach all components not passed in using a fold expression.
+    ([&]() {
+      if constexpr (!types_contain<TStoredComponents, std::decay_t<TComponents>...>)
+        pool<TStoredComponents>().erase(entity);
+    }(), ...);
+    // Set all passed in components using a fold expression.
+    (attach_component(entity, std::forward<TComponents>(components)), ...);
+  }
+
+  /// Detaches a component from an entity.
+  ///
+  /// This removes the component from its pool by moving the last component of the pool into its place.
+  /// This operation is idempotent.
+  ///
+  /// @tparam TComponent The type of the component to be detached.
+  /// @param entity The entity to be detached from.
+  template<typename TComponent>
+  void detach_component(Entity entity) {
+    // TODO: static_assert component type stored
+    pool<std::decay_t<TComponent>>().erase(entity);
+  }
+
+  /// Creates and activates a new entity.
+  ///
+  /// @param components The set of components to be initially associated with the new entity.
+  /// @returns The handle of the new entity.
+  template<typename... TComponents>
+  Entity new_entity(TComponents&&... components) {
+    // Reuse a previously freed entity handle or create a new one.
+    Entity entity;
+    if (!_free.empty()) {
+      entity = _free.back();
+      _free.pop_back();
+      _active[entity] = true;
+    } else {
+      entity = _active.size();
+      _active.push_back(true);
+    }
+    // Insert the initial components into their pools.
+    (pool<std::decay_t<TComponents>>().insert(entity, std::forward<TComponents>(components)), ...);
+    ++_size;
+    return entity;
+  }
+
+  /// Removes an entity from the storage.
+  ///
+  /// This merely sets the entity as inactive. Refreshing will later remove its components and reclaim its handle.
+  void remove_entity(Entity entity) {
+    // Ignore repeated removals of the same entity.
+    if (!_active[entity]) return;
+    // Set the entity as inactive.
+    _active[entity] = false;
+    // Queue the entity for being reclaimed.
+    _removed.push_back(entity);
+    --_size;
+  }
+
+  /// Executes a callable on each entity with all required components attached.
+  ///
+  /// The dense entity vector of the smallest required pool is iterated and
+  /// each of its entities is tested for membership in the other required pools.
+  /// @tparam TRequiredComponents The set of component types required to be attached to an entity to be processed.
+  /// @param callable The callable to be executed with each matched entity's handle as an argument.
+  template<typename... TRequiredComponents>
+  void for_entities_with(auto&& callable) const {
+    /// If the list of required component types is empty, the callable is called exactly once.
+    if constexpr (sizeof...(TRequiredComponents) > 0) {
+      // TODO: static_assert component types handled
+      const std::vector<Entity>& entities = smallest_pool<TRequiredComponents...>();
+      for (Entity entity : entities) {
+        // Test membership in all required pools using a fold expression.
+        if ((pool<TRequiredComponents>().contains(entity) && ...))
+          callable(Entity{entity});
+      }
+    } else callable(Entity{SIZE_MAX}); // TODO: move check to scheduler to avoid -1-reservation (and also execute if ECS::Entity is required)
+  }
+
+  /// Executes a callable on each entity with all required components attached.
+  /// Employs inner parallelism.
+  ///
+  /// The dense entity vector of the smallest required pool is iterated and
+  /// each of its entities is tested for membership in the other required pools.
+  /// @tparam TRequiredComponents The set of component types required to be attached to an entity to be processed.
+  /// @param callable The callable to be executed with each matched entity's handle as an argument.
+  // TODO: parametrize parallelization
+  template<typename... TRequiredComponents>
+  void for_entities_with_parallel(auto&& callable) const {
+    if constexpr (sizeof...(TRequiredComponents) > 0) {
+      // TODO: static_assert component types handled
+      const std::vector<Entity>& entities = smallest_pool<TRequiredComponents...>();
+      #pragma omp parallel for
+      for (size_t i = 0; i < entities.size(); ++i) {
+        if ((pool<TRequiredComponents>().contains(entities[i]) && ...))
+          callable(Entity{entities[i]});
+      }
+    } else callable(Entity{SIZE_MAX}); // TODO: move check to scheduler
+  }
+
+  /// Refreshes the storage to remove the components of removed entities and reclaim their handles.
+  ///
+  /// Handles are only made available for reuse by the refresh after the one reclaiming them. Observers of the frame
+  /// in between may thus be passed the removal of a handle (e.g., by an operation deferred by an observer), which is
+  /// not reused by an entity created in the same frame.
+  auto refresh() {
+    // The handles reclaimed by the last refresh have been passed to the observers of their removal by now.
+    _free.insert(_free.end(), _released.begin(), _released.end());
+    _released.clear();
+    for (Entity entity : _removed) {
+      // Remove the entity from every pool using a fold expression.
+      (pool<TStoredComponents>().erase(entity), ...);
+      // Make the handle available for reuse after the next refresh.
+      _released.push_back(entity);
+    }
+    _removed.clear();
+  }
+
+  /// Captures a consistent copy of the storage, to be written to a file off the frame thread.
+  ///
+  /// The storage is refreshed first. Each pool is captured as its dense entity handles and components,
+  /// the latter with a single bulk copy if trivially copyable. Sparse indices are not captured, but rebuilt on restore.
+  /// @param snapshot A snapshot written before, whose memory is reused (see `SnapshotWriter::recycle`).
+  /// @returns The snapshot, to be written by `Snapshot::write` or a `SnapshotWriter`.
+  Snapshot snapshot(Snapshot snapshot = {}) requires (is_serializable<TStoredComponents> && ...) {
+    refresh();
+    snapshot.clear();
+    // The activeness is packed into bits, so it is captured as bytes.
+    snapshot.capture(std::vector<uint8_t>(_active.begin(), _active.end()));
+    // The handles held back from reuse are free as well.
+    std::vector<Entity> free = _free;
+    free.insert(free.end(), _released.begin(), _released.end());
+    snapshot.capture(free);
+    ([&]() {
+      snapshot.capture(pool<TStoredComponents>().dense);
+      snapshot.capture(pool<TStoredComponents>().data);
+    }(), ...);
+    return snapshot;
+  }
+
+  /// Replaces all entities by the ones captured in a snapshot file.
+  ///
+  /// Handles of the captured entities are valid again afterwards.
+  /// @param path The path of the snapshot file, captured from a storage of the same component types.
+  /// @throws std::runtime_error when the file does not hold a snapshot of such a storage, in which case the storage
+  /// is left in an unspecified state.
+  void restore(const std::filesystem::path& path) requires (is_serializable<TStoredComponents> && ...) {
+    SnapshotReader reader(path);
+    _removed.clear();
+    _released.clear();
+    const auto active = reader.template read<uint8_t>();
+    _active.assign(active.begin(), active.end());
+    reader.read(_free);
+    _size = std::count(_active.begin(), _active.end(), true);
+    bool complete = true;
+    ([&]() {
+      auto& pool = this->pool<TStoredComponents>();
+      reader.read(pool.dense);
+      reader.read(pool.data);
+      complete = complete && pool.data.size() == pool.dense.size();
+      // Rebuild the sparse index from the dense entity handles.
+      pool.sparse.assign(_active.size(), _none);
+      for (size_t position = 0; position < pool.dense.size(); ++position) {
+        const Entity entity = pool.dense[position];
+        complete = complete && entity < _active.size() && _active[entity] && pool.sparse[entity] == _none;
+        if (complete) pool.sparse[entity] = position;
+      }
+    }(), ...);
+    if (!complete) throw std::runtime_error("Incomplete snapshot in " + path.string());
+  }
+
+private:
+  /// A sparse set storing all components of a single type.
+  ///
+  /// @tparam TComponent The component type stored.
+  template<typename TComponent>
+  struct Pool {
+    /// The dense position of each entity's component, indexed by entity handle.
+    ///
+    /// Entities without a component in this pool map to `_none`.
+    std::vector<size_t> sparse;
+
+    /// The owning entity of each component, packed densely.
+    std::vector<Entity> dense;
+
+    /// The component data, packed densely in the same order as `dense`.
+    std::vector<TComponent, TAllocator<TComponent>> data;
+
+    /// Whether an entity has a component in this pool.
+    bool contains(Entity entity) const {
+      return entity < sparse.size() && sparse[entity] != _none;
+    }
+
+    /// Inserts a component for an entity not yet contained in the pool.
+    void insert(Entity entity, auto&& component) {
+      assert(!contains(entity));
+      if (entity >= sparse.size()) sparse.resize(entity + 1, _none);
+      sparse[entity] = dense.size();
+      dense.push_back(entity);
+      data.push_back(std::forward<decltype(component)>(component));
+    }
+
+    /// Removes the component of an entity by moving the last component into its place.
+    ///
+    /// This operation is idempotent.
+    void erase(Entity entity) {
+      if (!contains(entity)) return;
+      size_t position = sparse[entity];
+      if (position != dense.size() - 1) {
+        dense[position] = dense.back();
+        data[position] = std::move(data.back());
+        sparse[dense[position]] = position;
+      }
+      dense.pop_back();
+      data.pop_back();
+      sparse[entity] = _none;
+    }
+  };
+
+  /// The pools storing component data, arranged in a tuple.
+  std::tuple<Pool<TStoredComponents>...> _pools;
+
+  /// The activeness of each entity, indexed by entity handle.
+  std::vector<bool> _active;
+
+  /// Handles of reclaimed entities, available for reuse.
+  std::vector<Entity> _free;
+
+  /// Handles reclaimed by the last refresh, available for reuse after the next one.
+  std::vector<Entity> _released;
+
+  /// Handles of entities removed since the last refresh.
+  std::vector<Entity> _removed;
+
+  /// The number of active entities.
+  size_t _size = 0;
+
+  /// Returns the pool of some component type.
+  template<typename TComponent>
+  Pool<TComponent>& pool() {
+    return std::get<Pool<TComponent>>(_pools);
+  }
+
+  /// Returns the pool of some component type.
+  template<typename TComponent>
+  const Pool<TComponent>& pool() const {
+    return std::get<Pool<TComponent>>(_pools);
+  }
+
+  /// Returns the dense entity vector of the pool with the fewest components among some component types.
+  ///
+  /// @tparam TRequiredComponents The component types to be compared.
+  template<typename TRequiredComponent, typename... TRequiredComponents>
+  const std::vector<Entity>& smallest_pool() const {
+    const std::vector<Entity>* smallest = &pool<TRequiredComponent>().dense;
+    ((pool<TRequiredComponents>().dense.size() < smallest->size() ? smallest = &pool<TRequiredComponents>().dense : smallest), ...);
+    return *smallest;
+  }
+};
+
+namespace internal {
+
+  /// Sparse set storage configuration class.
+  template<template<typename> typename TAllocator = std::allocator>
+  class SparseSetCustom {
+  public:
+    /// The configured storage.
+    template<typename... TComponents>
+    using Storage = BasicSparseSet<TAllocator, TComponents...>;
+
+    /// This class but with the packed component vectors allocated by another allocator (e.g., `AlignedAllocator`).
+    template<template<typename> typename TOtherAllocator>
+    using WithAllocator = SparseSetCustom<TOtherAllocator>;
+  };
+
+}
+
+/// Sparse set storage with custom options.
+///
+/// This avoids having to write `<>` after SparseSetCustom when using.
+using SparseSetCustom = internal::SparseSetCustom<>;
+
+/// Sparse set storage with default options.
+template<typename... TStoredComponents>
+using SparseSet = BasicSparseSet<std::allocator, TStoredComponents...>;
+
+}
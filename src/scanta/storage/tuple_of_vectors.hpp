@@ -1,9 +1,22 @@
 #pragma once
 
 #include <iostream>
+#include <array>
 #include <tuple>
 #include <vector>
+#include <algorithm>
+#include <cstdint>
 #include <cassert>
+#include <cstring>
+#include <filesystem>
+#include <iterator>
+#include <memory>
+#include <ranges>
+#include <span>
+#include <stdexcept>
+#include <string>
+#include <type_traits>
+#include <utility>
 
 #include <bitset2/bitset2.hpp>
 
@@ -12,34 +25,107 @@ namespace hana = boost::hana;
 using namespace hana::literals;
 
 #include "scanta/util/type_index.hpp"
+#include "scanta/util/handle_table.hpp"
+#include "scanta/util/signature_column.hpp"
+#include "scanta/util/group.hpp"
+#include "scanta/util/aosoa.hpp"
+#include "scanta/util/tag.hpp"
+#include "scanta/util/sparse_column.hpp"
+#include "scanta/util/vector_options.hpp"
+#include "scanta/util/mapped_vector.hpp"
+#include "scanta/util/snapshot.hpp"
+#include "scanta/util/change_filter.hpp"
+#include "scanta/util/query.hpp"
 
 namespace scanta::storage {
 
 /// Stores components in multiple equally-sized vectors.
 ///
 /// For each stored component type there is exactly one vector.
+/// Component types may also be bundled into a `Group`, whose members share a single vector of tuples
+/// (making this a _tuple of vectors of tuples_).
+/// Component types declaring an `aosoa_scalar` in their `component_traits` are stored in AoSoA blocks instead,
+/// which systems can take as `Block` parameters to process `block_lanes` entities at once.
+/// Tag component types (empty types) are stored as signature bits only.
+/// Component types declaring a sparse or boxed `Layout` in their `component_traits` are stored in a sparse set
+/// or individually allocated respectively, in which case only attached components take up (significant) memory.
+/// Iterations requiring a sparse component type only visit the entities of the smallest required sparse set.
+/// Component types stored in separate vectors can be passed to systems as `std::span`s over runs of consecutive matching entities.
+/// Double-buffered component types stored in separate vectors keep a copy of the previous frame's components for readers.
+/// The changes of component types can be tracked per entity, so that systems can filter entities by them (see `ChangeFilter`).
 /// All vectors are always of equal size, and always at least as long as the number of entities stored.
+/// Unless configured to reuse the slots of removed entities (see `VectorOptions`), the vectors are compacted on refresh.
 ///
-/// @tparam TStoredComponents The component types to be stored.
-template<typename... TStoredComponents>
-class TupleOfVectors {
+/// @tparam options The vector storage options to be used.
+/// @tparam TAllocator The allocator template allocating the component vectors (see `allocator.hpp`).
+/// @tparam TStoredComponents The component types (or `Group`s of component types) to be stored.
+template<internal::VectorOptions options, template<typename> typename TAllocator, typename... TStoredComponents>
+class BasicTupleOfVectors {
 private:
-  /// The list of stored component types as a hana::tuple_t.
+  /// The list of stored component types as a hana::tuple_t, with groups expanded.
   ///
   /// This allows handling the type list as a value instead of a template parameter pack,
   /// making it iterable and mutable with boost::hana functions.
-  static constexpr auto _component_types = hana::tuple_t<TStoredComponents...>;
+  static constexpr auto _component_types = columns_components<TStoredComponents...>;
 
   /// The entity signature type.
   ///
-  /// A bitset with a single bit for each component type.
-  using Signature = Bitset2::bitset2<sizeof...(TStoredComponents)>;
+  /// A bitset with a single bit for each component type, which is a machine word for up to 64 component types.
+  using Signature = SignatureOf<decltype(hana::length(_component_types))::value>;
 
   /// Field for accessing the index of a component type within the list of stored component types.
   ///
   /// @tparam TComponent The component type to access the index of.
   template<typename TComponent>
-  static constexpr size_t _component_index = type_index<TComponent, TStoredComponents...>;
+  static constexpr size_t _component_index = std::decay_t<decltype(hana::index_if(_component_types, hana::equal.to(hana::type_c<TComponent>)).value())>::value;
+
+  /// Field for accessing the index of the vector storing a component type.
+  ///
+  /// @tparam TComponent The component type to access the vector index of.
+  template<typename TComponent>
+  static constexpr size_t _column_index = column_index<TComponent, TStoredComponents...>;
+
+  /// Field for accessing whether a component type is stored in AoSoA blocks.
+  ///
+  /// Component types in a `Group` are stored in its tuples, even if they declare an `aosoa_scalar`.
+  /// @tparam TComponent The component type to be checked.
+  template<typename TComponent>
+  static constexpr bool _blocked = is_aosoa<std::tuple_element_t<_column_index<TComponent>, std::tuple<TStoredComponents...>>>;
+
+  /// The vector type storing elements of some type.
+  ///
+  /// If configured to map columns, trivially copyable elements are stored in a `MappedVector`,
+  /// which can be backed by a file. All other elements are stored on the heap.
+  /// @tparam T The element type.
+  template<typename T>
+  using Vector = std::conditional_t<options.mapped_columns && std::is_trivially_copyable_v<T>, MappedVector<T>, std::vector<T, TAllocator<T>>>;
+
+  /// The vector type storing a component type, or a group of component types as tuples.
+  ///
+  /// Component types laid out in AoSoA blocks are stored in an `AoSoAColumn` instead,
+  /// tag component types in a `TagColumn`, which stores nothing,
+  /// and sparse or boxed component types in a `SparseColumn` or `BoxedColumn` respectively.
+  /// @tparam TColumn The component type or `Group`.
+  template<typename TColumn>
+  using Column = std::conditional_t<is_group<TColumn>, Vector<typename ColumnTraits<TColumn>::Row>,
+    std::conditional_t<is_tag<TColumn>, TagColumn<TColumn>,
+    std::conditional_t<is_aosoa<TColumn>, AoSoAColumn<TColumn, TAllocator>,
+    std::conditional_t<layout_of<TColumn> == Layout::sparse, SparseColumn<TColumn, TAllocator>,
+    std::conditional_t<layout_of<TColumn> == Layout::boxed, BoxedColumn<TColumn>,
+    Vector<TColumn>
+  >>>>>;
+
+  /// Field for accessing whether a component type (or group) is stored in a plain vector, of tuples in case of a group.
+  ///
+  /// @tparam TColumn The component type or `Group` to be checked.
+  template<typename TColumn>
+  static constexpr bool _plain = std::is_same_v<Column<TColumn>, Vector<typename ColumnTraits<TColumn>::Row>>;
+
+  /// Field for accessing whether a component type is stored in a sparse set.
+  ///
+  /// @tparam TComponent The component type to be checked.
+  template<typename TComponent>
+  static constexpr bool _sparse = std::is_same_v<Column<TComponent>, SparseColumn<TComponent, TAllocator>>;
 
   /// An entity signature generated from a set of component types.
   ///
@@ -49,45 +135,233 @@ private:
   // Use a fold expression (https://en.cppreference.com/w/cpp/language/fold) to construct the signature.
   // The bitset accumulator starts out at all zero. For each component type a corresponding signature
   // with just that bit set is created by shifting and included in the accumulator using a bitwise OR.
-  static constexpr Signature signature_of = (Signature(0) |= ... |= (Signature(1) << _component_index<TComponents>));
+  static constexpr Signature signature_of = []() {
+    Signature signature(0);
+    ((signature |= Signature(1) << _component_index<TComponents>), ...);
+    return signature;
+  }();
+
+  /// The signature of the component types required by a query, i.e., of all entries except for exclusions (see `QueryTraits`).
+  ///
+  /// @tparam TQuery The entries of the query, each a component type or `Without` one.
+  template<typename... TQuery>
+  static constexpr Signature required_of = (Signature(0) | ... | (QueryTraits<TQuery>::excluded ? Signature(0) : signature_of<typename QueryTraits<TQuery>::Component>));
+
+  /// The signature of the component types excluded by a query.
+  ///
+  /// @tparam TQuery The entries of the query, each a component type or `Without` one.
+  template<typename... TQuery>
+  static constexpr Signature excluded_of = (Signature(0) | ... | (QueryTraits<TQuery>::excluded ? signature_of<typename QueryTraits<TQuery>::Component> : Signature(0)));
+
+  /// Field for accessing whether a component type required by a query is stored in a sparse set.
+  ///
+  /// @tparam TQuery The entries of the query, each a component type or `Without` one.
+  template<typename... TQuery>
+  static constexpr bool _sparse_query = ((!QueryTraits<TQuery>::excluded && _sparse<typename QueryTraits<TQuery>::Component>) || ...);
 public:
   /// The handle type for systems to reference entities with.
-  using Entity = size_t;
+  ///
+  /// Handles are resolved to entity indices through a handle table, so they stay valid when shuffling moves entities.
+  using Entity = GenerationalHandle;
+
+  /// Field for accessing whether a copy of the previous frame's components of a type is kept (see `is_double_buffered`).
+  ///
+  /// Only double-buffered component types stored in separate plain vectors are kept twice.
+  /// @tparam TComponent The component type to be checked.
+  template<typename TComponent>
+  static constexpr bool double_buffered = []() {
+    if constexpr (!is_double_buffered<TComponent>) return false;
+    else return std::is_same_v<std::tuple_element_t<_column_index<TComponent>, std::tuple<TStoredComponents...>>, TComponent> && _plain<TComponent>;
+  }();
+
+  /// Queries may exclude component types by listing them wrapped into `Without`, which is folded into matching signatures.
+  static constexpr bool matches_exclusions = true;
 
   /// Constructs a storage with no components initially stored.
   ///
   /// @param capacity The initial entity capacity for which to allocate memory for.
-  TupleOfVectors(size_t capacity = 32) {
+  BasicTupleOfVectors(size_t capacity = 32) {
     reserve(capacity);
   }
 
   /// Returns and upper bound of the number of active entities currently stored.
   ///
-  /// After shuffling and before removing an entity this upper bound is also the exact amount.
+  /// After refreshing and before removing an entity this upper bound is also the exact amount.
   /// @returns The number of active entities currently stored or an upper bound if inactive entities are currently stored.
   size_t get_size() {
-    return _entities.size();
+    return _entities.size() - _free.size();
+  }
+
+  /// Test whether or not an entity is stored, i.e., its handle has not been invalidated by reclaiming the entity.
+  ///
+  /// Removed entities are stored until the next refresh. Handles of reclaimed entities stay invalid when their slot is reused.
+  /// @param entity The entity to be queried.
+  bool has_entity(Entity entity) const {
+    return _handles.is_valid(entity);
   }
 
   /// Test whether or not a component of some type is attached to an entity.
   ///
+  /// This is false for entities which are not stored anymore.
   /// @param entity The entity to be queried.
   /// @tparam TComponent The component type to be queried.
   template<typename TComponent>
   bool has_component(Entity entity) const {
     // TODO: static_assert component type handled
-    return _entities[entity].signature[_component_index<TComponent>];
+    return has_entity(entity) && (_signatures[_handles.index_of(entity)] & signature_of<TComponent>) == signature_of<TComponent>;
   }
 
   /// Returns a reference to a single component of some entity.
   ///
+  /// Components stored in AoSoA blocks can not be referenced individually.
+  /// For those, a staged copy is returned instead, which is written back when destroyed unless `TComponent` is const.
   /// @param entity The entity to be accessed.
   /// @tparam TComponent The component type to be queried.
   /// @throws std::runtime_error when the queried component is not attached to the entity.
   template<typename TComponent>
-  TComponent& get_component(Entity entity) {
+  decltype(auto) get_component(Entity entity) {
     // TODO: static_assert component type handled
-    return std::get<std::vector<TComponent>>(_components)[entity];
+    using Component = std::remove_const_t<TComponent>;
+    const size_t index = _handles.index_of(entity);
+    if constexpr (_blocked<Component>)
+      return typename Column<Component>::template Staged<TComponent>(std::get<_column_index<Component>>(_components), index);
+    else
+      return static_cast<TComponent&>(component_at<Component>(index));
+  }
+
+  /// Returns a block of components stored in AoSoA blocks.
+  ///
+  /// @param block The index of the block, storing the components of the entities at indices `block * block_lanes` onwards.
+  /// @tparam TComponent The component type to be accessed.
+  template<typename TComponent>
+  Block<TComponent>& get_block(size_t block) {
+    static_assert(_blocked<TComponent>, "Only component types laid out in AoSoA blocks can be accessed as blocks.");
+    return std::get<_column_index<TComponent>>(_components).block(block);
+  }
+
+  /// Returns a span of the components of some type of a run of consecutive entities.
+  ///
+  /// @param begin The index of the first entity of the run.
+  /// @param count The number of entities of the run.
+  /// @tparam TComponent The component type to be accessed, const-qualified for read-only access.
+  template<typename TComponent>
+  std::span<TComponent> get_span(size_t begin, size_t count) {
+    using Component = std::remove_const_t<TComponent>;
+    static_assert(_plain<Component>, "Only component types stored in separate vectors can be accessed as spans.");
+    return std::span<TComponent>(std::get<_column_index<Component>>(_components)).subspan(begin, count);
+  }
+
+  /// Returns the previous frame's copy of a double-buffered component of some entity.
+  ///
+  /// The copy is taken by `update_buffers`, and is not changed by writing to the current component.
+  /// @param entity The entity to be accessed.
+  /// @tparam TComponent The double-buffered component type to be accessed.
+  template<typename TComponent>
+  const TComponent& get_previous_component(Entity entity) const {
+    static_assert(double_buffered<TComponent>, "Only double-buffered component types keep a copy of the previous frame.");
+    return std::get<_column_index<TComponent>>(_previous)[_handles.index_of(entity)];
+  }
+
+  /// Returns a span of the previous frame's copies of a double-buffered component type of a run of consecutive entities.
+  ///
+  /// @param begin The index of the first entity of the run.
+  /// @param count The number of entities of the run.
+  /// @tparam TComponent The double-buffered component type to be accessed.
+  template<typename TComponent>
+  std::span<const TComponent> get_previous_span(size_t begin, size_t count) const {
+    static_assert(double_buffered<TComponent>, "Only double-buffered component types keep a copy of the previous frame.");
+    return std::span<const TComponent>(std::get<_column_index<TComponent>>(_previous)).subspan(begin, count);
+  }
+
+  /// Copies the current components of all double-buffered types over their previous frame's copies.
+  ///
+  /// Called by the schedulers before running the systems, so that the copies match the entity indices of the frame.
+  /// Instead of swapping the buffers, the components are copied, so that writers keep building on their last values.
+  void update_buffers() {
+    hana::for_each(hana::tuple_t<TStoredComponents...>, [&](auto type) {
+      using Stored = typename decltype(type)::type;
+      if constexpr (double_buffered<Stored>) {
+        const auto& column = std::get<_column_index<Stored>>(_components);
+        std::get<_column_index<Stored>>(_previous).assign(column.begin(), column.end());
+      }
+    });
+  }
+
+  /// Starts tracking the changes of a component type, so that entities can be filtered by them (see `ChangeFilter`).
+  ///
+  /// The components of entities already stored count as changed at the current change tick.
+  /// @tparam TComponent The component type to be tracked.
+  template<typename TComponent>
+  void track_changes() {
+    if (tracks<TComponent>()) return;
+    _tracked |= signature_of<TComponent>;
+    _ticks[_component_index<TComponent>].added.assign(_entities.size(), _change_tick);
+    _ticks[_component_index<TComponent>].changed.assign(_entities.size(), _change_tick);
+  }
+
+  /// Sets the change tick stamped on components attached from now on.
+  ///
+  /// Ticks order the changes of components, and are chosen by the scheduler, such that a system can tell the changes
+  /// made since it last ran by comparing their ticks to the tick of its last run.
+  /// @param tick The new change tick.
+  void set_change_tick(uint64_t tick) {
+    _change_tick = tick;
+  }
+
+  /// Whether a component of a tracked type has been attached to an entity after some tick.
+  ///
+  /// @param entity The entity to be queried.
+  /// @param tick The tick after which the component must have been attached.
+  /// @tparam TComponent The tracked component type to be queried.
+  template<typename TComponent>
+  bool added_since(Entity entity, uint64_t tick) const {
+    return _ticks[_component_index<TComponent>].added[_handles.index_of(entity)] > tick;
+  }
+
+  /// Whether a component of a tracked type has been attached to an entity or accessed mutably after some tick.
+  ///
+  /// @param entity The entity to be queried.
+  /// @param tick The tick after which the component must have been changed.
+  /// @tparam TComponent The tracked component type to be queried.
+  template<typename TComponent>
+  bool changed_since(Entity entity, uint64_t tick) const {
+    return _ticks[_component_index<TComponent>].changed[_handles.index_of(entity)] > tick;
+  }
+
+  /// Marks the components of a type as changed for all entities with all required components attached.
+  ///
+  /// Called by the schedulers after a system accessing the component type mutably ran, instead of marking each write.
+  /// The ticks are filled run by run. Does nothing unless the component type is tracked.
+  /// @param tick The tick of the system run.
+  /// @tparam TComponent The component type accessed mutably.
+  /// @tparam TRequiredComponents The component types required by the system, and those excluded, wrapped into `Without`.
+  template<typename TComponent, typename... TRequiredComponents>
+  void mark_changed(uint64_t tick) {
+    if (!tracks<TComponent>()) return;
+    auto& ticks = _ticks[_component_index<TComponent>].changed;
+    _signatures.for_each_run(required_of<TRequiredComponents...>, excluded_of<TRequiredComponents...>, [&](size_t begin, size_t count) {
+      std::fill_n(ticks.begin() + begin, count, tick);
+    });
+  }
+
+  /// Marks the component of a type of a single entity as changed.
+  ///
+  /// Used by the schedulers for systems only called for some of the entities with their required components attached.
+  /// Does nothing unless the component type is tracked.
+  /// @param entity The entity whose component has been accessed mutably.
+  /// @param tick The tick of the system run.
+  /// @tparam TComponent The component type accessed mutably.
+  template<typename TComponent>
+  void mark_changed(Entity entity, uint64_t tick) {
+    if (tracks<TComponent>()) _ticks[_component_index<TComponent>].changed[_handles.index_of(entity)] = tick;
+  }
+
+  /// Returns a span of the handles of a run of consecutive entities.
+  ///
+  /// @param begin The index of the first entity of the run.
+  /// @param count The number of entities of the run.
+  std::span<const Entity> get_entity_span(size_t begin, size_t count) const {
+    return std::span<const Entity>(_entity_handles).subspan(begin, count);
   }
 
   /// Sets the component data for a single component of some entity.
@@ -99,10 +373,15 @@ public:
   template<typename TComponent>
   void attach_component(Entity entity, TComponent&& component) {
     // TODO: static_assert component type stored
+    const size_t index = _handles.index_of(entity);
+    // Stamp the change before the signature is changed, so that a newly attached component also counts as added.
+    stamp_changes(index, signature_of<std::decay_t<TComponent>>);
     // Set the associated component bit in the entity signature.
-    _entities[entity].signature |= signature_of<std::decay_t<TComponent>>;
+    _signatures.assign(index, _signatures[index] | signature_of<std::decay_t<TComponent>>);
     // Assign component from the parameter.
-    get_component<std::decay_t<TComponent>>(entity) = std::forward<TComponent>(component);
+    assign_component<std::decay_t<TComponent>>(index, std::forward<TComponent>(component));
+    // Track the entity in queries it now matches.
+    update_queries(index);
   }
 
   /// Sets the component data for some entity.
@@ -114,15 +393,25 @@ public:
   template<typename... TComponents>
   void set_components(Entity entity, TComponents&&... components) {
     // TODO: static_assert component type stored
+    const size_t index = _handles.index_of(entity);
+    // Stamp the changes before the signature is changed, so that newly attached components also count as added.
+    stamp_changes(index, signature_of<std::decay_t<TComponents>...>);
     // Set the associated component bits in the entity signature.
-    _entities[entity].signature = signature_of<std::decay_t<TComponents>...>;
-    // Set all passed in components using a fold expression.
-    (attach_component(entity, std::forward<TComponents>(components)), ...);
+    _signatures.assign(index, signature_of<std::decay_t<TComponents>...>);
+    // Assign all passed in components using a fold expression.
+    (assign_component<std::decay_t<TComponents>>(index, std::forward<TComponents>(components)), ...);
+    // Release the data of components no longer attached, if it is stored only for attached components.
+    ([&]() {
+      if constexpr (!is_group<TStoredComponents> && !types_contain<TStoredComponents, std::decay_t<TComponents>...>)
+        erase_component<TStoredComponents>(index);
+    }(), ...);
+    // Track the entity in queries it now matches and mark the ones it no longer matches.
+    update_queries(index);
   }
 
   /// Detaches a component from an entity.
   ///
-  /// This disables the component on the entity by mutating the entity signature stored in the metadata.
+  /// This disables the component on the entity by mutating the entity signature.
   /// The component data is not cleared and its memory not released.
   /// This operation is idempotent.
   ///
@@ -131,41 +420,356 @@ public:
   template<typename TComponent>
   void detach_component(Entity entity) {
     // TODO: static_assert component type stored
+    const size_t index = _handles.index_of(entity);
     // Unset the associated component bit in the entity signature.
-    _entities[entity].signature &= !signature_of<std::decay_t<TComponent>>;
+    _signatures.assign(index, _signatures[index] & ~signature_of<std::decay_t<TComponent>>);
+    // Release the component data if it is stored only for attached components.
+    erase_component<std::decay_t<TComponent>>(index);
+    // Mark the queries the entity no longer matches.
+    update_queries(index);
   }
 
-  // TODO: return entity?
   /// Creates and activates a new entity.
   ///
   /// @param components The set of components to be initially associated with the new entity.
+  /// @returns The handle of the new entity.
   template<typename... TComponents>
-  void new_entity(TComponents&&... components) {
+  Entity new_entity(TComponents&&... components) {
+    // Reuse the slot of a removed entity, if any.
+    if constexpr (options.free_list) {
+      if (!_free.empty()) {
+        const size_t index = _free.back();
+        _free.pop_back();
+        _entities[index] = EntityMetadata{};
+        _entity_handles[index] = _handles.create(index);
+        set_components(_entity_handles[index], std::forward<TComponents>(components)...);
+        return _entity_handles[index];
+      }
+    }
     // Create new entity metadata and set the associated component bits in the signature.
-    _entities.emplace_back().signature = signature_of<std::decay_t<TComponents>...>;
-    // Push the initial components into their vectors.
-    (std::get<std::vector<TComponents>>(_components).push_back(std::forward<decltype(components)>(components)), ...);
-    // Default-construct all components that are not passed in.
+    _entities.emplace_back();
+    _signatures.push_back(signature_of<std::decay_t<TComponents>...>);
+    // Create a handle resolving to the new entity's index.
+    _entity_handles.push_back(_handles.create(_entities.size() - 1));
+    // Count all components of the new entity as added.
+    resize_ticks(_entities.size());
+    // Push the initial components of ungrouped types into their vectors.
+    ([&]() {
+      using Component = std::decay_t<TComponents>;
+      if constexpr (!is_group<std::tuple_element_t<_column_index<Component>, std::tuple<TStoredComponents...>>>)
+        std::get<_column_index<Component>>(_components).push_back(std::forward<TComponents>(components));
+    }(), ...);
+    // Default-construct all groups and all components that are not passed in.
     ([&]() {
-      if constexpr (!types_contain<TStoredComponents, TComponents...>)
-        std::get<std::vector<TStoredComponents>>(_components).emplace_back();
+      if constexpr (is_group<TStoredComponents> || !types_contain<TStoredComponents, std::decay_t<TComponents>...>)
+        std::get<Column<TStoredComponents>>(_components).emplace_back();
     }(), ...);
+    // Assign the initial components of grouped types to their tuples.
+    ([&]() {
+      using Component = std::decay_t<TComponents>;
+      if constexpr (is_group<std::tuple_element_t<_column_index<Component>, std::tuple<TStoredComponents...>>>)
+        component_at<Component>(_entities.size() - 1) = std::forward<TComponents>(components);
+    }(), ...);
+    // Track the entity in the queries it matches.
+    update_queries(_entities.size() - 1);
+    return _entity_handles.back();
+  }
+
+  /// Creates and activates multiple new entities with the same set of component types.
+  ///
+  /// Memory is reserved once for all new entities.
+  /// @param count The number of entities to be created.
+  /// @param generator The callable returning the initial components of the `i`-th new entity as a `std::tuple`, given `i`.
+  void new_entities(size_t count, auto&& generator) {
+    generate_entities<false>(count, generator);
+  }
+
+  /// Creates and activates multiple new entities with the same set of component types.
+  /// Employs inner parallelism, unless a component type is stored in a sparse set.
+  ///
+  /// Memory is reserved once for all new entities.
+  /// @param count The number of entities to be created.
+  /// @param generator The callable returning the initial components of the `i`-th new entity as a `std::tuple`, given `i`.
+  /// It is called concurrently for different `i`.
+  void new_entities_parallel(size_t count, auto&& generator) {
+    generate_entities<true>(count, generator);
+  }
+
+  /// Creates and activates multiple new entities from columns of components.
+  ///
+  /// The `i`-th new entity is associated with the `i`-th component of each column.
+  /// Columns of component types stored in plain vectors are adopted as a whole if the storage is empty,
+  /// and have their elements moved otherwise. Free slots are filled one by one first.
+  /// @param columns The initial components of the new entities, one equally-sized vector per component type.
+  template<typename... TComponents>
+  void new_entities(std::vector<TComponents>&&... columns) {
+    const size_t total = std::get<0>(std::tie(columns...)).size();
+    assert(((columns.size() == total) && ...));
+    // Reuse the slots of removed entities first.
+    size_t reused = 0;
+    if constexpr (options.free_list)
+      for (; reused < total && !_free.empty(); ++reused) new_entity(std::move(columns[reused])...);
+    const size_t count = total - reused;
+    if (!count) return;
+    const size_t begin = append_entities<TComponents...>(count);
+    auto imported = std::tie(columns...);
+    // Import the columns stored in plain vectors and grow all other columns.
+    ([&]() {
+      auto& column = std::get<Column<TStoredComponents>>(_components);
+      if constexpr (_plain<TStoredComponents> && types_contain<TStoredComponents, TComponents...>) {
+        auto& components = std::get<std::vector<TStoredComponents>&>(imported);
+        // Adopt the vector if possible, which mapped columns and those of other allocators can not.
+        if constexpr (std::is_same_v<Column<TStoredComponents>, std::vector<TStoredComponents>>)
+          if (column.empty() && !reused) {
+            column = std::move(components);
+            return;
+          }
+        column.insert(column.end(), std::make_move_iterator(components.begin() + reused), std::make_move_iterator(components.end()));
+      } else column.resize(begin + count);
+    }(), ...);
+    // Assign the components stored in other columns one by one.
+    ([&]() {
+      using Stored = std::tuple_element_t<_column_index<TComponents>, std::tuple<TStoredComponents...>>;
+      if constexpr (!std::is_same_v<Stored, TComponents> || !_plain<Stored>) {
+        auto& components = std::get<std::vector<TComponents>&>(imported);
+        for (size_t i = 0; i < count; ++i)
+          assign_component<TComponents>(begin + i, std::move(components[reused + i]));
+      }
+    }(), ...);
+    // Track the entities in the queries they match.
+    if (!_queries.empty())
+      for (size_t index = begin; index < begin + count; ++index) update_queries(index);
   }
 
   /// Removes an entity from the storage.
   ///
-  /// This merely sets the entity as inactive. Shuffling will later reclaim the storage space.
+  /// This merely sets the entity as inactive and records its index. Shuffling will later reclaim the storage space.
   void remove_entity(Entity entity) {
+    const size_t index = _handles.index_of(entity);
+    EntityMetadata& metadata = _entities[index];
+    // Ignore repeated removals of the same entity.
+    if (!metadata.active) return;
     // Set the entity as inactive.
-    _entities[entity].active = false;
-    // Increment the fragmentation counter.
-    ++_fragmentation;
+    metadata.active = false;
+    // Mark the queries listing the entity, so that it is dropped on refresh.
+    for (size_t query = 0; query < _queries.size(); ++query)
+      if (metadata.queries & (uint64_t{1} << query)) _queries[query].dirty = true;
+    // Record the removal for shuffling.
+    _removed.push_back(index);
+  }
+
+  /// Removes all entities with all required components attached which satisfy a predicate.
+  ///
+  /// Like `remove_entity`, this merely sets the entities as inactive, so that they are reclaimed by a single shuffle on refresh.
+  /// @tparam TRequiredComponents The set of component types required to be attached to an entity to be tested.
+  /// @param predicate The callable returning whether to remove an entity, given const references to its required components.
+  template<typename... TRequiredComponents>
+  void remove_entities_if(auto&& predicate) {
+    mark_removed_if<false, TRequiredComponents...>(predicate);
+  }
+
+  /// Removes all entities with all required components attached which satisfy a predicate.
+  /// Employs inner parallelism.
+  ///
+  /// Like `remove_entity`, this merely sets the entities as inactive, so that they are reclaimed by a single shuffle on refresh.
+  /// @tparam TRequiredComponents The set of component types required to be attached to an entity to be tested.
+  /// @param predicate The callable returning whether to remove an entity, given const references to its required components.
+  /// It is called concurrently for different entities.
+  template<typename... TRequiredComponents>
+  void remove_entities_if_parallel(auto&& predicate) {
+    mark_removed_if<true, TRequiredComponents...>(predicate);
+  }
+
+  /// Reorders the entities by a key over one of their components, to improve the locality of iteration.
+  ///
+  /// For example, ordering entities by a Morton code of their position lets systems touching spatially nearby
+  /// entities together stream through memory. Entities without the component attached and removed entities
+  /// are placed behind all others, and entities with equal keys keep their relative order. Handles stay valid,
+  /// including those of removed entities, which are left to be reclaimed by the next refresh.
+  /// The permutation is applied to each column in a single pass, concurrently for different columns if many entities are stored.
+  /// @tparam TComponent The component type the key is computed from.
+  /// @param key The callable returning the key of an entity, given a const reference to its component.
+  /// Keys are compared with `<`.
+  template<typename TComponent>
+  void sort_entities(auto&& key) {
+    using Key = std::decay_t<decltype(key(read_component<TComponent>(0)))>;
+    constexpr Signature signature = signature_of<TComponent>;
+    const size_t size = _entities.size();
+    std::vector<std::pair<Key, size_t>> keys;
+    for (size_t index = 0; index < size; ++index)
+      if (_entities[index].active && (_signatures[index] & signature) == signature) keys.emplace_back(key(read_component<TComponent>(index)), index);
+    std::stable_sort(keys.begin(), keys.end(), [](const auto& first, const auto& second) { return first.first < second.first; });
+    // The previous index of each entity in the new order.
+    std::vector<size_t> order;
+    order.reserve(size);
+    for (const auto& [_, index] : keys) order.push_back(index);
+    for (size_t index = 0; index < size && order.size() < size; ++index)
+      if (!_entities[index].active || (_signatures[index] & signature) != signature) order.push_back(index);
+    // If the entities are in order already, e.g. when sorting every frame, there is nothing to move.
+    if (!std::ranges::equal(order, std::views::iota(size_t{0}, size))) permute(order);
+  }
+
+  /// Backs the storage by files in a directory, so that it persists across runs.
+  ///
+  /// Requires the storage to be configured to map columns (see `VectorOptions`). If no entity has been stored yet and
+  /// the directory contains a storage saved before, it is adopted without reading its components: they are only loaded
+  /// as their pages are accessed, so the storage starts instantly and need not fit into memory. Otherwise, the storage is
+  /// written to the directory, replacing any storage saved before. From then on, all changes are written through to the files.
+  /// Components not stored in mapped columns (e.g., of types that are not trivially copyable) are not saved,
+  /// and are detached from adopted entities. Files are only compatible between storages of the same component types in the
+  /// same order, which is checked by a fingerprint of the component types in the entity file and of the element type in each column file.
+  /// All files are inspected before any is opened, so a directory not holding a complete, compatible storage is left untouched.
+  /// @param directory The directory to store the files in, which is created if it does not exist.
+  /// @throws std::system_error when a file can not be opened, resized or mapped.
+  /// @throws std::runtime_error when the directory holds files of an incomplete or incompatible storage.
+  void map_files(const std::filesystem::path& directory) requires (options.mapped_columns) {
+    static_assert(std::is_trivially_copyable_v<Signature>, "Only storages with trivially copyable signatures can be backed by files.");
+    refresh();
+    std::filesystem::create_directories(directory);
+    // The path of the file of the column at some index.
+    const auto column_path = [&](size_t index) { return directory / ("column" + std::to_string(index)); };
+    // The entity file identifies the list of component types, so that columns are not adopted by other components.
+    const uint64_t fingerprint = type_fingerprint<std::tuple<TStoredComponents...>>();
+    // Inspect every file first, so that the whole directory is either adopted, written anew, or rejected untouched.
+    const MappedFile entities = decltype(_entities)::inspect(directory / "entities", fingerprint);
+    std::vector<MappedFile> files{
+      entities,
+      decltype(_entity_handles)::inspect(directory / "handles"),
+      decltype(_signatures)::inspect(directory / "signatures"),
+      decltype(_handles)::inspect(directory / "handle_table")
+    };
+    bool complete = files[1].size == entities.size && files[2].size == entities.size;
+    [&]<size_t... Is>(std::index_sequence<Is...>) {
+      ([&]() {
+        using TColumn = std::tuple_element_t<Is, std::tuple<Column<TStoredComponents>...>>;
+        if constexpr (requires { TColumn::inspect(directory); }) {
+          const MappedFile column = TColumn::inspect(column_path(Is));
+          complete = complete && column.size == entities.size;
+          files.push_back(column);
+        }
+      }(), ...);
+    }(std::index_sequence_for<TStoredComponents...>{});
+    const bool saved = std::ranges::any_of(files, &MappedFile::exists);
+    if (saved && (!complete || !std::ranges::all_of(files, &MappedFile::compatible)))
+      throw std::runtime_error("Incomplete or incompatible storage in " + directory.string());
+    const bool adopt = saved && _entities.empty() && _handles.empty();
+    _entities.open(directory / "entities", adopt, fingerprint);
+    _entity_handles.open(directory / "handles", adopt);
+    _signatures.open(directory / "signatures", adopt);
+    _handles.open(directory / "handle_table", adopt);
+    [&]<size_t... Is>(std::index_sequence<Is...>) {
+      ([&]() {
+        auto& column = std::get<Is>(_components);
+        if constexpr (requires { column.inspect(directory); }) column.open(column_path(Is), adopt);
+      }(), ...);
+    }(std::index_sequence_for<TStoredComponents...>{});
+    if (!adopt) return;
+    const size_t size = _entities.size();
+    // Grow the columns on the heap, and detach their components, which have not been saved.
+    Signature lost{};
+    ([&]() {
+      auto& column = std::get<Column<TStoredComponents>>(_components);
+      if constexpr (!requires { column.inspect(directory); } && !std::is_same_v<Column<TStoredComponents>, TagColumn<TStoredComponents>>) {
+        column.resize(size);
+        lost |= hana::unpack(ColumnTraits<TStoredComponents>::components, []<typename... TComponents>(TComponents...) {
+          return signature_of<typename TComponents::type...>;
+        });
+      }
+    }(), ...);
+    // Restore the transient metadata.
+    for (size_t index = 0; index < size; ++index) {
+      if (lost != Signature{} && (_signatures[index] & lost) != Signature{}) _signatures.assign(index, _signatures[index] & ~lost);
+      _entities[index].queries = 0;
+      if constexpr (options.free_list)
+        if (!_entities[index].active) _free.push_back(index);
+      update_queries(index);
+    }
+    _signatures.refresh();
+    // Count all components of the adopted entities as added.
+    reset_ticks();
+  }
+
+  /// Captures a consistent copy of the storage, to be written to a file off the frame thread.
+  ///
+  /// The storage is refreshed first. Each column of trivially copyable components (as well as the entity metadata)
+  /// is captured with a single bulk copy. Sparse, boxed and AoSoA columns are captured as the components of
+  /// the entities they are attached to, in order. Cached queries are not captured, but relisted on restore.
+  /// @param snapshot A snapshot written before, whose memory is reused (see `SnapshotWriter::recycle`).
+  /// @returns The snapshot, to be written by `Snapshot::write` or a `SnapshotWriter`.
+  Snapshot snapshot(Snapshot snapshot = {}) requires (is_serializable<typename ColumnTraits<TStoredComponents>::Row> && ...) {
+    refresh();
+    snapshot.clear();
+    snapshot.capture(_entities);
+    snapshot.capture(_entity_handles);
+    _signatures.capture(snapshot);
+    _handles.capture(snapshot);
+    snapshot.capture(_free);
+    ([&]() {
+      auto& column = std::get<Column<TStoredComponents>>(_components);
+      if constexpr (_plain<TStoredComponents>) snapshot.capture(column);
+      else if constexpr (!std::is_same_v<Column<TStoredComponents>, TagColumn<TStoredComponents>>) {
+        constexpr Signature signature = signature_of<TStoredComponents>;
+        std::vector<TStoredComponents> attached;
+        for (size_t index = 0; index < _entities.size(); ++index)
+          if ((_signatures[index] & signature) == signature) attached.push_back(read_component<TStoredComponents>(index));
+        snapshot.capture(attached);
+      }
+    }(), ...);
+    return snapshot;
+  }
+
+  /// Replaces all entities by the ones captured in a snapshot file.
+  ///
+  /// Handles of the captured entities are valid again afterwards. Sections of trivially copyable components are
+  /// read directly into their columns. Cached queries are kept, and list the restored entities.
+  /// @param path The path of the snapshot file, captured from a storage of the same component types and options.
+  /// @throws std::runtime_error when the file does not hold a snapshot of such a storage, in which case the storage
+  /// is left in an unspecified state.
+  void restore(const std::filesystem::path& path) requires (is_serializable<typename ColumnTraits<TStoredComponents>::Row> && ...) {
+    SnapshotReader reader(path);
+    _removed.clear();
+    reader.read(_entities);
+    reader.read(_entity_handles);
+    _signatures.restore(reader);
+    _handles.restore(reader);
+    reader.read(_free);
+    const size_t size = _entities.size();
+    bool complete = _entity_handles.size() == size && _signatures.size() == size;
+    ([&]() {
+      auto& column = std::get<Column<TStoredComponents>>(_components);
+      if constexpr (_plain<TStoredComponents>) {
+        reader.read(column);
+        complete = complete && column.size() == size;
+      } else if constexpr (!std::is_same_v<Column<TStoredComponents>, TagColumn<TStoredComponents>>) {
+        column = Column<TStoredComponents>{};
+        column.resize(size);
+        constexpr Signature signature = signature_of<TStoredComponents>;
+        auto attached = reader.template read<TStoredComponents>();
+        size_t next = 0;
+        for (size_t index = 0; index < size && next < attached.size(); ++index)
+          if ((_signatures[index] & signature) == signature) assign_component<TStoredComponents>(index, std::move(attached[next++]));
+        complete = complete && next == attached.size();
+      }
+    }(), ...);
+    if (!complete) throw std::runtime_error("Incomplete snapshot in " + path.string());
+    // Relist the restored entities in the cached queries.
+    for (Query& query : _queries) {
+      query.entities.clear();
+      query.dirty = false;
+    }
+    for (size_t index = 0; index < size; ++index) {
+      _entities[index].queries = 0;
+      update_queries(index);
+    }
+    // Count all components of the restored entities as added.
+    reset_ticks();
   }
 
   /// Executes a callable on each entity with all required components attached.
   ///
   /// Requires no inactive entity to exist with an index smaller than the highest active one.
-  /// @tparam TRequiredComponents The set of component types required to be attached to an entity to be processed.
+  /// @tparam TRequiredComponents The set of component types required to be attached to an entity to be processed,
+  /// and those required to be detached, wrapped into `Without`.
   /// @param callable The callable to be executed with each matched entity's index as an argument.
   template<typename... TRequiredComponents>
   void for_entities_with(auto&& callable) const {
@@ -173,36 +777,126 @@ public:
     if constexpr (sizeof...(TRequiredComponents) > 0) {
       // TODO: static_assert component types handled
       // Construct a signature to be matched against from the required component types.
-      constexpr Signature signature = signature_of<TRequiredComponents...>;
-      // Iterate all active components.
-      for (size_t i{0}; i < _entities.size(); ++i) {
-        // Match the entity signature with the required component types using a bitwise AND.
-        if ((_entities[i].signature & signature) == signature)
-        // TODO: call with manager (since this is sequential)
-          callable(Entity{i});
+      constexpr Signature signature = required_of<TRequiredComponents...>;
+      // The bits compared, such that the bits of excluded component types must be off.
+      constexpr Signature mask = signature | excluded_of<TRequiredComponents...>;
+      // If the query is cached, only iterate the listed entities.
+      if (const Query* query = find_query(signature)) {
+        for (size_t index : query->entities) {
+          // Entities detached since the last refresh are still listed, so match again.
+          if ((_signatures[index] & mask) == signature)
+            callable(_entity_handles[index]);
+        }
+        return;
       }
-    } else callable(Entity{SIZE_MAX}); // TODO: move check to scheduler to avoid -1-reservation (and also execute if ECS::Entity is required)
+      // If a required component type is stored sparsely, only iterate the entities of the smallest such sparse set.
+      if constexpr (_sparse_query<TRequiredComponents...>) {
+        for (size_t index : sparsest<TRequiredComponents...>())
+          if ((_signatures[index] & mask) == signature)
+            callable(_entity_handles[index]);
+        return;
+      }
+      // Iterate all active components.
+      // Signatures are matched against the required component types block-wise.
+      // TODO: call with manager (since this is sequential)
+      _signatures.for_each_match(signature, excluded_of<TRequiredComponents...>, [&](size_t index) {
+        callable(_entity_handles[index]);
+      });
+    } else callable(Entity{}); // TODO: move check to scheduler to avoid -1-reservation (and also execute if ECS::Entity is required)
   }
 
   /// Executes a callable on each entity with all required components attached.
   /// Employs inner parallelism.
   ///
   /// Requires no inactive entity to exist with an index smaller than the highest active one.
-  /// @tparam TRequiredComponents The set of component types required to be attached to an entity to be processed.
+  /// @tparam TRequiredComponents The set of component types required to be attached to an entity to be processed,
+  /// and those required to be detached, wrapped into `Without`.
   /// @param callable The callable to be executed with each matched entity's index as an argument.
   // TODO: parametrize parallelization
   template<typename... TRequiredComponents>
   void for_entities_with_parallel(auto&& callable) const {
     if constexpr (sizeof...(TRequiredComponents) > 0) {
       // TODO: static_assert component types handled
-      static constexpr Signature signature = signature_of<TRequiredComponents...>;
-      #pragma omp parallel for
-      for (size_t i = 0; i < _entities.size(); ++i) {
-        if ((_entities[i].signature & signature) == signature)
-        // TODO: maybe a parallel manager?
-          callable(Entity{i});
+      static constexpr Signature signature = required_of<TRequiredComponents...>;
+      static constexpr Signature mask = signature | excluded_of<TRequiredComponents...>;
+      if (const Query* query = find_query(signature)) {
+        #pragma omp parallel for
+        for (size_t i = 0; i < query->entities.size(); ++i) {
+          const size_t index = query->entities[i];
+          if ((_signatures[index] & mask) == signature)
+            callable(_entity_handles[index]);
+        }
+        return;
+      }
+      if constexpr (_sparse_query<TRequiredComponents...>) {
+        const std::vector<uint32_t>& entities = sparsest<TRequiredComponents...>();
+        #pragma omp parallel for
+        for (size_t i = 0; i < entities.size(); ++i) {
+          const size_t index = entities[i];
+          if ((_signatures[index] & mask) == signature)
+            callable(_entity_handles[index]);
+        }
+        return;
       }
-    } else callable(Entity{SIZE_MAX}); // TODO: move check to scheduler
+      // TODO: maybe a parallel manager?
+      _signatures.for_each_match_parallel(signature, excluded_of<TRequiredComponents...>, [&](size_t index) {
+        callable(_entity_handles[index]);
+      });
+    } else callable(Entity{}); // TODO: move check to scheduler
+  }
+
+  /// Executes a callable on each maximal run of consecutive entities with all required components attached.
+  ///
+  /// Requires no inactive entity to exist with an index smaller than the highest active one.
+  /// @tparam TRequiredComponents The set of component types required to be attached to an entity to be processed,
+  /// and those required to be detached, wrapped into `Without`.
+  /// @param callable The callable to be executed with the index of the first entity and the number of entities of each run.
+  template<typename... TRequiredComponents>
+  void for_runs_with(auto&& callable) const {
+    _signatures.for_each_run(required_of<TRequiredComponents...>, excluded_of<TRequiredComponents...>, callable);
+  }
+
+  /// Executes a callable on each run of consecutive entities with all required components attached.
+  /// Employs inner parallelism.
+  ///
+  /// Runs are split at the boundaries of signature blocks, so that they can be processed independently.
+  /// Requires no inactive entity to exist with an index smaller than the highest active one.
+  /// @tparam TRequiredComponents The set of component types required to be attached to an entity to be processed,
+  /// and those required to be detached, wrapped into `Without`.
+  /// @param callable The callable to be executed with the index of the first entity and the number of entities of each run.
+  template<typename... TRequiredComponents>
+  void for_runs_with_parallel(auto&& callable) const {
+    _signatures.for_each_run_parallel(required_of<TRequiredComponents...>, excluded_of<TRequiredComponents...>, callable);
+  }
+
+  /// Executes a callable on each block of AoSoA components containing entities with all required components attached.
+  ///
+  /// Requires no inactive entity to exist with an index smaller than the highest active one.
+  /// @tparam TRequiredComponents The set of component types required to be attached to an entity to be processed,
+  /// and those required to be detached, wrapped into `Without`.
+  /// @param callable The callable to be executed with each block's index and a bit mask of its matching lanes as arguments.
+  template<typename... TRequiredComponents>
+  void for_blocks_with(auto&& callable) const {
+    constexpr Signature signature = required_of<TRequiredComponents...>;
+    constexpr Signature excluded = excluded_of<TRequiredComponents...>;
+    for (size_t block = 0; block < block_count(); ++block)
+      if (const uint64_t lanes = match_block(block, signature, excluded)) callable(block, lanes);
+  }
+
+  /// Executes a callable on each block of AoSoA components containing entities with all required components attached.
+  /// Employs inner parallelism.
+  ///
+  /// Requires no inactive entity to exist with an index smaller than the highest active one.
+  /// @tparam TRequiredComponents The set of component types required to be attached to an entity to be processed,
+  /// and those required to be detached, wrapped into `Without`.
+  /// @param callable The callable to be executed with each block's index and a bit mask of its matching lanes as arguments.
+  template<typename... TRequiredComponents>
+  void for_blocks_with_parallel(auto&& callable) const {
+    static constexpr Signature signature = required_of<TRequiredComponents...>;
+    static constexpr Signature excluded = excluded_of<TRequiredComponents...>;
+    #pragma omp parallel for
+    for (size_t block = 0; block < block_count(); ++block)
+      if (const uint64_t lanes = match_block(block, signature, excluded)) callable(block, lanes);
   }
 
   // TODO: Remove this function (it's just for debugging purposes).
@@ -214,135 +908,740 @@ public:
     stream << std::endl;
   }
 
+  /// Registers a query whose matching entities are to be cached.
+  ///
+  /// Instead of matching every entity's signature on each iteration, the storage then
+  /// keeps a list of matching entities which is updated incrementally on structural changes.
+  /// At most `_max_queries` queries are cached. Iterations on other queries match every entity.
+  /// @tparam TRequiredComponents The set of component types required to be attached to an entity to be listed.
+  template<typename... TRequiredComponents>
+  void cache_query() {
+    // Single-fire systems do not iterate entities.
+    if constexpr (sizeof...(TRequiredComponents) > 0) {
+      constexpr Signature signature = signature_of<TRequiredComponents...>;
+      if (find_query(signature) || _queries.size() >= _max_queries) return;
+      _queries.push_back(Query{signature});
+      // List all entities already stored.
+      for (size_t i{0}; i < _entities.size(); ++i) update_queries(i);
+    }
+  }
+
   /// Refreshes the storage to restore the preconditions necessary for iterating the entities.
   auto refresh() {
-    // Shuffle the storage to restore contiguity.
-    size_t size = shuffle();
-    // Reset the fragmentation counter.
-    _fragmentation = 0;
+    // Drop removed and no longer matching entities from the cached queries while entity indices are still valid.
+    for (Query& query : _queries)
+      if (query.dirty) filter_query(query);
+    // Shuffle the storage to restore contiguity, or free the slots of the removed entities.
+    // This also invalidates the handles of the removed entities.
+    size_t size;
+    if constexpr (options.free_list) size = free_removed();
+    else size = shuffle();
+    // Translate the cached queries to the entity indices after shuffling.
+    if (!_relocations.empty() || std::any_of(_queries.begin(), _queries.end(), [](const Query& query) { return query.dirty; }))
+      for (Query& query : _queries) relocate_query(query, size);
+    _relocations.clear();
     // Resize vectors to drop inactive entities.
     _entities.resize(size);
-    (std::get<std::vector<TStoredComponents>>(_components).resize(size), ...);
+    _entity_handles.resize(size);
+    _signatures.resize(size);
+    resize_ticks(size);
+    // Recompute the block summaries of signatures changed during the last frame.
+    _signatures.refresh();
+    (std::get<Column<TStoredComponents>>(_components).resize(size), ...);
   }
 
 private:
   /// Contains any metadata (i.e. data besides the associated component data) necessary to be stored for an entity in this storage.
   struct EntityMetadata {
-    /// The entity's signature.
-    ///
-    /// The state of a bit indicates whether the component of the corresponding component type is attached to the entity.
-    /// A component is said to be attached to this entity if the bit is set, and detached if not.
-    /// This is necessary because for each entity, storage for each component type is allocated and initialized (in the vectors)
-    /// and its signature tracks if said memory is to be considered associated with the entity.
-    Signature signature;
-
     /// The entity's activeness. This represents the entities's existence/presence. Instead of being removed from memory,
     /// entities to be removed are simply set as inactive. Shuffling then later gets rid of them.
     bool active = true;
+
+    /// The cached queries listing this entity.
+    ///
+    /// Bit `i` is set if the entity is contained in the entity list of the `i`-th cached query.
+    uint64_t queries = 0;
+  };
+
+  /// The handle table resolving entity handles to indices into the vectors.
+  BasicHandleTable<Vector> _handles;
+
+  /// A cached query, listing the indices of all entities matching a signature.
+  struct Query {
+    /// The signature of the required component types.
+    Signature signature;
+
+    /// The indices of the listed entities in ascending order.
+    ///
+    /// Entities detached or removed since the last refresh may still be listed.
+    /// Entities are never listed more than once.
+    std::vector<size_t> entities = {};
+
+    /// Whether the entity list contains stale entries or is out of order.
+    bool dirty = false;
   };
 
+  /// The maximum number of cached queries.
+  ///
+  /// This is limited by the number of bits in the query membership mask of the entity metadata.
+  static constexpr size_t _max_queries = 64;
+
+  /// The cached queries.
+  std::vector<Query> _queries;
+
+  /// The new indices of entities moved by the last shuffle.
+  ///
+  /// The element at `i` is the new index of the entity previously at the `i`-th index from the back.
+  /// Only recorded while queries are cached.
+  std::vector<size_t> _relocations;
+
   /// Vector storing the entity metadata.
   ///
   /// Always has the same size as all the component data vectors.
-  std::vector<EntityMetadata> _entities;
+  Vector<EntityMetadata> _entities;
+
+  /// The entity signatures, stored separately from the other metadata to be matched block-wise.
+  ///
+  /// The state of a bit indicates whether the component of the corresponding component type is attached to the entity.
+  /// A component is said to be attached to this entity if the bit is set, and detached if not.
+  /// This is necessary because for each entity, storage for each component type is allocated and initialized (in the vectors)
+  /// and its signature tracks if said memory is to be considered associated with the entity.
+  /// Always has the same size as the metadata vector.
+  SignatureColumn<Signature, Vector> _signatures;
+
+  /// The entity handles, passed to systems when iterating.
+  ///
+  /// Stored separately from the other metadata, so that runs of entities can be passed as a span.
+  /// Always has the same size as the metadata vector.
+  Vector<Entity> _entity_handles;
 
   /// The vectors storing component data, arranged in a tuple.
   ///
   /// For each stored component type, there is one vector storing instances of it.
+  /// For each group of component types, there is one vector storing tuples of instances of its members.
   /// All vectors always have the same size, equal to the size of the metadata vector.
-  std::tuple<std::vector<TStoredComponents>...> _components;
+  std::tuple<Column<TStoredComponents>...> _components;
 
-  /// The fragmentation counter.
+  /// The previous frame's copies of the double-buffered component types, arranged like the vectors storing component data.
+  ///
+  /// Empty stand-ins take the place of all other component types.
+  std::tuple<std::conditional_t<double_buffered<TStoredComponents>, std::vector<TStoredComponents, TAllocator<TStoredComponents>>, std::tuple<>>...> _previous;
+
+  /// The change ticks of all entities for a single component type.
+  struct ChangeTicks {
+    /// The ticks at which the components have been attached.
+    std::vector<uint64_t> added;
+    /// The ticks at which the components have been attached or accessed mutably.
+    std::vector<uint64_t> changed;
+  };
+
+  /// The change ticks of each component type, of which only those of tracked types are kept.
+  ///
+  /// The ticks of tracked types always have the same size as the metadata vector.
+  std::array<ChangeTicks, hana::length(_component_types)> _ticks;
+
+  /// The component types whose changes are tracked, as a signature.
+  Signature _tracked{};
+
+  /// The change tick stamped on attached components.
+  uint64_t _change_tick = 0;
+
+  /// The indices of the entities removed since the last `shuffle` took place, in no particular order.
   ///
-  /// Counts the amount of entity removals since the last `shuffle` took place.
   /// When entities are removed, the storage is left _fragmented_, since inactive
-  /// entities are in between active ones.
-  size_t _fragmentation = 0;
+  /// entities are in between active ones. Each removed entity is recorded exactly once.
+  std::vector<size_t> _removed;
+
+  /// The indices of the free slots of removed entities, to be reused by new entities.
+  ///
+  /// Only used if configured to reuse slots.
+  std::vector<size_t> _free;
+
+  /// The moves done by the last `shuffle` as pairs of the old and the new index of an entity.
+  ///
+  /// Kept as a member to reuse its memory.
+  std::vector<std::pair<size_t, size_t>> _moves;
+
+  /// The minimum number of entities moved by a `shuffle` for the columns to be moved concurrently.
+  static constexpr size_t _parallel_moves = 4096;
 
   /// Rearrange entity metadata and component data to have all active entities packed sequentially.
   ///
-  /// This is essentially quicksort on a list of binary values (the `active` booleans) which takes only one iteration (no recursion required).
+  /// Only the removed entities and the entities behind the new end of the storage are visited:
+  /// Each removed entity in front of the new end leaves a hole, which is filled by moving an active entity from behind it.
+  /// If configured to compact stably, all active entities behind the first hole are instead slid down in order.
+  /// The handles of all removed entities are invalidated. The components of the removed entities are discarded
+  /// when the vectors are resized afterwards.
   ///
   /// After shuffling, no inactive entity lies before an active one in the vectors.
   /// Thus all active entities can be iterated contiguously.
   /// @returns The index of the first inactive entity in the storage. This is also the
   /// number of active entities preceding it (and thus the total number of currently active stored entities).
   size_t shuffle() {
+    _moves.clear();
     // If the storage is not fragmented, return immediately.
-    if (!_fragmentation) return _entities.size();
-
-    // If the storage is empty, return immediately.
-    if (_entities.size() == 0) return 0;
-
-    // There are two iterators, initially pointing to the beginning and the end of the vectors respectively.
-    // They then move inwards toward each other and swap their elements whenever an inactive one and an active one
-    // are found with the inactive one having a lower index.
-    // The left iterator (`it_inactive`) only stops on inactive entities, while the right iterator (`it_active`) stops on active ones.
-
-    // Start out at index 0 (first element / left).
-    Entity it_inactive{0};
-    // Start out at index `_entities.size() - 1` (last element / right).
-    Entity it_active{_entities.size() - 1};
-
-    // Loop indefinetely. Return conditions are given by the iterators crossing over.
-    while (true) {
-      // Move the left iterator to the right until it hits an inactive entity.
-      while (true) {
-        // If the left iterator is further right than the right one, all entities have been processed.
-        if (it_inactive > it_active) return it_inactive;
-        // If the left iterator points to an inactive entity, stop moving.
-        if (!_entities[it_inactive].active) break;
-        // Move the left iterator to the right.
-        it_inactive++;
-      }
-      // Move the right iterator to the left until it hits an active entity.
-      while (true) {
-        // If the right iterator points to an active entity, stop moving.
-        if (_entities[it_active].active) break;
-        // TODO: Update handles.
-        // invalidateEntityHandle(it_active);
-        // If the right iterator moves overtop the left one, all entities have been processed.
-        if (it_active <= it_inactive) return it_inactive;
-        // Move the right iterator to the left.
-        it_active--;
-      }
+    if (_removed.empty()) return _entities.size();
 
-      // After moving, the right iterator points to an active entity,
-      assert(_entities[it_active].active);
-      // After moving, the left iterator points to an inactive entity,
-      assert(!_entities[it_inactive].active);
+    const size_t size = _entities.size() - _removed.size();
+    // Invalidate the handles of the removed entities before they are overwritten.
+    for (size_t index : _removed) _handles.release(_entity_handles[index]);
+    if constexpr (options.stable_compaction) {
+      // Slide each active entity behind the first hole down by the number of removed entities in front of it.
+      size_t to = *std::min_element(_removed.begin(), _removed.end());
+      for (size_t index = to + 1; index < _entities.size(); ++index)
+        if (_entities[index].active) _moves.emplace_back(index, to++);
+      assert(to == size);
+    } else {
+      // Gather the removed entities in front of the new end, whose number equals that of the active entities behind it.
+      const auto holes = std::partition(_removed.begin(), _removed.end(), [&](size_t index) { return index < size; });
+      // Pair each hole with an active entity behind the new end.
+      auto hole = _removed.begin();
+      for (size_t index = size; index < _entities.size(); ++index)
+        if (_entities[index].active) _moves.emplace_back(index, *hole++);
+      assert(hole == holes);
+    }
+    _removed.clear();
 
-      // Swap the active and the inactive entity metadata, so that the active is left of the inactive.
-      std::swap(_entities[it_active], _entities[it_inactive]);
-      // Swap each component data in a fold-expression.
-      // The lambda is called for every stored component type.
+    // Moves the metadata (for `column == sizeof...(TStoredComponents)`) or the components of a single column.
+    // Columns are independent of each other, so each column can be moved concurrently.
+    auto move_column = [&](size_t column) {
+      if (column == sizeof...(TStoredComponents)) {
+        for (const auto& [from, to] : _moves) {
+          _entities[to] = _entities[from];
+          _signatures.assign(to, _signatures[from]);
+          _entity_handles[to] = _entity_handles[from];
+          // Let the moved entity's handle resolve to its new index.
+          _handles.relocate(_entity_handles[to], to);
+          // Remember the move for translating cached queries.
+          if (!_queries.empty()) record_relocation(from, to);
+        }
+        for_each_tracked([&](ChangeTicks& ticks, const Signature&) {
+          for (const auto& [from, to] : _moves) {
+            ticks.added[to] = ticks.added[from];
+            ticks.changed[to] = ticks.changed[from];
+          }
+        });
+      } else [&]<size_t... Is>(std::index_sequence<Is...>) {
+        ((column == Is ? move_components(std::get<Is>(_components)) : void()), ...);
+      }(std::index_sequence_for<TStoredComponents...>{});
+    };
+    if (_moves.size() >= _parallel_moves) {
+      #pragma omp parallel for schedule(dynamic, 1)
+      for (size_t column = 0; column <= sizeof...(TStoredComponents); ++column) move_column(column);
+    } else {
+      for (size_t column = 0; column <= sizeof...(TStoredComponents); ++column) move_column(column);
+    }
+    return size;
+  }
+
+  /// Puts the slots of the removed entities on the free list, instead of shuffling.
+  ///
+  /// The handles of the removed entities are invalidated and their signatures cleared, so that no iteration matches them.
+  /// Components stored only for attached components are released, all other component data is left in place.
+  /// @returns The number of entities in the storage, including free slots.
+  size_t free_removed() {
+    for (size_t index : _removed) {
+      _handles.release(_entity_handles[index]);
+      _signatures.assign(index, Signature(0));
       ([&]() {
-        // Get the corresponding vector.
-        auto& component_vector = std::get<std::vector<TStoredComponents>>(_components);
-        // Swap component data to align with the metadata.
-        std::swap(component_vector[it_active], component_vector[it_inactive]);
+        auto& column = std::get<Column<TStoredComponents>>(_components);
+        if constexpr (requires { column.erase(index); }) column.erase(index);
       }(), ...);
+    }
+    _free.insert(_free.end(), _removed.begin(), _removed.end());
+    _removed.clear();
+    return _entities.size();
+  }
+
+  /// Reorders all entities, translating their handles, the free slots, the removed entities and the cached queries.
+  ///
+  /// @param order The previous index of each entity, i.e., the entity at index `i` afterwards is the one at `order[i]` before.
+  void permute(const std::vector<size_t>& order) {
+    // Permutes the metadata (for `column == sizeof...(TStoredComponents)`) or the components of a single column.
+    auto permute_column = [&](size_t column) {
+      if (column == sizeof...(TStoredComponents)) {
+        permute_elements(_entities, order);
+        permute_elements(_entity_handles, order);
+        for_each_tracked([&](ChangeTicks& ticks, const Signature&) {
+          permute_elements(ticks.added, order);
+          permute_elements(ticks.changed, order);
+        });
+        std::vector<Signature> signatures(order.size());
+        for (size_t index = 0; index < order.size(); ++index) signatures[index] = _signatures[order[index]];
+        for (size_t index = 0; index < order.size(); ++index) {
+          _signatures.assign(index, signatures[index]);
+          // Let the handles of stored entities, including removed ones, resolve to their new index. Those of free slots are released already.
+          if (_handles.is_valid(_entity_handles[index])) _handles.relocate(_entity_handles[index], index);
+        }
+        _signatures.refresh();
+      } else [&]<size_t... Is>(std::index_sequence<Is...>) {
+        ((column == Is ? permute_elements(std::get<Is>(_components), order) : void()), ...);
+      }(std::index_sequence_for<TStoredComponents...>{});
+    };
+    if (order.size() >= _parallel_moves) {
+      #pragma omp parallel for schedule(dynamic, 1)
+      for (size_t column = 0; column <= sizeof...(TStoredComponents); ++column) permute_column(column);
+    } else {
+      for (size_t column = 0; column <= sizeof...(TStoredComponents); ++column) permute_column(column);
+    }
+    translate_indices(order);
+  }
 
-      // TODO: Update handles.
-      // refreshEntityHandle(it_inactive);
-      // invalidateEntityHandle(it_active);
-      // refreshEntityHandle(it_active);
+  /// Reorders the elements of a column.
+  ///
+  /// Columns other than plain vectors know how to reorder their (possibly absent) elements themselves.
+  /// @param column The column to be reordered.
+  /// @param order The previous index of each element.
+  static void permute_elements(auto& column, const std::vector<size_t>& order) {
+    if constexpr (requires { column.permute(order); }) {
+      column.permute(order);
+    } else {
+      std::decay_t<decltype(column)> permuted;
+      permuted.reserve(column.capacity());
+      for (size_t index : order) permuted.push_back(std::move(column[index]));
+      column = std::move(permuted);
+    }
+  }
 
-      // Move iterators towards each other to continue.
-      it_inactive++;
-      it_active--;
+  /// Calls a function for each run of consecutive entities moved by the same offset in the last `shuffle`, in order.
+  ///
+  /// @param function The callable taking the old index of the first entity of the run, its new index and the run length.
+  void for_each_run(auto&& function) const {
+    for (size_t begin = 0, end; begin < _moves.size(); begin = end) {
+      for (end = begin + 1; end < _moves.size() && _moves[end].first == _moves[end - 1].first + 1
+        && _moves[end].second == _moves[end - 1].second + 1; ++end);
+      function(_moves[begin].first, _moves[begin].second, end - begin);
     }
   }
 
+  /// Moves the components of the entities moved by `shuffle` within a single column.
+  ///
+  /// The components previously stored at the targets are discarded.
+  /// @param column The column whose components to move.
+  void move_components(auto& column) {
+    // Columns other than plain vectors know how to move their (possibly absent) elements themselves.
+    if constexpr (requires { column.relocate(size_t{0}, size_t{0}); }) {
+      for (const auto& [from, to] : _moves) column.relocate(from, to);
+    } else {
+      using Element = typename std::decay_t<decltype(column)>::value_type;
+      if constexpr (options.stable_compaction) {
+        // Targets may overlap sources of earlier moves, so slide the runs of consecutive entities down in order.
+        // Trivially copyable components are relocated bytewise.
+        for_each_run([&](size_t from, size_t to, size_t count) {
+          if constexpr (std::is_trivially_copyable_v<Element>)
+            std::memmove(&column[to], &column[from], count * sizeof(Element));
+          else
+            std::move(column.begin() + from, column.begin() + from + count, column.begin() + to);
+        });
+      } else if constexpr (std::is_trivially_copyable_v<Element>)
+        // Trivially copyable components are relocated bytewise.
+        for (const auto& [from, to] : _moves) std::memcpy(&column[to], &column[from], sizeof(Element));
+      else
+        for (const auto& [from, to] : _moves) column[to] = std::move(column[from]);
+    }
+  }
+
+  /// Whether the changes of a component type are tracked.
+  ///
+  /// @tparam TComponent The component type to be checked.
+  template<typename TComponent>
+  bool tracks() const {
+    return (_tracked & signature_of<TComponent>) == signature_of<TComponent>;
+  }
+
+  /// Calls a function with the change ticks of each tracked component type.
+  ///
+  /// @param function The callable taking the `ChangeTicks` of a component type, and its signature.
+  void for_each_tracked(auto&& function) {
+    if (_tracked == Signature{}) return;
+    hana::for_each(_component_types, [&](auto type) {
+      using Component = typename decltype(type)::type;
+      if (tracks<Component>()) function(_ticks[_component_index<Component>], signature_of<Component>);
+    });
+  }
+
+  /// Stamps the current change tick on the tracked components of an entity about to be assigned.
+  ///
+  /// Components not attached to the entity before also count as added.
+  /// @param index The index of the entity.
+  /// @param assigned The signature of the component types assigned.
+  void stamp_changes(size_t index, const Signature& assigned) {
+    for_each_tracked([&](ChangeTicks& ticks, const Signature& signature) {
+      if ((assigned & signature) != signature) return;
+      ticks.changed[index] = _change_tick;
+      if ((_signatures[index] & signature) != signature) ticks.added[index] = _change_tick;
+    });
+  }
+
+  /// Resizes the change ticks of all tracked component types, counting the components of new entities as added.
+  ///
+  /// @param size The new number of entities.
+  void resize_ticks(size_t size) {
+    for_each_tracked([&](ChangeTicks& ticks, const Signature&) {
+      ticks.added.resize(size, _change_tick);
+      ticks.changed.resize(size, _change_tick);
+    });
+  }
+
+  /// Counts the components of all entities as added, e.g., after replacing all entities.
+  void reset_ticks() {
+    for_each_tracked([&](ChangeTicks& ticks, const Signature&) {
+      ticks.added.assign(_entities.size(), _change_tick);
+      ticks.changed.assign(_entities.size(), _change_tick);
+    });
+  }
+
+  /// Returns a reference to the component of some type stored at an index.
+  ///
+  /// @tparam TComponent The component type to be accessed.
+  /// @param index The index of the entity.
+  template<typename TComponent>
+  TComponent& component_at(size_t index) {
+    using Column = std::tuple_element_t<_column_index<TComponent>, std::tuple<TStoredComponents...>>;
+    return ColumnTraits<Column>::template get<TComponent>(std::get<_column_index<TComponent>>(_components)[index]);
+  }
+
+  /// Assigns the component of some type stored at an index.
+  ///
+  /// @tparam TComponent The component type to be assigned.
+  /// @param index The index of the entity.
+  /// @param component The component data to be assigned.
+  template<typename TComponent>
+  void assign_component(size_t index, auto&& component) {
+    auto& column = std::get<_column_index<TComponent>>(_components);
+    // Tags have no data to be assigned.
+    if constexpr (is_tag<TComponent>) return;
+    // Columns other than plain vectors store their elements themselves, possibly inserting them.
+    else if constexpr (requires { column.store(index, component); })
+      column.store(index, std::forward<decltype(component)>(component));
+    else
+      component_at<TComponent>(index) = std::forward<decltype(component)>(component);
+  }
+
+  /// Appends the metadata of multiple new entities with the same set of component types.
+  ///
+  /// The component columns are not grown.
+  /// @tparam TComponents The component types to be attached to the new entities.
+  /// @param count The number of entities to be appended.
+  /// @returns The index of the first new entity.
+  template<typename... TComponents>
+  size_t append_entities(size_t count) {
+    const size_t begin = _entities.size();
+    // Reserve at least geometrically, so that repeated small batches do not reallocate every time.
+    if (_entities.capacity() < begin + count) reserve(std::max(begin + count, 2 * _entities.capacity()));
+    _entities.resize(begin + count);
+    for (size_t index = begin; index < begin + count; ++index) {
+      _signatures.push_back(signature_of<TComponents...>);
+      _entity_handles.push_back(_handles.create(index));
+    }
+    resize_ticks(begin + count);
+    return begin;
+  }
+
+  /// Creates and activates multiple new entities with components returned by a generator.
+  ///
+  /// Free slots are filled one by one first, the remaining entities are appended at once.
+  /// @tparam parallel Whether to call the generator and assign the components of appended entities concurrently.
+  /// @param total The number of entities to be created.
+  /// @param generator The callable returning the initial components of the `i`-th new entity as a `std::tuple`, given `i`.
+  template<bool parallel>
+  void generate_entities(size_t total, auto& generator) {
+    using Components = std::decay_t<decltype(generator(size_t{0}))>;
+    // Reuse the slots of removed entities first.
+    size_t reused = 0;
+    if constexpr (options.free_list)
+      for (; reused < total && !_free.empty(); ++reused)
+        std::apply([&](auto&&... components) { new_entity(std::move(components)...); }, generator(reused));
+    const size_t count = total - reused;
+    if (!count) return;
+    const size_t begin = [&]<typename... TComponents>(std::tuple<TComponents...>*) {
+      return append_entities<TComponents...>(count);
+    }(static_cast<Components*>(nullptr));
+    (std::get<Column<TStoredComponents>>(_components).resize(begin + count), ...);
+    // Assign the generated components of a single entity.
+    auto generate = [&](size_t i) {
+      std::apply([&](auto&&... components) {
+        (assign_component<std::decay_t<decltype(components)>>(begin + i, std::move(components)), ...);
+      }, generator(reused + i));
+    };
+    // Sparse sets insert into shared vectors, so they can not be filled concurrently.
+    constexpr bool concurrent = parallel && ![]<typename... TComponents>(std::tuple<TComponents...>*) {
+      return (_sparse<TComponents> || ...);
+    }(static_cast<Components*>(nullptr));
+    if constexpr (concurrent) {
+      #pragma omp parallel for
+      for (size_t i = 0; i < count; ++i) generate(i);
+    } else {
+      for (size_t i = 0; i < count; ++i) generate(i);
+    }
+    // Track the entities in the queries they match.
+    if (!_queries.empty())
+      for (size_t index = begin; index < begin + count; ++index) update_queries(index);
+  }
+
+  /// Sets all active entities with all required components attached which satisfy a predicate as inactive.
+  ///
+  /// Only the activeness of the tested entities is written, so they can be tested concurrently.
+  /// The queries listing removed entities are marked once afterwards, and the removed entities are recorded for shuffling.
+  /// @tparam parallel Whether to test the entities concurrently.
+  /// @tparam TRequiredComponents The set of component types required to be attached to an entity to be tested.
+  /// @param predicate The callable returning whether to remove an entity, given const references to its required components.
+  template<bool parallel, typename... TRequiredComponents>
+  void mark_removed_if(auto& predicate) {
+    static_assert(sizeof...(TRequiredComponents) > 0, "Removing entities requires at least one component type to be tested.");
+    constexpr Signature signature = signature_of<TRequiredComponents...>;
+    // The union of the queries listing removed entities.
+    uint64_t queries = 0;
+    // Tests the entities at the given indices, which need not match the signature.
+    auto mark = [&](const auto& candidates) {
+      auto test = [&](size_t index, std::vector<size_t>& removed, uint64_t& queries) {
+        EntityMetadata& metadata = _entities[index];
+        if (!metadata.active || (_signatures[index] & signature) != signature) return;
+        if (!predicate(read_component<TRequiredComponents>(index)...)) return;
+        metadata.active = false;
+        queries |= metadata.queries;
+        removed.push_back(index);
+      };
+      if constexpr (parallel) {
+        // Each thread records its removed entities separately, which are appended once it is done.
+        #pragma omp parallel
+        {
+          std::vector<size_t> removed;
+          uint64_t removed_queries = 0;
+          #pragma omp for nowait
+          for (size_t i = 0; i < candidates.size(); ++i) test(candidates[i], removed, removed_queries);
+          #pragma omp critical
+          {
+            _removed.insert(_removed.end(), removed.begin(), removed.end());
+            queries |= removed_queries;
+          }
+        }
+      } else {
+        for (size_t i = 0; i < candidates.size(); ++i) test(candidates[i], _removed, queries);
+      }
+    };
+    // Only test the entities listed by a cached query or by the smallest required sparse set, if any.
+    if (const Query* query = find_query(signature)) mark(query->entities);
+    else if constexpr ((_sparse<TRequiredComponents> || ...)) mark(sparsest<TRequiredComponents...>());
+    else mark(std::views::iota(size_t{0}, _entities.size()));
+    // Mark the queries listing removed entities, so that they are dropped on refresh.
+    for (size_t index = 0; index < _queries.size(); ++index)
+      if (queries & (uint64_t{1} << index)) _queries[index].dirty = true;
+  }
+
+  /// Returns a component of some type stored at an index for reading.
+  ///
+  /// Components in AoSoA blocks are returned as a copy, all others as a const reference.
+  /// @tparam TComponent The component type to be read.
+  /// @param index The index of the entity.
+  template<typename TComponent>
+  decltype(auto) read_component(size_t index) {
+    if constexpr (_blocked<TComponent>) return std::as_const(std::get<_column_index<TComponent>>(_components)).load(index);
+    else return std::as_const(component_at<TComponent>(index));
+  }
+
+  /// Releases the component of some type stored at an index, if its column stores only attached components.
+  ///
+  /// @tparam TComponent The component type to be released.
+  /// @param index The index of the entity.
+  template<typename TComponent>
+  void erase_component(size_t index) {
+    auto& column = std::get<_column_index<TComponent>>(_components);
+    if constexpr (requires { column.erase(index); }) column.erase(index);
+  }
+
+  /// Returns the smallest sparse set of a set of component types.
+  ///
+  /// @tparam TComponents The component types, at least one of which must be stored in a sparse set.
+  /// Excluded component types (wrapped into `Without`) are skipped.
+  /// @returns The indices of the entities stored in the smallest sparse set.
+  template<typename... TComponents>
+  const std::vector<uint32_t>& sparsest() const {
+    const std::vector<uint32_t>* owners = nullptr;
+    ([&]() {
+      if constexpr (_sparse_query<TComponents>) {
+        const auto& column = std::get<_column_index<typename QueryTraits<TComponents>::Component>>(_components);
+        if (!owners || column.size() < owners->size()) owners = &column.owners();
+      }
+    }(), ...);
+    return *owners;
+  }
+
+  /// Returns the number of AoSoA blocks needed to store all entities, the last of which may be partially used.
+  size_t block_count() const {
+    return (_entities.size() + block_lanes - 1) / block_lanes;
+  }
+
+  /// Matches the entities of a block against a signature.
+  ///
+  /// @param block The index of the block.
+  /// @param signature The signature to be matched.
+  /// @param excluded The signature whose bits must all be off.
+  /// @returns A bit mask with bit `i` set if the entity in the `i`-th lane of the block matches.
+  uint64_t match_block(size_t block, const Signature& signature, const Signature& excluded) const {
+    const size_t begin = block * block_lanes;
+    return _signatures.match(begin, std::min(block_lanes, _entities.size() - begin), signature, excluded);
+  }
+
+  /// Returns the cached query of a signature or a null pointer if it is not cached.
+  ///
+  /// @param signature The signature of the required component types.
+  const Query* find_query(const Signature& signature) const {
+    for (const Query& query : _queries)
+      if (query.signature == signature) return &query;
+    return nullptr;
+  }
+
+  /// Lists an entity in all cached queries it matches and marks the ones it no longer matches.
+  ///
+  /// This is called after each change to an entity's signature.
+  /// @param entity The index of the entity.
+  void update_queries(size_t entity) {
+    EntityMetadata& metadata = _entities[entity];
+    for (size_t index = 0; index < _queries.size(); ++index) {
+      Query& query = _queries[index];
+      const uint64_t bit = uint64_t{1} << index;
+      const bool matches = (_signatures[entity] & query.signature) == query.signature;
+      if (matches && !(metadata.queries & bit)) {
+        // Appending keeps the list in order only if the entity is the one with the highest index.
+        if (!query.entities.empty() && query.entities.back() > entity) query.dirty = true;
+        query.entities.push_back(entity);
+        metadata.queries |= bit;
+      } else if (!matches && (metadata.queries & bit)) {
+        // The entity is dropped from the list on refresh.
+        query.dirty = true;
+      }
+    }
+  }
+
+  /// Drops inactive and non-matching entities from a cached query.
+  ///
+  /// @param query The query to be filtered.
+  void filter_query(Query& query) {
+    const uint64_t bit = uint64_t{1} << (&query - _queries.data());
+    std::erase_if(query.entities, [&](size_t entity) {
+      EntityMetadata& metadata = _entities[entity];
+      if (metadata.active && (_signatures[entity] & query.signature) == query.signature) return false;
+      metadata.queries &= ~bit;
+      return true;
+    });
+  }
+
+  /// Translates a cached query to the entity indices after shuffling and restores its order.
+  ///
+  /// Unless compacting stably, only entities beyond the new size have moved. Since the query is ordered,
+  /// these are at the end of the list.
+  /// @param query The (filtered) query to be translated.
+  /// @param size The number of entities after shuffling.
+  void relocate_query(Query& query, size_t size) {
+    auto& entities = query.entities;
+    if constexpr (options.stable_compaction) {
+      // Stable compaction keeps the order, and every active entity from the first moved one on has moved.
+      const size_t first = _moves.empty() ? size : _moves.front().first;
+      if (query.dirty) {
+        for (size_t& entity : entities)
+          if (entity >= first) entity = relocation_of(entity);
+        std::sort(entities.begin(), entities.end());
+      } else {
+        for (auto it = std::lower_bound(entities.begin(), entities.end(), first); it != entities.end(); ++it)
+          *it = relocation_of(*it);
+      }
+    } else if (query.dirty) {
+      for (size_t& entity : entities)
+        if (entity >= size) entity = relocation_of(entity);
+      std::sort(entities.begin(), entities.end());
+    } else {
+      auto moved = std::lower_bound(entities.begin(), entities.end(), size);
+      for (auto it = moved; it != entities.end(); ++it) *it = relocation_of(*it);
+      // The moved entities fill holes in between, so merge them back in.
+      std::sort(moved, entities.end());
+      std::inplace_merge(entities.begin(), moved, entities.end());
+    }
+    query.dirty = false;
+  }
+
+  /// Translates the free slots, the removed entities and the cached queries to the entity indices after reordering.
+  ///
+  /// @param order The previous index of each entity.
+  void translate_indices(const std::vector<size_t>& order) {
+    std::vector<size_t> position(order.size());
+    for (size_t index = 0; index < order.size(); ++index) position[order[index]] = index;
+    for (size_t& index : _free) index = position[index];
+    for (size_t& index : _removed) index = position[index];
+    for (Query& query : _queries) {
+      for (size_t& entity : query.entities) entity = position[entity];
+      std::sort(query.entities.begin(), query.entities.end());
+    }
+  }
+
+  /// Records the move of an entity during shuffling.
+  ///
+  /// The new size is not known during shuffling, so moves are indexed relative to the end of the vectors.
+  /// @param from The index the entity is moved from.
+  /// @param to The index the entity is moved to.
+  void record_relocation(size_t from, size_t to) {
+    const size_t offset = _entities.size() - 1 - from;
+    if (_relocations.size() <= offset) _relocations.resize(offset + 1);
+    _relocations[offset] = to;
+  }
+
+  /// Returns the index an entity has been moved to by the last shuffle.
+  ///
+  /// Requires the vectors not to be resized since shuffling.
+  /// @param entity The index of the entity before shuffling.
+  size_t relocation_of(size_t entity) const {
+    return _relocations[_entities.size() - 1 - entity];
+  }
+
   /// Reserve a given capacity on all vectors.
   ///
   /// @param capacity The new capacity to be reserved.
   void reserve(size_t capacity) {
-    // Reserve entity metadata vector.
+    // Reserve entity metadata vector and handle table.
     _entities.reserve(capacity);
+    _signatures.reserve(capacity);
+    _entity_handles.reserve(capacity);
+    _handles.reserve(capacity);
     // Reserve component data vectors using a fold expression.
-    (std::get<std::vector<TStoredComponents>>(_components).reserve(capacity), ...);
+    (std::get<Column<TStoredComponents>>(_components).reserve(capacity), ...);
   }
 };
 
+namespace internal {
+
+  /// Tuple of vectors storage configuration class.
+  template<VectorOptions options = vector_options, template<typename> typename TAllocator = std::allocator>
+  class TupleOfVectorsCustom {
+  public:
+    /// The configured storage.
+    template<typename... TComponents>
+    using Storage = BasicTupleOfVectors<options, TAllocator, TComponents...>;
+
+    /// This class but with slot reuse through a free list configured.
+    using WithFreeList = TupleOfVectorsCustom<options.use_free_list(), TAllocator>;
+
+    /// This class but with order-preserving compaction configured.
+    using WithStableCompaction = TupleOfVectorsCustom<options.use_stable_compaction(), TAllocator>;
+
+    /// This class but with memory-mapped columns configured, which can be backed by files.
+    using WithMappedColumns = TupleOfVectorsCustom<options.use_mapped_columns(), TAllocator>;
+
+    /// This class but with the component vectors allocated by another allocator (e.g., `AlignedAllocator`).
+    ///
+    /// Memory-mapped columns are not allocated by it.
+    template<template<typename> typename TOtherAllocator>
+    using WithAllocator = TupleOfVectorsCustom<options, TOtherAllocator>;
+  };
+
+}
+
+/// Tuple of vectors storage with custom options.
+///
+/// This avoids having to write `<>` after TupleOfVectorsCustom when using.
+using TupleOfVectorsCustom = internal::TupleOfVectorsCustom<>;
+
+/// Tuple of vectors storage with default options.
+template<typename... TStoredComponents>
+using TupleOfVectors = BasicTupleOfVectors<internal::vector_options, std::allocator, TStoredComponents...>;
+
 }
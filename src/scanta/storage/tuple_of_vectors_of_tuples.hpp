@@ -0,0 +1,79 @@
+#pragma once
+
+#include <memory>
+
+#include <boost/hana.hpp>
+namespace hana = boost::hana;
+
+#include "scanta/storage/tuple_of_vectors.hpp"
+#include "scanta/util/group.hpp"
+
+namespace scanta::storage {
+
+/// Stores components in multiple equally-sized vectors, interleaving component types that are accessed together.
+///
+/// This is a `TupleOfVectors` whose grouping of component types is inferred by the scheduler at compile-time:
+/// component types that are required by exactly the same set of systems are always accessed together,
+/// and thus share one vector of tuples (see `Info::component_groups`). All other component types are
+/// stored in separate vectors.
+///
+/// @tparam TAllocator The allocator template allocating the component vectors (see `allocator.hpp`).
+/// @tparam TStoredComponents The component types (or `Group`s of component types) to be stored.
+template<template<typename> typename TAllocator, typename... TStoredComponents>
+class BasicTupleOfVectorsOfTuples : public BasicTupleOfVectors<internal::vector_options, TAllocator, TStoredComponents...> {
+public:
+  /// Marks the storage to be instantiated with component types grouped by the systems accessing them.
+  static constexpr bool infer_groups = true;
+
+  using BasicTupleOfVectors<internal::vector_options, TAllocator, TStoredComponents...>::BasicTupleOfVectors;
+};
+
+namespace internal {
+
+  /// Tuple of vectors of tuples storage configuration class.
+  ///
+  /// @tparam TAllocator The allocator template allocating the component vectors.
+  /// @tparam TGroups The `Group`s of component types to be stored interleaved.
+  template<template<typename> typename TAllocator, typename... TGroups>
+  class TupleOfVectorsOfTuplesCustom {
+  private:
+    /// A tuple of vectors storage of the configured allocator, with the columns arranged already.
+    template<typename... TColumns>
+    using Arranged = BasicTupleOfVectors<vector_options, TAllocator, TColumns...>;
+  public:
+    /// The configured storage, with explicitly chosen groups.
+    template<typename... TComponents>
+    using Storage = typename decltype(hana::unpack(
+      arrange_columns(hana::make_tuple(ColumnTraits<TGroups>::components...), hana::tuple_t<TComponents...>),
+      hana::template_<Arranged>
+    ))::type;
+
+    /// The configured storage, with groups inferred instead of chosen (see `BasicTupleOfVectorsOfTuples`).
+    template<typename... TComponents>
+    using InferredStorage = BasicTupleOfVectorsOfTuples<TAllocator, TComponents...>;
+
+    /// This class but with the component vectors allocated by another allocator (e.g., `AlignedAllocator`).
+    template<template<typename> typename TOtherAllocator>
+    using WithAllocator = TupleOfVectorsOfTuplesCustom<TOtherAllocator, TGroups...>;
+  };
+
+}
+
+/// Tuple of vectors of tuples storage with explicitly chosen groups instead of inferred ones.
+///
+/// Component types not in any group are stored in separate vectors. Group members which are not stored are ignored.
+/// ```cpp
+/// using ECS = scanta::EntityComponentSystem<
+///   scanta::storage::TupleOfVectorsOfTuplesCustom<scanta::Group<Transform, RigidBody>>::Storage,
+///   scanta::scheduler::Sequential
+/// >;
+/// ```
+/// @tparam TGroups The `Group`s of component types to be stored interleaved.
+template<typename... TGroups>
+using TupleOfVectorsOfTuplesCustom = internal::TupleOfVectorsOfTuplesCustom<std::allocator, TGroups...>;
+
+/// Tuple of vectors of tuples storage with default options.
+template<typename... TStoredComponents>
+using TupleOfVectorsOfTuples = BasicTupleOfVectorsOfTuples<std::allocator, TStoredComponents...>;
+
+}
@@ -3,7 +3,15 @@
 #include <iostream>
 #include <tuple>
 #include <vector>
+#include <algorithm>
+#include <cstdint>
 #include <cassert>
+#include <filesystem>
+#include <memory>
+#include <ranges>
+#include <stdexcept>
+#include <string>
+#include <utility>
 
 #include <bitset2/bitset2.hpp>
 
@@ -12,14 +20,24 @@ namespace hana = boost::hana;
 using namespace hana::literals;
 
 #include "scanta/util/type_index.hpp"
+#include "scanta/util/handle_table.hpp"
+#include "scanta/util/signature_column.hpp"
+#include "scanta/util/tag.hpp"
+#include "scanta/util/vector_options.hpp"
+#include "scanta/util/snapshot.hpp"
+#include "scanta/util/query.hpp"
 
 namespace scanta::storage {
 
 /// TODO: Stores component data in a vector of entity tuples.
 ///
+/// Tag component types (empty types) are stored as signature bits only and take up no space in the tuples.
+/// Unless configured to reuse the slots of removed entities (see `VectorOptions`), the vector is compacted on refresh.
+/// @tparam options The vector storage options to be used.
+/// @tparam TAllocator The allocator template allocating the vector of tuples (see `allocator.hpp`).
 /// @tparam TStoredComponents The component types to be stored.
-template<typename... TStoredComponents>
-class VectorOfTuples {
+template<internal::VectorOptions options, template<typename> typename TAllocator, typename... TStoredComponents>
+class BasicVectorOfTuples {
 private:
   /// The list of stored component types as a hana::tuple_t.
   ///
@@ -29,8 +47,8 @@ private:
 
   /// The entity signature type.
   ///
-  /// A bitset with a single bit for each component type.
-  using Signature = Bitset2::bitset2<sizeof...(TStoredComponents)>;
+  /// A bitset with a single bit for each component type, which is a machine word for up to 64 component types.
+  using Signature = SignatureOf<sizeof...(TStoredComponents)>;
 
   /// Field for accessing the index of a component type within the list of stored component types.
   ///
@@ -46,33 +64,65 @@ private:
   // Use a fold expression (https://en.cppreference.com/w/cpp/language/fold) to construct the signature.
   // The bitset accumulator starts out at all zero. For each component type a corresponding signature
   // with just that bit set is created by shifting and included in the accumulator using a bitwise OR.
-  static constexpr Signature signature_of = (Signature(0) |= ... |= (Signature(1) << _component_index<TComponents>));
+  static constexpr Signature signature_of = []() {
+    Signature signature(0);
+    ((signature |= Signature(1) << _component_index<TComponents>), ...);
+    return signature;
+  }();
+
+  /// The signature of the component types required by a query, i.e., of all entries except for exclusions (see `QueryTraits`).
+  ///
+  /// @tparam TQuery The entries of the query, each a component type or `Without` one.
+  template<typename... TQuery>
+  static constexpr Signature required_of = (Signature(0) | ... | (QueryTraits<TQuery>::excluded ? Signature(0) : signature_of<typename QueryTraits<TQuery>::Component>));
+
+  /// The signature of the component types excluded by a query.
+  ///
+  /// @tparam TQuery The entries of the query, each a component type or `Without` one.
+  template<typename... TQuery>
+  static constexpr Signature excluded_of = (Signature(0) | ... | (QueryTraits<TQuery>::excluded ? signature_of<typename QueryTraits<TQuery>::Component> : Signature(0)));
 public:
   /// The handle type for systems to reference entities with.
-  using Entity = size_t;
+  ///
+  /// Handles are resolved to entity indices through a handle table, so they stay valid when shuffling moves entities.
+  using Entity = GenerationalHandle;
+
+  /// Queries may exclude component types by listing them wrapped into `Without`, which is folded into matching signatures.
+  static constexpr bool matches_exclusions = true;
 
   /// Constructs a storage with no components initially stored.
   ///
   /// @param capacity The initial entity capacity for which to allocate memory for.
-  VectorOfTuples(size_t capacity = 32) {
+  BasicVectorOfTuples(size_t capacity = 32) {
     _data.reserve(capacity);
+    _signatures.reserve(capacity);
+    _handles.reserve(capacity);
   }
 
   /// Returns the number of active entities currently stored.
   ///
   /// @returns The number of active entities currently stored.
   size_t get_size() {
-    return _data.size();
+    return _data.size() - _free.size();
+  }
+
+  /// Test whether or not an entity is stored, i.e., its handle has not been invalidated by reclaiming the entity.
+  ///
+  /// Removed entities are stored until the next refresh. Handles of reclaimed entities stay invalid when their slot is reused.
+  /// @param entity The entity to be queried.
+  bool has_entity(Entity entity) const {
+    return _handles.is_valid(entity);
   }
 
   /// Test whether or not a component of some type is attached to an entity.
   ///
+  /// This is false for entities which are not stored anymore.
   /// @param entity The entity to be queried.
   /// @tparam TComponent The component type to be queried.
   template<typename TComponent>
   bool has_component(Entity entity) const {
     // TODO: static_assert component type handled
-    return std::get<EntityMetadata>(_data[entity]).signature[_component_index<TComponent>];
+    return has_entity(entity) && (_signatures[_handles.index_of(entity)] & signature_of<TComponent>) == signature_of<TComponent>;
   }
 
   /// Returns a reference to a single component of some entity.
@@ -83,7 +133,7 @@ public:
   template<typename TComponent>
   TComponent& get_component(Entity entity) {
     // TODO: static_assert component type handled
-    return std::get<TComponent>(_data[entity]);
+    return component_at<TComponent>(_handles.index_of(entity));
   }
 
   /// Sets the component data for a single component of some entity.
@@ -95,10 +145,13 @@ public:
   template<typename TComponent>
   void attach_component(Entity entity, TComponent&& component) {
     // TODO: static_assert component type stored
+    const size_t index = _handles.index_of(entity);
     // Set the associated component bit in the entity signature.
-    std::get<EntityMetadata>(_data[entity]).signature |= signature_of<std::decay_t<TComponent>>;
+    _signatures.assign(index, _signatures[index] | signature_of<std::decay_t<TComponent>>);
     // Assign component from the parameter.
-    get_component<std::decay_t<TComponent>>(entity) = std::forward<TComponent>(component);
+    assign_component<std::decay_t<TComponent>>(index, std::forward<TComponent>(component));
+    // Track the entity in queries it now matches.
+    update_queries(index);
   }
 
   /// Sets the component data for some entity.
@@ -110,51 +163,216 @@ public:
   template<typename... TComponents>
   void set_components(Entity entity, TComponents&&... components) {
     // TODO: static_assert component type stored
+    const size_t index = _handles.index_of(entity);
     // Set the associated component bits in the entity signature.
-    std::get<EntityMetadata>(_data[entity]).signature = signature_of<std::decay_t<TComponents>...>;
-    // Set all passed in components using a fold expression.
-    (attach_component(entity, std::forward<TComponents>(components)), ...);
+    _signatures.assign(index, signature_of<std::decay_t<TComponents>...>);
+    // Assign all passed in components using a fold expression.
+    (assign_component<std::decay_t<TComponents>>(index, std::forward<TComponents>(components)), ...);
+    // Track the entity in queries it now matches and mark the ones it no longer matches.
+    update_queries(index);
   }
 
   /// Removes a component association from some entity.
   ///
-  /// This disables the component on the entity by mutating the entity signature stored in the metadata.
+  /// This disables the component on the entity by mutating the entity signature.
   /// The component data is not cleared and its memory not released.
   /// This operation is idempotent.
   template<typename TComponent>
   void detach_component(Entity entity) {
     // TODO: static_assert component type stored
+    const size_t index = _handles.index_of(entity);
     // Unset the associated component bit in the entity signature.
-    std::get<EntityMetadata>(_data[entity]).signature &= !signature_of<std::decay_t<TComponent>>;
+    _signatures.assign(index, _signatures[index] & ~signature_of<std::decay_t<TComponent>>);
+    // Mark the queries the entity no longer matches.
+    update_queries(index);
   }
 
-  // TODO: return entity?
   /// Creates and activates a new entity.
   ///
   /// If necessary, this will allocate memory.
   /// Requires the entity slot at index `_size` to be inactive.
   /// @param components The set of components to be initially associated with the new entity.
-  void new_entity(auto&&... components) {
-    // Default-construct a new entity tuple.
+  /// @returns The handle of the new entity.
+  Entity new_entity(auto&&... components) {
+    // Reuse the slot of a removed entity, if any.
+    if constexpr (options.free_list) {
+      if (!_free.empty()) {
+        const size_t index = _free.back();
+        _free.pop_back();
+        EntityMetadata& metadata = std::get<EntityMetadata>(_data[index]);
+        metadata = EntityMetadata{};
+        Entity entity = metadata.handle = _handles.create(index);
+        set_components(entity, std::forward<decltype(components)>(components)...);
+        return entity;
+      }
+    }
+    // Default-construct a new entity tuple with an empty signature.
     _data.emplace_back();
+    _signatures.push_back(Signature(0));
+    // Create a handle resolving to the new entity's index.
+    Entity entity = std::get<EntityMetadata>(_data.back()).handle = _handles.create(_data.size() - 1);
     // Set the initial components from the parameters.
-    set_components(_data.size() - 1, std::forward<decltype(components)>(components)...);
+    set_components(entity, std::forward<decltype(components)>(components)...);
+    return entity;
+  }
+
+  /// Creates and activates multiple new entities with the same set of component types.
+  ///
+  /// Memory is reserved once for all new entities.
+  /// @param count The number of entities to be created.
+  /// @param generator The callable returning the initial components of the `i`-th new entity as a `std::tuple`, given `i`.
+  void new_entities(size_t count, auto&& generator) {
+    generate_entities<false>(count, generator);
+  }
+
+  /// Creates and activates multiple new entities with the same set of component types.
+  /// Employs inner parallelism.
+  ///
+  /// Memory is reserved once for all new entities.
+  /// @param count The number of entities to be created.
+  /// @param generator The callable returning the initial components of the `i`-th new entity as a `std::tuple`, given `i`.
+  /// It is called concurrently for different `i`.
+  void new_entities_parallel(size_t count, auto&& generator) {
+    generate_entities<true>(count, generator);
+  }
+
+  /// Creates and activates multiple new entities from columns of components.
+  ///
+  /// The `i`-th new entity is associated with the `i`-th component of each column.
+  /// The components are moved into the entity tuples. Free slots are filled first.
+  /// @param columns The initial components of the new entities, one equally-sized vector per component type.
+  template<typename... TComponents>
+  void new_entities(std::vector<TComponents>&&... columns) {
+    const size_t total = std::get<0>(std::tie(columns...)).size();
+    assert(((columns.size() == total) && ...));
+    // Reuse the slots of removed entities first.
+    size_t reused = 0;
+    if constexpr (options.free_list)
+      for (; reused < total && !_free.empty(); ++reused) new_entity(std::move(columns[reused])...);
+    const size_t count = total - reused;
+    if (!count) return;
+    const size_t begin = append_entities<TComponents...>(count);
+    for (size_t i = 0; i < count; ++i)
+      (assign_component<TComponents>(begin + i, std::move(columns[reused + i])), ...);
+    // Track the entities in the queries they match.
+    if (!_queries.empty())
+      for (size_t index = begin; index < begin + count; ++index) update_queries(index);
   }
 
   /// Removes an entity from the storage.
   ///
-  /// This merely sets the entity as inactive. Shuffling will later reclaim the storage space.
+  /// This merely sets the entity as inactive and records its index. Shuffling will later reclaim the storage space.
   void remove_entity(Entity entity) {
+    const size_t index = _handles.index_of(entity);
+    EntityMetadata& metadata = std::get<EntityMetadata>(_data[index]);
+    // Ignore repeated removals of the same entity.
+    if (!metadata.active) return;
     // Set the entity as inactive.
-    std::get<EntityMetadata>(_data[entity]).active = false;
-    // Increment the fragmentation counter.
-    ++_fragmentation;
+    metadata.active = false;
+    // Mark the queries listing the entity, so that it is dropped on refresh.
+    for (size_t query = 0; query < _queries.size(); ++query)
+      if (metadata.queries & (uint64_t{1} << query)) _queries[query].dirty = true;
+    // Record the removal for shuffling.
+    _removed.push_back(index);
+  }
+
+  /// Removes all entities with all required components attached which satisfy a predicate.
+  ///
+  /// Like `remove_entity`, this merely sets the entities as inactive, so that they are reclaimed by a single shuffle on refresh.
+  /// @tparam TRequiredComponents The set of component types required to be attached to an entity to be tested.
+  /// @param predicate The callable returning whether to remove an entity, given const references to its required components.
+  template<typename... TRequiredComponents>
+  void remove_entities_if(auto&& predicate) {
+    mark_removed_if<false, TRequiredComponents...>(predicate);
+  }
+
+  /// Removes all entities with all required components attached which satisfy a predicate.
+  /// Employs inner parallelism.
+  ///
+  /// Like `remove_entity`, this merely sets the entities as inactive, so that they are reclaimed by a single shuffle on refresh.
+  /// @tparam TRequiredComponents The set of component types required to be attached to an entity to be tested.
+  /// @param predicate The callable returning whether to remove an entity, given const references to its required components.
+  /// It is called concurrently for different entities.
+  template<typename... TRequiredComponents>
+  void remove_entities_if_parallel(auto&& predicate) {
+    mark_removed_if<true, TRequiredComponents...>(predicate);
+  }
+
+  /// Reorders the entities by a key over one of their components, to improve the locality of iteration.
+  ///
+  /// For example, ordering entities by a Morton code of their position lets systems touching spatially nearby
+  /// entities together stream through memory. Entities without the component attached and removed entities
+  /// are placed behind all others, and entities with equal keys keep their relative order. Handles stay valid,
+  /// including those of removed entities, which are left to be reclaimed by the next refresh.
+  /// The permutation is applied in a single pass over the entity tuples.
+  /// @tparam TComponent The component type the key is computed from.
+  /// @param key The callable returning the key of an entity, given a const reference to its component.
+  /// Keys are compared with `<`.
+  template<typename TComponent>
+  void sort_entities(auto&& key) {
+    using Key = std::decay_t<decltype(key(std::as_const(component_at<TComponent>(0))))>;
+    constexpr Signature signature = signature_of<TComponent>;
+    const size_t size = _data.size();
+    std::vector<std::pair<Key, size_t>> keys;
+    for (size_t index = 0; index < size; ++index)
+      if (std::get<EntityMetadata>(_data[index]).active && (_signatures[index] & signature) == signature) keys.emplace_back(key(std::as_const(component_at<TComponent>(index))), index);
+    std::stable_sort(keys.begin(), keys.end(), [](const auto& first, const auto& second) { return first.first < second.first; });
+    // The previous index of each entity in the new order.
+    std::vector<size_t> order;
+    order.reserve(size);
+    for (const auto& [_, index] : keys) order.push_back(index);
+    for (size_t index = 0; index < size && order.size() < size; ++index)
+      if (!std::get<EntityMetadata>(_data[index]).active || (_signatures[index] & signature) != signature) order.push_back(index);
+    // If the entities are in order already, e.g. when sorting every frame, there is nothing to move.
+    if (!std::ranges::equal(order, std::views::iota(size_t{0}, size))) permute(order);
+  }
+
+  /// Captures a consistent copy of the storage, to be written to a file off the frame thread.
+  ///
+  /// The storage is refreshed first. The entity tuples are captured by a single copy of the vector,
+  /// and serialized member by member when written. Cached queries are not captured, but relisted on restore.
+  /// @param snapshot A snapshot written before, whose memory is reused (see `SnapshotWriter::recycle`).
+  /// @returns The snapshot, to be written by `Snapshot::write` or a `SnapshotWriter`.
+  Snapshot snapshot(Snapshot snapshot = {}) requires (is_serializable<TStoredComponents> && ...) {
+    refresh();
+    snapshot.clear();
+    snapshot.capture(_data);
+    _signatures.capture(snapshot);
+    _handles.capture(snapshot);
+    snapshot.capture(_free);
+    return snapshot;
+  }
+
+  /// Replaces all entities by the ones captured in a snapshot file.
+  ///
+  /// Handles of the captured entities are valid again afterwards. Cached queries are kept, and list the restored entities.
+  /// @param path The path of the snapshot file, captured from a storage of the same component types and options.
+  /// @throws std::runtime_error when the file does not hold a snapshot of such a storage, in which case the storage
+  /// is left in an unspecified state.
+  void restore(const std::filesystem::path& path) requires (is_serializable<TStoredComponents> && ...) {
+    SnapshotReader reader(path);
+    _removed.clear();
+    reader.read(_data);
+    _signatures.restore(reader);
+    _handles.restore(reader);
+    reader.read(_free);
+    if (_signatures.size() != _data.size()) throw std::runtime_error("Incomplete snapshot in " + path.string());
+    // Relist the restored entities in the cached queries.
+    for (Query& query : _queries) {
+      query.entities.clear();
+      query.dirty = false;
+    }
+    for (size_t index = 0; index < _data.size(); ++index) {
+      std::get<EntityMetadata>(_data[index]).queries = 0;
+      update_queries(index);
+    }
   }
 
   /// Executes a callable on each entity with all required components attached.
   ///
   /// Requires no inactive entity to exist with an index smaller than the highest active one.
-  /// @tparam TRequiredComponents The set of component types required to be attached to an entity to be processed.
+  /// @tparam TRequiredComponents The set of component types required to be attached to an entity to be processed,
+  /// and those required to be detached, wrapped into `Without`.
   /// @param callable The callable to be executed with each matched entity's index as an argument.
   template<typename... TRequiredComponents>
   void for_entities_with(auto&& callable) const {
@@ -162,146 +380,568 @@ public:
     if constexpr (sizeof...(TRequiredComponents) > 0) {
       // TODO: static_assert component types handled
       // Construct a signature to be matched against from the required component types.
-      constexpr Signature signature = signature_of<TRequiredComponents...>;
-      // Iterate all active components.
-      for (size_t i{0}; i < _data.size(); ++i) {
-        // Match the entity signature with the required component types using a bitwise AND.
-        if ((std::get<EntityMetadata>(_data[i]).signature & signature) == signature)
-        // TODO: call with manager (since this is sequential)
-          callable(Entity{i});
+      constexpr Signature signature = required_of<TRequiredComponents...>;
+      // The bits compared, such that the bits of excluded component types must be off.
+      constexpr Signature mask = signature | excluded_of<TRequiredComponents...>;
+      // If the query is cached, only iterate the listed entities.
+      if (const Query* query = find_query(signature)) {
+        for (size_t index : query->entities) {
+          // Entities detached since the last refresh are still listed, so match again.
+          if ((_signatures[index] & mask) == signature)
+            callable(std::get<EntityMetadata>(_data[index]).handle);
+        }
+        return;
       }
-    } else callable(Entity{SIZE_MAX}); // TODO: move check to scheduler to avoid -1-reservation (and also execute if ECS::Entity is required)
+      // Iterate all active components.
+      // Signatures are matched against the required component types block-wise.
+      // TODO: call with manager (since this is sequential)
+      _signatures.for_each_match(signature, excluded_of<TRequiredComponents...>, [&](size_t index) {
+        callable(std::get<EntityMetadata>(_data[index]).handle);
+      });
+    } else callable(Entity{}); // TODO: move check to scheduler to avoid -1-reservation (and also execute if ECS::Entity is required)
   }
 
   /// Executes a callable on each entity with all required components attached.
   /// Employs inner parallelism.
   ///
   /// Requires no inactive entity to exist with an index smaller than the highest active one.
-  /// @tparam TRequiredComponents The set of component types required to be attached to an entity to be processed.
+  /// @tparam TRequiredComponents The set of component types required to be attached to an entity to be processed,
+  /// and those required to be detached, wrapped into `Without`.
   /// @param callable The callable to be executed with each matched entity's index as an argument.
   // TODO: parametrize parallelization
   template<typename... TRequiredComponents>
   void for_entities_with_parallel(auto&& callable) const {
     if constexpr (sizeof...(TRequiredComponents) > 0) {
       // TODO: static_assert component types handled
-      static constexpr Signature signature = signature_of<TRequiredComponents...>;
-      #pragma omp parallel for
-      for (size_t i = 0; i < _data.size(); ++i) {
-        if ((std::get<EntityMetadata>(_data[i]).signature & signature) == signature)
-        // TODO: maybe a parallel manager?
-          callable(Entity{i});
+      static constexpr Signature signature = required_of<TRequiredComponents...>;
+      static constexpr Signature mask = signature | excluded_of<TRequiredComponents...>;
+      if (const Query* query = find_query(signature)) {
+        #pragma omp parallel for
+        for (size_t i = 0; i < query->entities.size(); ++i) {
+          const size_t index = query->entities[i];
+          if ((_signatures[index] & mask) == signature)
+            callable(std::get<EntityMetadata>(_data[index]).handle);
+        }
+        return;
       }
-    } else callable(Entity{SIZE_MAX}); // TODO: move check to scheduler
+      // TODO: maybe a parallel manager?
+      _signatures.for_each_match_parallel(signature, excluded_of<TRequiredComponents...>, [&](size_t index) {
+        callable(std::get<EntityMetadata>(_data[index]).handle);
+      });
+    } else callable(Entity{}); // TODO: move check to scheduler
+  }
+
+  /// Registers a query whose matching entities are to be cached.
+  ///
+  /// Instead of matching every entity's signature on each iteration, the storage then
+  /// keeps a list of matching entities which is updated incrementally on structural changes.
+  /// At most `_max_queries` queries are cached. Iterations on other queries match every entity.
+  /// @tparam TRequiredComponents The set of component types required to be attached to an entity to be listed.
+  template<typename... TRequiredComponents>
+  void cache_query() {
+    // Single-fire systems do not iterate entities.
+    if constexpr (sizeof...(TRequiredComponents) > 0) {
+      constexpr Signature signature = signature_of<TRequiredComponents...>;
+      if (find_query(signature) || _queries.size() >= _max_queries) return;
+      _queries.push_back(Query{signature});
+      // List all entities already stored.
+      for (size_t i{0}; i < _data.size(); ++i) update_queries(i);
+    }
   }
 
   /// Refreshes the storage to restore the preconditions necessary for iterating the entities.
   auto refresh() {
-    // Shuffle the storage to restore contiguity.
-    size_t size = shuffle();
-    // Reset the fragmentation counter.
-    _fragmentation = 0;
-    // Resize the vector to drop inactive entities.
+    // Drop removed and no longer matching entities from the cached queries while entity indices are still valid.
+    for (Query& query : _queries)
+      if (query.dirty) filter_query(query);
+    // Shuffle the storage to restore contiguity, or free the slots of the removed entities.
+    // This also invalidates the handles of the removed entities.
+    size_t size;
+    if constexpr (options.free_list) size = free_removed();
+    else size = shuffle();
+    // Translate the cached queries to the entity indices after shuffling.
+    if (!_relocations.empty() || std::any_of(_queries.begin(), _queries.end(), [](const Query& query) { return query.dirty; }))
+      for (Query& query : _queries) relocate_query(query, size);
+    _relocations.clear();
+    // Resize the vectors to drop inactive entities.
     _data.resize(size);
+    _signatures.resize(size);
+    // Recompute the block summaries of signatures changed during the last frame.
+    _signatures.refresh();
   }
 
 private:
   /// Contains any metadata (i.e. data besides the associated component data) necessary to be stored for an entity in this storage.
   struct EntityMetadata {
-    /// The entity's signature.
-    ///
-    /// The state of a bit indicates whether the component of the corresponding component type is attached to the entity.
-    /// A component is said to be attached to this entity if the bit is set, and detached if not.
-    /// This is necessary because for each entity, storage for each component type is allocated and initialized (in the vectors)
-    /// and its signature tracks if said memory is to be considered associated with the entity.
-    Signature signature;
-
     /// The entity's activeness. This represents the entities's existence/presence. Instead of being removed from memory,
     /// entities to be removed are simply set as inactive. Shuffling then later gets rid of them.
     bool active = true;
+
+    /// The cached queries listing this entity.
+    ///
+    /// Bit `i` is set if the entity is contained in the entity list of the `i`-th cached query.
+    uint64_t queries = 0;
+
+    /// The entity's handle, passed to systems when iterating.
+    Entity handle;
   };
 
+  /// The tuple type storing an entity's metadata and component data.
+  ///
+  /// Tag component types are left out, as they carry no data.
+  using Row = typename decltype(hana::unpack(
+    hana::remove_if(hana::tuple_t<EntityMetadata, TStoredComponents...>, []<typename T>(T) { return hana::bool_c<is_tag<typename T::type>>; }),
+    hana::template_<std::tuple>
+  ))::type;
+
+  /// The handle table resolving entity handles to indices into the vector.
+  HandleTable _handles;
+
+  /// A cached query, listing the indices of all entities matching a signature.
+  struct Query {
+    /// The signature of the required component types.
+    Signature signature;
+
+    /// The indices of the listed entities in ascending order.
+    ///
+    /// Entities detached or removed since the last refresh may still be listed.
+    /// Entities are never listed more than once.
+    std::vector<size_t> entities = {};
+
+    /// Whether the entity list contains stale entries or is out of order.
+    bool dirty = false;
+  };
+
+  /// The maximum number of cached queries.
+  ///
+  /// This is limited by the number of bits in the query membership mask of the entity metadata.
+  static constexpr size_t _max_queries = 64;
+
+  /// The cached queries.
+  std::vector<Query> _queries;
+
+  /// The new indices of entities moved by the last shuffle.
+  ///
+  /// The element at `i` is the new index of the entity previously at the `i`-th index from the back.
+  /// Only recorded while queries are cached.
+  std::vector<size_t> _relocations;
+
   /// Tuple storing the entity metadata.
   ///
   /// The tuples storing component data, arranged in a vector.
   ///
   /// For each stored entity, a tuple is created which stores instances
-  /// of all possible components.
-  std::vector<std::tuple<EntityMetadata, TStoredComponents...>> _data;
+  /// of all possible components, except for tags.
+  std::vector<Row, TAllocator<Row>> _data;
 
-  /// The fragmentation counter.
+  /// The entity signatures, stored separately from the entity tuples to be matched block-wise.
+  ///
+  /// The state of a bit indicates whether the component of the corresponding component type is attached to the entity.
+  /// A component is said to be attached to this entity if the bit is set, and detached if not.
+  /// This is necessary because for each entity, storage for each component type is allocated and initialized (in the tuple)
+  /// and its signature tracks if said memory is to be considered associated with the entity.
+  /// Always has the same size as the entity tuple vector.
+  SignatureColumn<Signature> _signatures;
+
+  /// The indices of the entities removed since the last `shuffle` took place, in no particular order.
   ///
-  /// Counts the amount of entity removals since the last `shuffle` took place.
   /// When entities are removed, the storage is left _fragmented_, since inactive
-  /// entities are in between active ones.
-  size_t _fragmentation = 0;
+  /// entities are in between active ones. Each removed entity is recorded exactly once.
+  std::vector<size_t> _removed;
+
+  /// The indices of the free slots of removed entities, to be reused by new entities.
+  ///
+  /// Only used if configured to reuse slots.
+  std::vector<size_t> _free;
+
+  /// The moves done by the last `shuffle` as pairs of the old and the new index of an entity.
+  ///
+  /// Kept as a member to reuse its memory.
+  std::vector<std::pair<size_t, size_t>> _moves;
+
+  /// The minimum number of entities moved by a `shuffle` for the entity tuples to be moved concurrently.
+  static constexpr size_t _parallel_moves = 4096;
 
   /// Rearrange entity metadata and component data to have all active entities packed sequentially.
   ///
-  /// This is essentially quicksort on a list of binary values (the `active` booleans) which takes only one iteration (no recursion required).
+  /// Only the removed entities and the entities behind the new end of the storage are visited:
+  /// Each removed entity in front of the new end leaves a hole, which is filled by moving an active entity from behind it.
+  /// If configured to compact stably, all active entities behind the first hole are instead slid down in order.
+  /// The handles of all removed entities are invalidated. The removed entity tuples are discarded
+  /// when the vector is resized afterwards.
   ///
-  /// After shuffling, no inactive entity lies before an active one in the vectors.
+  /// After shuffling, no inactive entity lies before an active one in the vector.
   /// Thus all active entities can be iterated contiguously.
   /// @returns The index of the first inactive entity in the storage. This is also the
   /// number of active entities preceding it (and thus the total number of currently active stored entities).
   size_t shuffle() {
+    _moves.clear();
     // If the storage is not fragmented, return immediately.
-    if (!_fragmentation) return _data.size();
-
-    // If the storage is empty, return immediately.
-    if (_data.size() == 0) return 0;
-
-    // There are two iterators, initially pointing to the beginning and the end of the vectors respectively.
-    // They then move inwards toward each other and swap their elements whenever an inactive one and an active one
-    // are found with the inactive one having a lower index.
-    // The left iterator (`it_inactive`) only stops on inactive entities, while the right iterator (`it_active`) stops on active ones.
-
-    // Start out at index 0 (first element / left).
-    Entity it_inactive{0};
-    // Start out at index `_entities.size() - 1` (last element / right).
-    Entity it_active{_data.size() - 1};
-
-    // Loop indefinetely. Return conditions are given by the iterators crossing over.
-    while (true) {
-      // Move the left iterator to the right until it hits an inactive entity.
-      while (true) {
-        // If the left iterator is further right than the right one, all entities have been processed.
-        if (it_inactive > it_active) return it_inactive;
-        // If the left iterator points to an inactive entity, stop moving.
-        if (!std::get<EntityMetadata>(_data[it_inactive]).active) break;
-        // Move the left iterator to the right.
-        it_inactive++;
-      }
-      // Move the right iterator to the left until it hits an active entity.
-      while (true) {
-        // If the right iterator points to an active entity, stop moving.
-        if (std::get<EntityMetadata>(_data[it_active]).active) break;
-        // TODO: Update handles.
-        // invalidateEntityHandle(it_active);
-        // If the right iterator moves overtop the left one, all entities have been processed.
-        if (it_active <= it_inactive) return it_inactive;
-        // Move the right iterator to the left.
-        it_active--;
+    if (_removed.empty()) return _data.size();
+
+    const size_t size = _data.size() - _removed.size();
+    // Invalidate the handles of the removed entities before they are overwritten.
+    for (size_t index : _removed) _handles.release(std::get<EntityMetadata>(_data[index]).handle);
+    if constexpr (options.stable_compaction) {
+      // Slide each active entity behind the first hole down by the number of removed entities in front of it.
+      size_t to = *std::min_element(_removed.begin(), _removed.end());
+      for (size_t index = to + 1; index < _data.size(); ++index)
+        if (std::get<EntityMetadata>(_data[index]).active) _moves.emplace_back(index, to++);
+      assert(to == size);
+    } else {
+      // Gather the removed entities in front of the new end, whose number equals that of the active entities behind it.
+      const auto holes = std::partition(_removed.begin(), _removed.end(), [&](size_t index) { return index < size; });
+      // Pair each hole with an active entity behind the new end.
+      auto hole = _removed.begin();
+      for (size_t index = size; index < _data.size(); ++index)
+        if (std::get<EntityMetadata>(_data[index]).active) _moves.emplace_back(index, *hole++);
+      assert(hole == holes);
+    }
+    _removed.clear();
+
+    // Move the entity tuples.
+    if constexpr (options.stable_compaction) {
+      // Targets may overlap sources of earlier moves, so slide the runs of consecutive entities down in order.
+      for_each_run([&](size_t from, size_t to, size_t count) {
+        std::move(_data.begin() + from, _data.begin() + from + count, _data.begin() + to);
+      });
+    } else if (_moves.size() >= _parallel_moves) {
+      // Holes and moved entities are distinct, so they can be moved independently.
+      #pragma omp parallel for
+      for (size_t i = 0; i < _moves.size(); ++i) _data[_moves[i].second] = std::move(_data[_moves[i].first]);
+    } else {
+      for (const auto& [from, to] : _moves) _data[to] = std::move(_data[from]);
+    }
+    for (const auto& [from, to] : _moves) {
+      _signatures.assign(to, _signatures[from]);
+      // Let the moved entity's handle resolve to its new index.
+      _handles.relocate(std::get<EntityMetadata>(_data[to]).handle, to);
+      // Remember the move for translating cached queries.
+      if (!_queries.empty()) record_relocation(from, to);
+    }
+    return size;
+  }
+
+  /// Calls a function for each run of consecutive entities moved by the same offset in the last `shuffle`, in order.
+  ///
+  /// @param function The callable taking the old index of the first entity of the run, its new index and the run length.
+  void for_each_run(auto&& function) const {
+    for (size_t begin = 0, end; begin < _moves.size(); begin = end) {
+      for (end = begin + 1; end < _moves.size() && _moves[end].first == _moves[end - 1].first + 1
+        && _moves[end].second == _moves[end - 1].second + 1; ++end);
+      function(_moves[begin].first, _moves[begin].second, end - begin);
+    }
+  }
+
+  /// Reorders all entities, translating their handles, the free slots, the removed entities and the cached queries.
+  ///
+  /// @param order The previous index of each entity, i.e., the entity at index `i` afterwards is the one at `order[i]` before.
+  void permute(const std::vector<size_t>& order) {
+    std::vector<Row, TAllocator<Row>> data;
+    data.reserve(_data.capacity());
+    std::vector<Signature> signatures(order.size());
+    for (size_t index = 0; index < order.size(); ++index) {
+      data.push_back(std::move(_data[order[index]]));
+      signatures[index] = _signatures[order[index]];
+    }
+    _data = std::move(data);
+    for (size_t index = 0; index < order.size(); ++index) {
+      _signatures.assign(index, signatures[index]);
+      // Let the handles of stored entities, including removed ones, resolve to their new index. Those of free slots are released already.
+      const EntityMetadata& metadata = std::get<EntityMetadata>(_data[index]);
+      if (_handles.is_valid(metadata.handle)) _handles.relocate(metadata.handle, index);
+    }
+    _signatures.refresh();
+    translate_indices(order);
+  }
+
+  /// Puts the slots of the removed entities on the free list, instead of shuffling.
+  ///
+  /// The handles of the removed entities are invalidated and their signatures cleared, so that no iteration matches them.
+  /// Their entity tuples are left in place.
+  /// @returns The number of entities in the storage, including free slots.
+  size_t free_removed() {
+    for (size_t index : _removed) {
+      _handles.release(std::get<EntityMetadata>(_data[index]).handle);
+      _signatures.assign(index, Signature(0));
+    }
+    _free.insert(_free.end(), _removed.begin(), _removed.end());
+    _removed.clear();
+    return _data.size();
+  }
+
+  /// Appends multiple new entity tuples with the same set of component types.
+  ///
+  /// The components of the new entities are default-constructed.
+  /// @tparam TComponents The component types to be attached to the new entities.
+  /// @param count The number of entities to be appended.
+  /// @returns The index of the first new entity.
+  template<typename... TComponents>
+  size_t append_entities(size_t count) {
+    const size_t begin = _data.size();
+    // Reserve at least geometrically, so that repeated small batches do not reallocate every time.
+    if (_data.capacity() < begin + count) {
+      const size_t capacity = std::max(begin + count, 2 * _data.capacity());
+      _data.reserve(capacity);
+      _signatures.reserve(capacity);
+      _handles.reserve(capacity);
+    }
+    _data.resize(begin + count);
+    for (size_t index = begin; index < begin + count; ++index) {
+      _signatures.push_back(signature_of<TComponents...>);
+      std::get<EntityMetadata>(_data[index]).handle = _handles.create(index);
+    }
+    return begin;
+  }
+
+  /// Creates and activates multiple new entities with components returned by a generator.
+  ///
+  /// Free slots are filled one by one first, the remaining entities are appended at once.
+  /// @tparam parallel Whether to call the generator and assign the components of appended entities concurrently.
+  /// @param total The number of entities to be created.
+  /// @param generator The callable returning the initial components of the `i`-th new entity as a `std::tuple`, given `i`.
+  template<bool parallel>
+  void generate_entities(size_t total, auto& generator) {
+    using Components = std::decay_t<decltype(generator(size_t{0}))>;
+    // Reuse the slots of removed entities first.
+    size_t reused = 0;
+    if constexpr (options.free_list)
+      for (; reused < total && !_free.empty(); ++reused)
+        std::apply([&](auto&&... components) { new_entity(std::move(components)...); }, generator(reused));
+    const size_t count = total - reused;
+    if (!count) return;
+    const size_t begin = [&]<typename... TComponents>(std::tuple<TComponents...>*) {
+      return append_entities<TComponents...>(count);
+    }(static_cast<Components*>(nullptr));
+    // Assign the generated components of a single entity.
+    auto generate = [&](size_t i) {
+      std::apply([&](auto&&... components) {
+        (assign_component<std::decay_t<decltype(components)>>(begin + i, std::move(components)), ...);
+      }, generator(reused + i));
+    };
+    if constexpr (parallel) {
+      #pragma omp parallel for
+      for (size_t i = 0; i < count; ++i) generate(i);
+    } else {
+      for (size_t i = 0; i < count; ++i) generate(i);
+    }
+    // Track the entities in the queries they match.
+    if (!_queries.empty())
+      for (size_t index = begin; index < begin + count; ++index) update_queries(index);
+  }
+
+  /// Sets all active entities with all required components attached which satisfy a predicate as inactive.
+  ///
+  /// Only the activeness of the tested entities is written, so they can be tested concurrently.
+  /// The queries listing removed entities are marked once afterwards, and the removed entities are recorded for shuffling.
+  /// @tparam parallel Whether to test the entities concurrently.
+  /// @tparam TRequiredComponents The set of component types required to be attached to an entity to be tested.
+  /// @param predicate The callable returning whether to remove an entity, given const references to its required components.
+  template<bool parallel, typename... TRequiredComponents>
+  void mark_removed_if(auto& predicate) {
+    static_assert(sizeof...(TRequiredComponents) > 0, "Removing entities requires at least one component type to be tested.");
+    constexpr Signature signature = signature_of<TRequiredComponents...>;
+    // The union of the queries listing removed entities.
+    uint64_t queries = 0;
+    // Tests the entities at the given indices, which need not match the signature.
+    auto mark = [&](const auto& candidates) {
+      auto test = [&](size_t index, std::vector<size_t>& removed, uint64_t& queries) {
+        EntityMetadata& metadata = std::get<EntityMetadata>(_data[index]);
+        if (!metadata.active || (_signatures[index] & signature) != signature) return;
+        if (!predicate(std::as_const(component_at<TRequiredComponents>(index))...)) return;
+        metadata.active = false;
+        queries |= metadata.queries;
+        removed.push_back(index);
+      };
+      if constexpr (parallel) {
+        // Each thread records its removed entities separately, which are appended once it is done.
+        #pragma omp parallel
+        {
+          std::vector<size_t> removed;
+          uint64_t removed_queries = 0;
+          #pragma omp for nowait
+          for (size_t i = 0; i < candidates.size(); ++i) test(candidates[i], removed, removed_queries);
+          #pragma omp critical
+          {
+            _removed.insert(_removed.end(), removed.begin(), removed.end());
+            queries |= removed_queries;
+          }
+        }
+      } else {
+        for (size_t i = 0; i < candidates.size(); ++i) test(candidates[i], _removed, queries);
       }
+    };
+    // Only test the entities listed by a cached query, if any.
+    if (const Query* query = find_query(signature)) mark(query->entities);
+    else mark(std::views::iota(size_t{0}, _data.size()));
+    // Mark the queries listing removed entities, so that they are dropped on refresh.
+    for (size_t index = 0; index < _queries.size(); ++index)
+      if (queries & (uint64_t{1} << index)) _queries[index].dirty = true;
+  }
 
-      // After moving, the right iterator points to an active entity,
-      assert(std::get<EntityMetadata>(_data[it_active]).active);
-      // After moving, the left iterator points to an inactive entity,
-      assert(!std::get<EntityMetadata>(_data[it_inactive]).active);
+  /// Returns a reference to the component of some type stored at an index.
+  ///
+  /// @tparam TComponent The component type to be accessed.
+  /// @param index The index of the entity.
+  template<typename TComponent>
+  TComponent& component_at(size_t index) {
+    if constexpr (is_tag<TComponent>) return tag_instance<TComponent>;
+    else return std::get<TComponent>(_data[index]);
+  }
+
+  /// Assigns the component of some type stored at an index.
+  ///
+  /// @tparam TComponent The component type to be assigned.
+  /// @param index The index of the entity.
+  /// @param component The component data to be assigned.
+  template<typename TComponent>
+  void assign_component(size_t index, auto&& component) {
+    // Tags have no data to be assigned.
+    if constexpr (!is_tag<TComponent>)
+      std::get<TComponent>(_data[index]) = std::forward<decltype(component)>(component);
+  }
 
-      // Swap the active and the inactive entities, so that the active is left of the inactive.
-      std::swap(_data[it_active], _data[it_inactive]);
+  /// Returns the cached query of a signature or a null pointer if it is not cached.
+  ///
+  /// @param signature The signature of the required component types.
+  const Query* find_query(const Signature& signature) const {
+    for (const Query& query : _queries)
+      if (query.signature == signature) return &query;
+    return nullptr;
+  }
 
-      // TODO: Update handles.
-      // refreshEntityHandle(it_inactive);
-      // invalidateEntityHandle(it_active);
-      // refreshEntityHandle(it_active);
+  /// Lists an entity in all cached queries it matches and marks the ones it no longer matches.
+  ///
+  /// This is called after each change to an entity's signature.
+  /// @param entity The index of the entity.
+  void update_queries(size_t entity) {
+    EntityMetadata& metadata = std::get<EntityMetadata>(_data[entity]);
+    for (size_t index = 0; index < _queries.size(); ++index) {
+      Query& query = _queries[index];
+      const uint64_t bit = uint64_t{1} << index;
+      const bool matches = (_signatures[entity] & query.signature) == query.signature;
+      if (matches && !(metadata.queries & bit)) {
+        // Appending keeps the list in order only if the entity is the one with the highest index.
+        if (!query.entities.empty() && query.entities.back() > entity) query.dirty = true;
+        query.entities.push_back(entity);
+        metadata.queries |= bit;
+      } else if (!matches && (metadata.queries & bit)) {
+        // The entity is dropped from the list on refresh.
+        query.dirty = true;
+      }
+    }
+  }
+
+  /// Drops inactive and non-matching entities from a cached query.
+  ///
+  /// @param query The query to be filtered.
+  void filter_query(Query& query) {
+    const uint64_t bit = uint64_t{1} << (&query - _queries.data());
+    std::erase_if(query.entities, [&](size_t entity) {
+      EntityMetadata& metadata = std::get<EntityMetadata>(_data[entity]);
+      if (metadata.active && (_signatures[entity] & query.signature) == query.signature) return false;
+      metadata.queries &= ~bit;
+      return true;
+    });
+  }
+
+  /// Translates a cached query to the entity indices after shuffling and restores its order.
+  ///
+  /// Unless compacting stably, only entities beyond the new size have moved. Since the query is ordered,
+  /// these are at the end of the list.
+  /// @param query The (filtered) query to be translated.
+  /// @param size The number of entities after shuffling.
+  void relocate_query(Query& query, size_t size) {
+    auto& entities = query.entities;
+    if constexpr (options.stable_compaction) {
+      // Stable compaction keeps the order, and every active entity from the first moved one on has moved.
+      const size_t first = _moves.empty() ? size : _moves.front().first;
+      if (query.dirty) {
+        for (size_t& entity : entities)
+          if (entity >= first) entity = relocation_of(entity);
+        std::sort(entities.begin(), entities.end());
+      } else {
+        for (auto it = std::lower_bound(entities.begin(), entities.end(), first); it != entities.end(); ++it)
+          *it = relocation_of(*it);
+      }
+    } else if (query.dirty) {
+      for (size_t& entity : entities)
+        if (entity >= size) entity = relocation_of(entity);
+      std::sort(entities.begin(), entities.end());
+    } else {
+      auto moved = std::lower_bound(entities.begin(), entities.end(), size);
+      for (auto it = moved; it != entities.end(); ++it) *it = relocation_of(*it);
+      // The moved entities fill holes in between, so merge them back in.
+      std::sort(moved, entities.end());
+      std::inplace_merge(entities.begin(), moved, entities.end());
+    }
+    query.dirty = false;
+  }
 
-      // Move iterators towards each other to continue.
-      it_inactive++;
-      it_active--;
+  /// Translates the free slots, the removed entities and the cached queries to the entity indices after reordering.
+  ///
+  /// @param order The previous index of each entity.
+  void translate_indices(const std::vector<size_t>& order) {
+    std::vector<size_t> position(order.size());
+    for (size_t index = 0; index < order.size(); ++index) position[order[index]] = index;
+    for (size_t& index : _free) index = position[index];
+    for (size_t& index : _removed) index = position[index];
+    for (Query& query : _queries) {
+      for (size_t& entity : query.entities) entity = position[entity];
+      std::sort(query.entities.begin(), query.entities.end());
     }
   }
 
+  /// Records the move of an entity during shuffling.
+  ///
+  /// The new size is not known during shuffling, so moves are indexed relative to the end of the vector.
+  /// @param from The index the entity is moved from.
+  /// @param to The index the entity is moved to.
+  void record_relocation(size_t from, size_t to) {
+    const size_t offset = _data.size() - 1 - from;
+    if (_relocations.size() <= offset) _relocations.resize(offset + 1);
+    _relocations[offset] = to;
+  }
+
+  /// Returns the index an entity has been moved to by the last shuffle.
+  ///
+  /// Requires the vector not to be resized since shuffling.
+  /// @param entity The index of the entity before shuffling.
+  size_t relocation_of(size_t entity) const {
+    return _relocations[_data.size() - 1 - entity];
+  }
 };
 
+namespace internal {
+
+  /// Vector of tuples storage configuration class.
+  template<VectorOptions options = vector_options, template<typename> typename TAllocator = std::allocator>
+  class VectorOfTuplesCustom {
+  public:
+    /// The configured storage.
+    template<typename... TComponents>
+    using Storage = BasicVectorOfTuples<options, TAllocator, TComponents...>;
+
+    /// This class but with slot reuse through a free list configured.
+    using WithFreeList = VectorOfTuplesCustom<options.use_free_list(), TAllocator>;
+
+    /// This class but with order-preserving compaction configured.
+    using WithStableCompaction = VectorOfTuplesCustom<options.use_stable_compaction(), TAllocator>;
+
+    /// This class but with the vector of tuples allocated by another allocator (e.g., `AlignedAllocator`).
+    template<template<typename> typename TOtherAllocator>
+    using WithAllocator = VectorOfTuplesCustom<options, TOtherAllocator>;
+  };
+
+}
+
+/// Vector of tuples storage with custom options.
+///
+/// This avoids having to write `<>` after VectorOfTuplesCustom when using.
+using VectorOfTuplesCustom = internal::VectorOfTuplesCustom<>;
+
+/// Vector of tuples storage with default options.
+template<typename... TStoredComponents>
+using VectorOfTuples = BasicVectorOfTuples<internal::vector_options, std::allocator, TStoredComponents...>;
+
 }
@@ -0,0 +1,205 @@
+/// @file
+/// @brief Allocators storages can be configured with (see `WithAllocator`) to place their vectors in memory.
+
+#pragma once
+
+#include <algorithm>
+#include <atomic>
+#include <cstddef>
+#include <limits>
+#include <memory>
+#include <new>
+
+#include <sys/mman.h>
+
+namespace scanta {
+
+/// The size of a cache line, which is also the width of the widest SIMD registers (AVX-512).
+constexpr size_t cache_line_size = 64;
+
+/// The size of a transparent huge page on x86-64 and (with 4 KiB base pages) AArch64.
+constexpr size_t huge_page_size = size_t{2} << 20;
+
+/// Allocator aligning every allocation to a boundary.
+///
+/// Columns allocated with it start on a cache line (or SIMD register) boundary, so that systems taking spans
+/// can use aligned loads on the first element, and no two columns share a cache line.
+/// ```cpp
+/// using ECS = scanta::EntityComponentSystem<scanta::storage::TupleOfVectorsCustom::WithAllocator<scanta::AlignedAllocator>::Storage, scanta::scheduler::Parallel>;
+/// ```
+/// @tparam T The type of objects allocated.
+/// @tparam alignment The boundary to align to, a power of two. Types with a stricter alignment keep theirs.
+template<typename T, size_t alignment = cache_line_size>
+class AlignedAllocator {
+  static_assert(alignment && !(alignment & (alignment - 1)), "The alignment has to be a power of two.");
+public:
+  using value_type = T;
+
+  /// Rebinding is required explicitly due to the non-type template parameter.
+  template<typename U>
+  struct rebind {
+    using other = AlignedAllocator<U, alignment>;
+  };
+
+  AlignedAllocator() = default;
+
+  /// Converting constructor required for rebinding.
+  template<typename U>
+  AlignedAllocator(const AlignedAllocator<U, alignment>&) {}
+
+  T* allocate(size_t count) {
+    if (count > std::numeric_limits<size_t>::max() / sizeof(T)) throw std::bad_array_new_length();
+    return static_cast<T*>(::operator new(count * sizeof(T), _alignment));
+  }
+
+  void deallocate(T* pointer, size_t) {
+    ::operator delete(pointer, _alignment);
+  }
+
+  /// All aligned allocators use the global allocator and are thus interchangeable.
+  template<typename U>
+  bool operator==(const AlignedAllocator<U, alignment>&) const {
+    return true;
+  }
+
+private:
+  /// The alignment of allocations.
+  static constexpr std::align_val_t _alignment{std::max(alignment, alignof(T))};
+};
+
+/// Allocator backing large allocations with transparent huge pages.
+///
+/// Allocations of at least `huge_page_size` bytes are aligned to and rounded up to whole huge pages, which the kernel
+/// is then advised to back by huge pages (`madvise(MADV_HUGEPAGE)`). Scanning a column of a million entities then
+/// touches a few TLB entries instead of thousands. Smaller allocations are aligned to cache lines only.
+/// Whether huge pages are used is up to the kernel; if transparent huge pages are disabled, the advice is ignored.
+/// @tparam T The type of objects allocated.
+template<typename T>
+class HugePageAllocator {
+public:
+  using value_type = T;
+
+  HugePageAllocator() = default;
+
+  /// Converting constructor required for rebinding.
+  template<typename U>
+  HugePageAllocator(const HugePageAllocator<U>&) {}
+
+  T* allocate(size_t count) {
+    if (count > (std::numeric_limits<size_t>::max() - huge_page_size) / sizeof(T)) throw std::bad_array_new_length();
+    const size_t bytes = count * sizeof(T);
+    if (bytes < huge_page_size) return static_cast<T*>(::operator new(bytes, _small_alignment));
+    const size_t rounded = (bytes + huge_page_size - 1) / huge_page_size * huge_page_size;
+    void* pointer = ::operator new(rounded, std::align_val_t{huge_page_size});
+#ifdef MADV_HUGEPAGE
+    // The advice is merely a hint, so failures (e.g., transparent huge pages being disabled) are ignored.
+    ::madvise(pointer, rounded, MADV_HUGEPAGE);
+#endif
+    return static_cast<T*>(pointer);
+  }
+
+  void deallocate(T* pointer, size_t count) {
+    if (count * sizeof(T) < huge_page_size) ::operator delete(pointer, _small_alignment);
+    else ::operator delete(pointer, std::align_val_t{huge_page_size});
+  }
+
+  /// All huge page allocators use the global allocator and are thus interchangeable.
+  template<typename U>
+  bool operator==(const HugePageAllocator<U>&) const {
+    return true;
+  }
+
+private:
+  /// The alignment of allocations smaller than a huge page.
+  static constexpr std::align_val_t _small_alignment{std::max(cache_line_size, alignof(T))};
+};
+
+/// The number of allocations and bytes made through all `CountingAllocator`s.
+///
+/// The counters are updated atomically, since storages may allocate from multiple threads (e.g., when spawning in parallel).
+struct AllocationStatistics {
+  /// The number of allocations made.
+  std::atomic<size_t> allocations = 0;
+  /// The number of allocations released.
+  std::atomic<size_t> deallocations = 0;
+  /// The number of bytes currently allocated.
+  std::atomic<size_t> bytes = 0;
+  /// The highest number of bytes allocated at once.
+  std::atomic<size_t> peak_bytes = 0;
+
+  /// Returns the statistics shared by all counting allocators.
+  static AllocationStatistics& instance() {
+    static AllocationStatistics statistics;
+    return statistics;
+  }
+
+  /// Resets all counters, e.g., between the phases of a benchmark.
+  ///
+  /// The bytes still allocated are kept, so that releasing them later does not underflow.
+  void reset() {
+    allocations = 0;
+    deallocations = 0;
+    peak_bytes = bytes.load();
+  }
+};
+
+/// Allocator counting the allocations and bytes of another allocator (see `AllocationStatistics`), for diagnostics.
+///
+/// The counters are shared by all value types, so they cover everything a storage allocates through it:
+/// ```cpp
+/// using ECS = scanta::EntityComponentSystem<scanta::storage::VectorOfTuplesCustom::WithAllocator<scanta::CountingAllocator>::Storage, scanta::scheduler::Sequential>;
+/// // ...
+/// std::cout << scanta::AllocationStatistics::instance().peak_bytes << std::endl;
+/// ```
+/// @tparam T The type of objects allocated.
+/// @tparam TAllocator The allocator allocating the memory, e.g., `AlignedAllocator`.
+template<typename T, template<typename> typename TAllocator = std::allocator>
+class CountingAllocator {
+public:
+  using value_type = T;
+
+  /// Rebinding is required explicitly due to the template template parameter.
+  template<typename U>
+  struct rebind {
+    using other = CountingAllocator<U, TAllocator>;
+  };
+
+  CountingAllocator() = default;
+
+  /// Converting constructor required for rebinding.
+  template<typename U>
+  CountingAllocator(const CountingAllocator<U, TAllocator>& other) : _allocator(other._allocator) {}
+
+  T* allocate(size_t count) {
+    T* pointer = _allocator.allocate(count);
+    AllocationStatistics& statistics = AllocationStatistics::instance();
+    ++statistics.allocations;
+    const size_t bytes = statistics.bytes += count * sizeof(T);
+    // Raise the peak unless another thread raised it higher in the meantime.
+    size_t peak = statistics.peak_bytes.load();
+    while (peak < bytes && !statistics.peak_bytes.compare_exchange_weak(peak, bytes));
+    return pointer;
+  }
+
+  void deallocate(T* pointer, size_t count) {
+    AllocationStatistics& statistics = AllocationStatistics::instance();
+    ++statistics.deallocations;
+    statistics.bytes -= count * sizeof(T);
+    _allocator.deallocate(pointer, count);
+  }
+
+  /// Counting allocators are interchangeable if the allocators they count are.
+  template<typename U>
+  bool operator==(const CountingAllocator<U, TAllocator>& other) const {
+    return _allocator == other._allocator;
+  }
+
+private:
+  template<typename, template<typename> typename>
+  friend class CountingAllocator;
+
+  /// The allocator allocating the memory.
+  [[no_unique_address]] TAllocator<T> _allocator;
+};
+
+}
@@ -0,0 +1,315 @@
+/// @file
+/// @brief Array-of-struct-of-arrays (AoSoA) blocks of components sized to the SIMD register width.
+
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <memory>
+#include <type_traits>
+#include <vector>
+
+#include "scanta/util/component_traits.hpp"
+
+namespace scanta {
+
+/// The width of the widest SIMD registers enabled at compile-time in bytes.
+constexpr size_t simd_bytes =
+#if defined(__AVX512F__)
+  64;
+#elif defined(__AVX__)
+  32;
+#else
+  16;
+#endif
+
+/// The number of entities stored in a single AoSoA block.
+///
+/// This is the number of single-precision lanes of a SIMD register, so that each field of a block
+/// fills (at least) one register.
+constexpr size_t block_lanes = simd_bytes / sizeof(float);
+
+/// Whether a component type is laid out in AoSoA blocks.
+///
+/// This is the case if `component_traits` declares an `aosoa_scalar` type for it.
+/// @tparam TComponent The component type.
+template<typename TComponent>
+constexpr bool is_aosoa = requires { typename component_traits<TComponent>::aosoa_scalar; };
+
+/// A block of components of `block_lanes` consecutive entities, stored as one array per scalar field.
+///
+/// Each component is regarded as an array of scalars of the type declared by `component_traits<TComponent>::aosoa_scalar`.
+/// The `i`-th scalar of all components of a block is stored contiguously, so operations on one field
+/// of all entities in a block can be vectorized.
+///
+/// Systems can take blocks as parameters to be called once per block:
+/// ```cpp
+/// void operator()(scanta::Block<Position>& position, const scanta::Block<Velocity>& velocity, float delta_time) const {
+///   for (size_t field = 0; field < 3; ++field)
+///     for (size_t lane = 0; lane < scanta::block_lanes; ++lane)
+///       position[field][lane] += velocity[field][lane] * delta_time;
+/// }
+/// ```
+/// @tparam TComponent The component type stored.
+template<typename TComponent>
+class alignas(block_lanes * sizeof(typename component_traits<TComponent>::aosoa_scalar)) Block {
+public:
+  /// The component type stored.
+  using Component = TComponent;
+
+  /// The scalar type each component consists of.
+  using Scalar = typename component_traits<TComponent>::aosoa_scalar;
+
+  /// The number of scalars per component.
+  static constexpr size_t fields = sizeof(TComponent) / sizeof(Scalar);
+
+  static_assert(std::is_trivially_copyable_v<TComponent>, "Only trivially copyable component types can be stored in AoSoA blocks.");
+  static_assert(std::is_arithmetic_v<Scalar>, "The AoSoA scalar type must be arithmetic.");
+  static_assert(sizeof(TComponent) % sizeof(Scalar) == 0, "The component type must consist of AoSoA scalars only.");
+
+  /// Returns the lanes of a scalar field.
+  ///
+  /// @param field The index of the scalar within the component.
+  Scalar (&operator[](size_t field))[block_lanes] {
+    return _fields[field];
+  }
+
+  /// Returns the lanes of a scalar field.
+  ///
+  /// @param field The index of the scalar within the component.
+  const Scalar (&operator[](size_t field) const)[block_lanes] {
+    return _fields[field];
+  }
+
+  /// Returns the lanes of a scalar data member.
+  ///
+  /// @param member The data member, e.g., `&Position::x`.
+  Scalar (&operator[](Scalar TComponent::* member))[block_lanes] {
+    return _fields[field_of(member)];
+  }
+
+  /// Returns the lanes of a scalar data member.
+  ///
+  /// @param member The data member, e.g., `&Position::x`.
+  const Scalar (&operator[](Scalar TComponent::* member) const)[block_lanes] {
+    return _fields[field_of(member)];
+  }
+
+  /// Gathers the component of a single entity.
+  ///
+  /// @param lane The lane of the entity.
+  TComponent load(size_t lane) const {
+    Scalar scalars[fields];
+    for (size_t field = 0; field < fields; ++field) scalars[field] = _fields[field][lane];
+    TComponent component;
+    std::memcpy(&component, scalars, sizeof(TComponent));
+    return component;
+  }
+
+  /// Scatters the component of a single entity.
+  ///
+  /// @param lane The lane of the entity.
+  /// @param component The component to be stored.
+  void store(size_t lane, const TComponent& component) {
+    Scalar scalars[fields];
+    std::memcpy(scalars, &component, sizeof(TComponent));
+    for (size_t field = 0; field < fields; ++field) _fields[field][lane] = scalars[field];
+  }
+
+  /// Copies some lanes from another block.
+  ///
+  /// @param other The block to be copied from.
+  /// @param lanes A bit mask with bit `i` set if the `i`-th lane is to be copied.
+  void restore(const Block& other, uint64_t lanes) {
+    for (size_t field = 0; field < fields; ++field)
+      for (size_t lane = 0; lane < block_lanes; ++lane)
+        if (lanes & (uint64_t{1} << lane)) _fields[field][lane] = other._fields[field][lane];
+  }
+
+private:
+  /// The scalars of all components in the block, indexed by field first and by lane second.
+  Scalar _fields[fields][block_lanes];
+
+  /// Returns the index of the scalar field of a data member.
+  ///
+  /// @param member The data member.
+  static size_t field_of(Scalar TComponent::* member) {
+    static const TComponent probe{};
+    return (reinterpret_cast<const char*>(&(probe.*member)) - reinterpret_cast<const char*>(&probe)) / sizeof(Scalar);
+  }
+};
+
+/// Whether a type is an AoSoA block.
+///
+/// @tparam T The type.
+template<typename T>
+constexpr bool is_block = false;
+
+template<typename TComponent>
+constexpr bool is_block<Block<TComponent>> = true;
+
+/// A vector-like container storing components in AoSoA blocks.
+///
+/// Components are addressed by index like in a vector, but can not be referenced individually.
+/// Instead, they are loaded and stored by value, or accessed through a `Staged` copy.
+/// @tparam TComponent The component type stored.
+/// @tparam TAllocator The allocator template allocating the blocks.
+template<typename TComponent, template<typename> typename TAllocator = std::allocator>
+class AoSoAColumn {
+public:
+  /// A copy of a single component which is written back to its block when the copy is destroyed.
+  ///
+  /// This allows handing out references to single components in AoSoA blocks.
+  /// @tparam TAccess The component type, const-qualified if the copy is not to be written back.
+  template<typename TAccess>
+  class Staged {
+  public:
+    /// Loads a component from a column.
+    ///
+    /// @param column The column storing the component.
+    /// @param index The index of the component.
+    Staged(AoSoAColumn& column, size_t index) : _column(&column), _index(index), _value(column.load(index)) {}
+
+    /// Move constructor, taking over the responsibility of writing back.
+    Staged(Staged&& other) : _column(other._column), _index(other._index), _value(other._value) {
+      other._column = nullptr;
+    }
+
+    Staged(const Staged&) = delete;
+    Staged& operator=(const Staged&) = delete;
+
+    /// Writes back the component, if it is not const.
+    ~Staged() {
+      if constexpr (!std::is_const_v<TAccess>)
+        if (_column) _column->store(_index, _value);
+    }
+
+    /// Returns a reference to the copy.
+    operator TAccess&() {
+      return _value;
+    }
+
+    /// Returns a reference to the copy.
+    TAccess& get() {
+      return _value;
+    }
+
+    /// Accesses members of the copy.
+    TAccess* operator->() {
+      return &_value;
+    }
+
+  private:
+    /// The column to write back to, or null if moved from.
+    AoSoAColumn* _column;
+    /// The index of the component.
+    size_t _index;
+    /// The copy of the component.
+    TComponent _value;
+  };
+
+  /// Returns the number of components stored.
+  size_t size() const {
+    return _size;
+  }
+
+  /// Returns the number of blocks, the last of which may be partially used.
+  size_t block_count() const {
+    return _blocks.size();
+  }
+
+  /// Returns a block of components.
+  ///
+  /// @param block The index of the block, storing the components at indices `block * block_lanes` onwards.
+  Block<TComponent>& block(size_t block) {
+    return _blocks[block];
+  }
+
+  /// Returns a block of components.
+  ///
+  /// @param block The index of the block, storing the components at indices `block * block_lanes` onwards.
+  const Block<TComponent>& block(size_t block) const {
+    return _blocks[block];
+  }
+
+  /// Returns a copy of a component.
+  ///
+  /// @param index The index of the component.
+  TComponent load(size_t index) const {
+    return _blocks[index / block_lanes].load(index % block_lanes);
+  }
+
+  /// Overwrites a component.
+  ///
+  /// @param index The index of the component.
+  /// @param component The component to be stored.
+  void store(size_t index, const TComponent& component) {
+    _blocks[index / block_lanes].store(index % block_lanes, component);
+  }
+
+  /// Appends a component.
+  ///
+  /// @param component The component to be appended.
+  void push_back(const TComponent& component) {
+    resize(_size + 1);
+    store(_size - 1, component);
+  }
+
+  /// Appends a value-initialized component.
+  void emplace_back() {
+    push_back(TComponent{});
+  }
+
+  /// Swaps two components.
+  ///
+  /// @param first The index of the first component.
+  /// @param second The index of the second component.
+  void swap(size_t first, size_t second) {
+    const TComponent component = load(first);
+    store(first, load(second));
+    store(second, component);
+  }
+
+  /// Overwrites a component with another one.
+  ///
+  /// @param from The index of the component to be copied.
+  /// @param to The index of the component to be overwritten.
+  void relocate(size_t from, size_t to) {
+    store(to, load(from));
+  }
+
+  /// Reorders the components.
+  ///
+  /// @param order The previous index of each component, i.e., the component at index `i` afterwards is the one at `order[i]` before.
+  void permute(const std::vector<size_t>& order) {
+    std::vector<Block<TComponent>, TAllocator<Block<TComponent>>> blocks(_blocks.size());
+    for (size_t index = 0; index < order.size(); ++index)
+      blocks[index / block_lanes].store(index % block_lanes, load(order[index]));
+    _blocks = std::move(blocks);
+  }
+
+  /// Changes the number of components stored. Appended components have unspecified values.
+  ///
+  /// @param size The new number of components.
+  void resize(size_t size) {
+    _size = size;
+    _blocks.resize((size + block_lanes - 1) / block_lanes);
+  }
+
+  /// Reserve a given capacity of components.
+  ///
+  /// @param capacity The new capacity to be reserved.
+  void reserve(size_t capacity) {
+    _blocks.reserve((capacity + block_lanes - 1) / block_lanes);
+  }
+
+private:
+  /// The blocks storing the components.
+  std::vector<Block<TComponent>, TAllocator<Block<TComponent>>> _blocks;
+
+  /// The number of components stored.
+  size_t _size = 0;
+};
+
+}
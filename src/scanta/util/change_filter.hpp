@@ -0,0 +1,98 @@
+/// @file
+/// @brief System parameters filtering entities by recent changes of a component type.
+
+#pragma once
+
+#include <memory>
+#include <type_traits>
+
+namespace scanta {
+
+/// The kind of changes a change filter selects entities by.
+enum class Change {
+  /// The component has been attached to the entity (or the entity has been created with it).
+  added,
+  /// The component has been attached, or accessed mutably by a system.
+  changed
+};
+
+/// A system parameter which passes a component, while only selecting entities whose component changed since the system last ran.
+///
+/// Used through the `Added` and `Changed` aliases. The component is passed like the wrapped parameter type,
+/// i.e., by value or by (const) reference, and accessed through `*`, `->` or `get()`:
+/// ```cpp
+/// void operator()(scanta::Changed<const Transform&> transform, Mesh& mesh) const {
+///   mesh.upload(transform->pos);
+/// }
+/// ```
+/// Storages track the changes of component types only if some system filters by them. Changes are tracked per entity,
+/// while mutable accesses are marked for all entities a writing system iterated, regardless of whether it actually wrote.
+/// @tparam TParameter The wrapped parameter type, e.g., `const T&`.
+/// @tparam change The kind of changes selecting entities.
+template<typename TParameter, Change change>
+class ChangeFilter {
+public:
+  /// The wrapped parameter type.
+  using Parameter = TParameter;
+
+  /// The component type filtered by.
+  using Component = std::remove_cvref_t<TParameter>;
+
+  /// The kind of changes selecting entities.
+  static constexpr Change filter = change;
+
+  /// Wraps a component.
+  ///
+  /// @param component The component of the entity.
+  ChangeFilter(TParameter component) : _component(wrap(component)) {}
+
+  /// Returns the component.
+  TParameter get() const {
+    if constexpr (std::is_reference_v<TParameter>) return *_component;
+    else return _component;
+  }
+
+  /// Returns the component.
+  TParameter operator*() const {
+    return get();
+  }
+
+  /// Accesses a member of the component.
+  auto operator->() const {
+    if constexpr (std::is_reference_v<TParameter>) return _component;
+    else return std::addressof(_component);
+  }
+
+private:
+  /// The referenced component, or a copy if passed by value.
+  std::conditional_t<std::is_reference_v<TParameter>, std::remove_reference_t<TParameter>*, TParameter> _component;
+
+  /// Converts the component into its stored form.
+  static auto wrap(TParameter component) {
+    if constexpr (std::is_reference_v<TParameter>) return std::addressof(component);
+    else return component;
+  }
+};
+
+/// A system parameter selecting only entities whose component has been attached since the system last ran.
+///
+/// @tparam TParameter The wrapped parameter type, e.g., `const T&`.
+template<typename TParameter>
+using Added = ChangeFilter<TParameter, Change::added>;
+
+/// A system parameter selecting only entities whose component has been attached or accessed mutably since the system last ran.
+///
+/// @tparam TParameter The wrapped parameter type, e.g., `const T&`.
+template<typename TParameter>
+using Changed = ChangeFilter<TParameter, Change::changed>;
+
+/// Whether a type is a change filter parameter.
+///
+/// @tparam T The type.
+template<typename T>
+constexpr bool is_change_filter = false;
+
+template<typename TParameter, Change change>
+constexpr bool is_change_filter<ChangeFilter<TParameter, change>> = true;
+
+}
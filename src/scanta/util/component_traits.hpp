@@ -0,0 +1,69 @@
+/// @file
+/// @brief Customization point for per-component-type storage properties.
+
+#pragma once
+
+namespace scanta {
+
+/// Properties of a component type which storages may take into account.
+///
+/// The primary template declares no properties, so storages fall back to their default behavior.
+/// Specialize it for a component type to declare properties for that type:
+/// ```cpp
+/// struct Position { float x, y, z; };
+///
+/// template<>
+/// struct scanta::component_traits<Position> {
+///   // Store positions in array-of-struct-of-arrays blocks of floats.
+///   using aosoa_scalar = float;
+/// };
+/// ```
+/// Storages detect each property individually, so a specialization only needs to declare the properties it changes.
+/// @tparam TComponent The component type described.
+template<typename TComponent>
+struct component_traits {};
+
+/// The memory layout of the components of a single type.
+enum class Layout {
+  /// One slot per entity in a contiguous column, whether the component is attached or not.
+  dense,
+  /// A sparse set, storing only attached components contiguously, which suits rarely attached component types.
+  sparse,
+  /// One pointer per entity to an individually allocated component, which suits very large component types.
+  boxed
+};
+
+/// The memory layout of a component type, as declared by `component_traits<TComponent>::layout`.
+///
+/// Defaults to `Layout::dense` if none is declared:
+/// ```cpp
+/// template<>
+/// struct scanta::component_traits<Payload> {
+///   static constexpr auto layout = scanta::Layout::boxed;
+/// };
+/// ```
+/// @tparam TComponent The component type.
+template<typename TComponent>
+constexpr Layout layout_of = []() {
+  if constexpr (requires { component_traits<TComponent>::layout; }) return Layout(component_traits<TComponent>::layout);
+  else return Layout::dense;
+}();
+
+/// Whether a component type is double-buffered, as declared by `component_traits<TComponent>::double_buffered`.
+///
+/// Storages supporting it keep a copy of the previous frame's components of such a type. Systems reading the type
+/// get that immutable copy, while systems writing it get the current components, so readers need not wait for writers:
+/// ```cpp
+/// template<>
+/// struct scanta::component_traits<Transform> {
+///   static constexpr bool double_buffered = true;
+/// };
+/// ```
+/// @tparam TComponent The component type.
+template<typename TComponent>
+constexpr bool is_double_buffered = []() {
+  if constexpr (requires { component_traits<TComponent>::double_buffered; }) return bool(component_traits<TComponent>::double_buffered);
+  else return false;
+}();
+
+}
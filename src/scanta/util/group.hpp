@@ -0,0 +1,130 @@
+/// @file
+/// @brief Groups of component types stored interleaved, and utilities for type lists containing them.
+
+#pragma once
+
+#include <tuple>
+#include <type_traits>
+
+#include <boost/hana.hpp>
+namespace hana = boost::hana;
+using namespace hana::literals;
+
+#include "scanta/util/tag.hpp"
+#include "scanta/util/component_traits.hpp"
+
+namespace scanta {
+
+/// A group of component types which are stored interleaved, as a tuple per entity.
+///
+/// This is merely a type list and never instantiated.
+/// @tparam TComponents The component types in the group.
+template<typename... TComponents>
+struct Group {};
+
+/// Describes a column of a storage, which is either a single component type or a group of component types.
+///
+/// @tparam TColumn The component type or `Group`.
+template<typename TColumn>
+struct ColumnTraits {
+  /// The component types stored in the column as a hana::tuple_t.
+  static constexpr auto components = hana::tuple_t<TColumn>;
+
+  /// The type of a single element of the column.
+  using Row = TColumn;
+
+  /// Returns a component stored in an element of the column.
+  ///
+  /// @tparam TComponent The component type to be accessed.
+  /// @param row The element of the column.
+  template<typename TComponent>
+  static TComponent& get(Row& row) {
+    return row;
+  }
+};
+
+/// Describes a column storing a group of component types as tuples.
+///
+/// @tparam TComponents The component types in the group.
+template<typename... TComponents>
+struct ColumnTraits<Group<TComponents...>> {
+  /// The component types stored in the column as a hana::tuple_t.
+  static constexpr auto components = hana::tuple_t<TComponents...>;
+
+  /// The type of a single element of the column.
+  using Row = std::tuple<TComponents...>;
+
+  /// Returns a component stored in an element of the column.
+  ///
+  /// @tparam TComponent The component type to be accessed.
+  /// @param row The element of the column.
+  template<typename TComponent>
+  static TComponent& get(Row& row) {
+    return std::get<TComponent>(row);
+  }
+};
+
+/// Whether a column is a group of component types.
+///
+/// @tparam TColumn The component type or `Group`.
+template<typename TColumn>
+constexpr bool is_group = false;
+
+template<typename... TComponents>
+constexpr bool is_group<Group<TComponents...>> = true;
+
+/// The component types of a list of columns in order, with groups expanded, as a hana::tuple_t.
+///
+/// @tparam TColumns The component types or `Group`s.
+template<typename... TColumns>
+constexpr auto columns_components = hana::flatten(hana::make_tuple(hana::tuple_t<>, ColumnTraits<TColumns>::components...));
+
+/// The index of the column containing some component type in a list of columns.
+///
+/// Compilation will fail if the type is not contained in any column.
+/// @tparam TComponent The component type to be searched.
+/// @tparam TColumns The component types or `Group`s to be searched in.
+template<typename TComponent, typename... TColumns>
+constexpr size_t column_index = []() consteval {
+  auto index = hana::index_if(
+    hana::make_tuple(ColumnTraits<TColumns>::components...),
+    [](auto components) { return hana::contains(components, hana::type_c<TComponent>); }
+  );
+  static_assert(index != hana::nothing, "The type to be indexed is in no column.");
+  return std::decay_t<decltype(index.value())>::value;
+}();
+
+/// Arranges component types into columns, given the groups they should be stored in.
+///
+/// Group members not contained in the component types are dropped, and groups left with
+/// a single member are stored as a single component type. Component types not in any group
+/// are stored in their own column. Tag component types are never grouped, since they are not stored anyway,
+/// and neither are component types with a layout other than `Layout::dense`.
+/// @param groups The groups as a hana::tuple of hana::tuple_t.
+/// @param components The component types as a hana::tuple_t.
+/// @returns The columns as a hana::tuple_t of component types or `Group`s.
+constexpr auto arrange_columns(auto groups, auto components) {
+  // Restrict the groups to the stored dense non-tag component types.
+  auto restricted = hana::remove_if(
+    hana::transform(groups, [&](auto group) {
+      return hana::filter(group, [&](auto component) {
+        return hana::bool_c<decltype(hana::contains(components, component))::value && !is_tag<typename decltype(component)::type>
+          && layout_of<typename decltype(component)::type> == Layout::dense>;
+      });
+    }),
+    [](auto group) { return hana::is_empty(group); }
+  );
+  // The component types not in any group.
+  auto ungrouped = hana::remove_if(components, [&](auto component) {
+    return hana::any_of(restricted, [&](auto group) { return hana::contains(group, component); });
+  });
+  return hana::concat(
+    hana::transform(restricted, [](auto group) {
+      if constexpr (decltype(hana::length(group))::value == 1) return hana::front(group);
+      else return hana::unpack(group, hana::template_<Group>);
+    }),
+    ungrouped
+  );
+}
+
+}
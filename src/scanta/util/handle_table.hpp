@@ -0,0 +1,170 @@
+/// @file
+/// @brief Generation-tagged entity handles and the indirection table resolving them to storage indices.
+
+#pragma once
+
+#include <cstdint>
+#include <cstddef>
+#include <cassert>
+#include <vector>
+#include <filesystem>
+#include <ostream>
+#include <functional>
+
+#include "scanta/util/mapped_vector.hpp"
+
+namespace scanta {
+
+/// An entity handle which stays valid while the entity is moved within a storage.
+///
+/// The handle does not reference the entity's storage index directly, but a slot in a `HandleTable`
+/// which is updated whenever the entity moves. Each slot carries a generation that is incremented
+/// when the slot's entity is reclaimed, invalidating all handles still referencing the slot.
+struct GenerationalHandle {
+  /// The slot in the handle table.
+  uint32_t slot = UINT32_MAX;
+  /// The generation of the slot this handle was created in.
+  uint32_t generation = 0;
+
+  /// Equality operator.
+  bool operator==(const GenerationalHandle&) const = default;
+};
+
+/// Prints a handle as its slot and generation.
+inline std::ostream& operator<<(std::ostream& stream, const GenerationalHandle& handle) {
+  return stream << handle.slot << "v" << handle.generation;
+}
+
+/// Indirection table mapping generational handles to storage indices.
+///
+/// Resolving a handle costs one additional indexed load. Slots of reclaimed entities are reused.
+/// @tparam TVector The vector template storing the slots and released slots (e.g., `std::vector` or `MappedVector`).
+template<template<typename> typename TVector = std::vector>
+class BasicHandleTable {
+public:
+  /// Creates a handle for an entity stored at some index.
+  ///
+  /// @param index The storage index of the entity.
+  /// @returns A handle which resolves to the index.
+  GenerationalHandle create(size_t index) {
+    uint32_t slot;
+    if (!_free.empty()) {
+      // Reuse a released slot. Its generation has been incremented on release.
+      slot = _free.back();
+      _free.pop_back();
+    } else {
+      slot = _slots.size();
+      _slots.emplace_back();
+    }
+    _slots[slot].index = index;
+    return GenerationalHandle{slot, _slots[slot].generation};
+  }
+
+  /// Returns the storage index of the entity referenced by a valid handle.
+  ///
+  /// @param handle The handle to be resolved.
+  size_t index_of(GenerationalHandle handle) const {
+    assert(is_valid(handle));
+    return _slots[handle.slot].index;
+  }
+
+  /// Whether a handle references an entity that has not been reclaimed.
+  ///
+  /// @param handle The handle to be tested.
+  bool is_valid(GenerationalHandle handle) const {
+    return handle.slot < _slots.size() && _slots[handle.slot].generation == handle.generation;
+  }
+
+  /// Updates the storage index of an entity after it has moved.
+  ///
+  /// @param handle The handle of the moved entity.
+  /// @param index The new storage index of the entity.
+  void relocate(GenerationalHandle handle, size_t index) {
+    _slots[handle.slot].index = index;
+  }
+
+  /// Invalidates a handle and makes its slot available for reuse.
+  ///
+  /// @param handle The handle of the reclaimed entity.
+  void release(GenerationalHandle handle) {
+    ++_slots[handle.slot].generation;
+    _free.push_back(handle.slot);
+  }
+
+  /// Whether no handle has ever been created.
+  bool empty() const {
+    return _slots.empty();
+  }
+
+  /// Reserve a given capacity of slots.
+  ///
+  /// @param capacity The new capacity to be reserved.
+  void reserve(size_t capacity) {
+    _slots.reserve(capacity);
+  }
+
+  /// Inspects the files backing a table without modifying them (see `MappedVector::inspect`).
+  ///
+  /// @param path The path of the files, which are suffixed with `.slots` and `.free`.
+  /// @returns Whether any of the files exists, whether both hold compatible vectors, and the number of slots.
+  static MappedFile inspect(const std::filesystem::path& path) {
+    const MappedFile slots = TVector<Slot>::inspect(std::filesystem::path{path} += ".slots");
+    const MappedFile free = TVector<uint32_t>::inspect(std::filesystem::path{path} += ".free");
+    return MappedFile{slots.exists || free.exists, slots.compatible && free.compatible, slots.size};
+  }
+
+  /// Backs the table by files, if stored in vectors which can be backed by files.
+  ///
+  /// @param path The path of the files, which are suffixed with `.slots` and `.free`.
+  /// @param adopt Whether to adopt the table of the files, which must have been inspected to be compatible.
+  /// Otherwise, the files are replaced by the table.
+  void open(const std::filesystem::path& path, bool adopt) {
+    _slots.open(std::filesystem::path{path} += ".slots", adopt);
+    _free.open(std::filesystem::path{path} += ".free", adopt);
+  }
+
+  /// Captures the table into a snapshot as two sections.
+  ///
+  /// @param snapshot The `Snapshot` to be captured into.
+  void capture(auto& snapshot) const {
+    snapshot.capture(_slots);
+    snapshot.capture(_free);
+  }
+
+  /// Replaces the table by the next two sections of a snapshot.
+  ///
+  /// @param reader The `SnapshotReader` to be read from.
+  void restore(auto& reader) {
+    reader.read(_slots);
+    reader.read(_free);
+  }
+
+private:
+  /// A slot of the handle table.
+  struct Slot {
+    /// The current storage index of the entity.
+    size_t index = 0;
+    /// The generation of the slot, incremented on each release.
+    uint32_t generation = 0;
+  };
+
+  /// The slots, indexed by `GenerationalHandle::slot`.
+  TVector<Slot> _slots;
+
+  /// The released slots, available for reuse.
+  TVector<uint32_t> _free;
+};
+
+/// Indirection table mapping generational handles to storage indices, stored on the heap.
+using HandleTable = BasicHandleTable<>;
+
+}
+
+namespace std {
+  template<>
+  struct hash<scanta::GenerationalHandle> {
+    size_t operator()(const scanta::GenerationalHandle& handle) const noexcept {
+      return std::hash<uint64_t>{}((uint64_t{handle.generation} << 32) | handle.slot);
+    }
+  };
+}
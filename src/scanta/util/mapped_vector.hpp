@@ -0,0 +1,368 @@
+/// @file
+/// @brief Vectors of trivially copyable elements in memory-mapped regions, which can be backed by files.
+
+#pragma once
+
+#include <cstdint>
+#include <cstddef>
+#include <cstring>
+#include <cerrno>
+#include <algorithm>
+#include <filesystem>
+#include <iterator>
+#include <memory>
+#include <new>
+#include <system_error>
+#include <type_traits>
+#include <typeinfo>
+#include <utility>
+#include <vector>
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+namespace scanta {
+
+/// Fingerprints a type by its name, size and alignment, to tell files written for different types apart.
+///
+/// The name is the one mangled by the compiler, so fingerprints are only stable between builds of the same compiler.
+/// @tparam T The type to be fingerprinted.
+template<typename T>
+uint64_t type_fingerprint() {
+  // FNV-1a hash over the name, followed by the size and alignment.
+  uint64_t hash = 0xcbf29ce484222325;
+  const auto mix = [&](uint64_t value) { hash = (hash ^ value) * 0x100000001b3; };
+  for (const char* character = typeid(T).name(); *character; ++character) mix(uint8_t(*character));
+  mix(sizeof(T));
+  mix(alignof(T));
+  return hash;
+}
+
+/// The state of a file backing a `MappedVector`, as inspected before opening it.
+struct MappedFile {
+  /// Whether the file exists and is not empty.
+  bool exists = false;
+  /// Whether the file holds a complete vector of the inspected element type.
+  bool compatible = false;
+  /// The number of elements held by a compatible file.
+  size_t size = 0;
+};
+
+/// A vector whose elements live in a memory-mapped region instead of on the heap.
+///
+/// Until a file is opened, the region is an anonymous mapping, behaving like a `std::vector`.
+/// Once opened, the region is a shared mapping of the file, to which all changes are written through
+/// by the operating system. The size is stored in a header at the start of the file, so that a file
+/// written before can be reopened without reading it: its pages are only loaded once accessed.
+/// The region grows by extending the file and mapping it anew, so pointers into it are invalidated
+/// on growth just like with a `std::vector`.
+/// @tparam T The element type, which must be trivially copyable to be stored as raw bytes.
+template<typename T>
+class MappedVector {
+  static_assert(std::is_trivially_copyable_v<T>, "Only trivially copyable types can be stored in mapped vectors.");
+  static_assert(alignof(T) <= 64, "Mapped vectors only align elements to 64 bytes.");
+public:
+  /// The element type.
+  using value_type = T;
+
+  /// Iterators are plain pointers into the region.
+  using iterator = T*;
+
+  /// Iterators are plain pointers into the region.
+  using const_iterator = const T*;
+
+  /// Constructs an empty vector without mapping any memory.
+  MappedVector() = default;
+
+  MappedVector(const MappedVector&) = delete;
+  MappedVector& operator=(const MappedVector&) = delete;
+
+  /// Takes over the region and file of another vector, leaving it empty.
+  MappedVector(MappedVector&& other) noexcept
+    : _file(std::exchange(other._file, -1)), _region(std::exchange(other._region, nullptr)), _capacity(std::exchange(other._capacity, 0)) {}
+
+  /// Swaps the regions and files of two vectors. The previous region is released along with the other vector.
+  MappedVector& operator=(MappedVector&& other) noexcept {
+    std::swap(_file, other._file);
+    std::swap(_region, other._region);
+    std::swap(_capacity, other._capacity);
+    return *this;
+  }
+
+  /// Unmaps the region and closes the file, if any. The file keeps the contents.
+  ~MappedVector() {
+    if (_region) ::munmap(_region, bytes(_capacity));
+    if (_file >= 0) ::close(_file);
+  }
+
+  /// Returns the number of elements stored.
+  size_t size() const {
+    return _region ? header().size : 0;
+  }
+
+  /// Whether no elements are stored.
+  bool empty() const {
+    return size() == 0;
+  }
+
+  /// Returns the number of elements fitting into the region without growing it.
+  size_t capacity() const {
+    return _capacity;
+  }
+
+  /// Returns a pointer to the first element, or `nullptr` if nothing has been mapped yet.
+  T* data() {
+    return _region ? reinterpret_cast<T*>(static_cast<std::byte*>(_region) + header_size) : nullptr;
+  }
+
+  /// Returns a pointer to the first element, or `nullptr` if nothing has been mapped yet.
+  const T* data() const {
+    return _region ? reinterpret_cast<const T*>(static_cast<const std::byte*>(_region) + header_size) : nullptr;
+  }
+
+  /// Returns an element.
+  ///
+  /// @param index The index of the element.
+  T& operator[](size_t index) {
+    return data()[index];
+  }
+
+  /// Returns an element.
+  ///
+  /// @param index The index of the element.
+  const T& operator[](size_t index) const {
+    return data()[index];
+  }
+
+  /// Returns an iterator to the first element.
+  iterator begin() {
+    return data();
+  }
+
+  /// Returns an iterator past the last element.
+  iterator end() {
+    return begin() + size();
+  }
+
+  /// Returns an iterator to the first element.
+  const_iterator begin() const {
+    return data();
+  }
+
+  /// Returns an iterator past the last element.
+  const_iterator end() const {
+    return begin() + size();
+  }
+
+  /// Returns the last element.
+  T& back() {
+    return data()[size() - 1];
+  }
+
+  /// Appends an element, growing the region geometrically if full.
+  ///
+  /// @param value The element to be appended.
+  void push_back(const T& value) {
+    emplace_back(value);
+  }
+
+  /// Constructs an element at the end, growing the region geometrically if full.
+  ///
+  /// @param arguments The arguments forwarded to the element's constructor.
+  /// @returns The constructed element.
+  template<typename... TArguments>
+  T& emplace_back(TArguments&&... arguments) {
+    const size_t index = size();
+    if (index == _capacity) remap(std::max(minimum_capacity, 2 * _capacity));
+    T* element = new (data() + index) T(std::forward<TArguments>(arguments)...);
+    ++header().size;
+    return *element;
+  }
+
+  /// Drops the last element.
+  void pop_back() {
+    --header().size;
+  }
+
+  /// Drops all elements, keeping the capacity.
+  void clear() {
+    if (_region) header().size = 0;
+  }
+
+  /// Changes the number of elements, value-initializing any new ones.
+  ///
+  /// @param size The new number of elements.
+  void resize(size_t size) {
+    const size_t old_size = this->size();
+    if (size > _capacity) remap(size);
+    if (size > old_size) std::uninitialized_value_construct(data() + old_size, data() + size);
+    if (_region) header().size = size;
+  }
+
+  /// Grows the region to a given capacity, unless it already is at least as large.
+  ///
+  /// @param capacity The new capacity to be reserved.
+  void reserve(size_t capacity) {
+    if (capacity > _capacity) remap(capacity);
+  }
+
+  /// Inserts a range of elements.
+  ///
+  /// @param position The position before which the elements are inserted.
+  /// @param first The beginning of the range of elements to be inserted.
+  /// @param last The end of the range of elements to be inserted.
+  /// @returns An iterator to the first inserted element.
+  template<std::input_iterator TIterator>
+  iterator insert(const_iterator position, TIterator first, TIterator last) {
+    const size_t index = position - begin(), count = std::distance(first, last), old_size = size();
+    if (count == 0) return begin() + index;
+    if (old_size + count > _capacity) remap(std::max(old_size + count, 2 * _capacity));
+    std::memmove(data() + index + count, data() + index, (old_size - index) * sizeof(T));
+    std::copy(first, last, data() + index);
+    header().size = old_size + count;
+    return data() + index;
+  }
+
+  /// Rearranges the elements in place such that the element at `order[i]` ends up at `i`.
+  ///
+  /// Keeps the region (and thus the file) instead of gathering into a new vector.
+  /// @param order The permutation of element indices.
+  void permute(const std::vector<size_t>& order) {
+    const std::vector<T> elements(begin(), end());
+    for (size_t index = 0; index < order.size(); ++index) data()[index] = elements[order[index]];
+  }
+
+  /// Inspects a file without modifying it, to decide whether to adopt it before opening it.
+  ///
+  /// @param path The path of the file.
+  /// @param fingerprint The fingerprint the file must have been written with (see `open`).
+  /// @returns Whether the file exists and whether it holds a complete vector of the same element type.
+  static MappedFile inspect(const std::filesystem::path& path, uint64_t fingerprint = type_fingerprint<T>()) {
+    MappedFile inspected;
+    const int file = ::open(path.c_str(), O_RDONLY);
+    if (file < 0) return inspected;
+    Header saved{};
+    struct stat status{};
+    if (::fstat(file, &status) == 0 && status.st_size > 0) {
+      inspected.exists = true;
+      inspected.compatible = size_t(status.st_size) >= header_size
+        && ::pread(file, &saved, sizeof(Header), 0) == sizeof(Header) && saved.magic == magic && saved.element_size == sizeof(T)
+        && saved.fingerprint == fingerprint && saved.size <= (size_t(status.st_size) - header_size) / sizeof(T);
+      if (inspected.compatible) inspected.size = saved.size;
+    }
+    ::close(file);
+    return inspected;
+  }
+
+  /// Backs the vector by a file from now on.
+  ///
+  /// If adopting, the vector's elements are replaced by those of the file, which must have been inspected to be compatible
+  /// (see `inspect`). They are only read from the file as their pages are accessed. Otherwise, the file is replaced by the vector's elements.
+  /// @param path The path of the file, which is created if it does not exist.
+  /// @param adopt Whether to adopt the elements of the file.
+  /// @param fingerprint The fingerprint written to the file, identifying what the elements are, e.g., the fingerprint of
+  /// the element type or of the component types of a storage.
+  /// @throws std::system_error when the file can not be opened, resized or mapped.
+  void open(const std::filesystem::path& path, bool adopt, uint64_t fingerprint = type_fingerprint<T>()) {
+    const int file = ::open(path.c_str(), O_RDWR | O_CREAT, 0644);
+    if (file < 0) throw std::system_error(errno, std::generic_category(), path.string());
+    struct stat status{};
+    if (adopt && ::fstat(file, &status) != 0) {
+      const int error = errno;
+      ::close(file);
+      throw std::system_error(error, std::generic_category(), path.string());
+    }
+    const size_t capacity = adopt ? (size_t(status.st_size) - header_size) / sizeof(T) : _capacity;
+    if (!adopt && ::ftruncate(file, bytes(capacity)) != 0) {
+      const int error = errno;
+      ::close(file);
+      throw std::system_error(error, std::generic_category(), path.string());
+    }
+    void* region = ::mmap(nullptr, bytes(capacity), PROT_READ | PROT_WRITE, MAP_SHARED, file, 0);
+    if (region == MAP_FAILED) {
+      const int error = errno;
+      ::close(file);
+      throw std::system_error(error, std::generic_category(), path.string());
+    }
+    if (!adopt) {
+      // Write the header and elements of the vector to the file.
+      if (_region) std::memcpy(region, _region, bytes(size()));
+      else *static_cast<Header*>(region) = Header{};
+      static_cast<Header*>(region)->fingerprint = fingerprint;
+    }
+    if (_region) ::munmap(_region, bytes(_capacity));
+    if (_file >= 0) ::close(_file);
+    _file = file;
+    _region = region;
+    _capacity = capacity;
+  }
+
+private:
+  /// The header at the start of the region.
+  struct Header {
+    /// Identifies files written by mapped vectors.
+    uint64_t magic = MappedVector::magic;
+    /// The size of the element type, guarding against adopting files of other element types.
+    uint64_t element_size = sizeof(T);
+    /// The number of elements stored.
+    uint64_t size = 0;
+    /// The fingerprint of the elements, guarding against adopting files of other types of the same size.
+    uint64_t fingerprint = 0;
+  };
+
+  /// Identifies files written by mapped vectors.
+  static constexpr uint64_t magic = 0x5343414e54414d56;
+
+  /// The number of bytes reserved for the header, keeping the elements aligned.
+  static constexpr size_t header_size = 64;
+
+  /// The capacity of the region when first growing.
+  static constexpr size_t minimum_capacity = 16;
+
+  /// The file descriptor of the backing file, or -1 if the region is anonymous.
+  int _file = -1;
+
+  /// The mapped region, starting with the header, or `nullptr` if nothing has been mapped yet.
+  void* _region = nullptr;
+
+  /// The number of elements fitting into the region.
+  size_t _capacity = 0;
+
+  /// Returns the header of the region, which must have been mapped.
+  Header& header() {
+    return *static_cast<Header*>(_region);
+  }
+
+  /// Returns the header of the region, which must have been mapped.
+  const Header& header() const {
+    return *static_cast<const Header*>(_region);
+  }
+
+  /// Returns the size of a region for a number of elements.
+  static size_t bytes(size_t capacity) {
+    return header_size + capacity * sizeof(T);
+  }
+
+  /// Grows the region to a new capacity, extending the backing file, if any.
+  ///
+  /// @param capacity The new capacity.
+  /// @throws std::system_error when the file can not be resized or the region can not be mapped.
+  void remap(size_t capacity) {
+    if (_file >= 0 && ::ftruncate(_file, bytes(capacity)) != 0) throw std::system_error(errno, std::generic_category(), "ftruncate");
+    void* region = _file >= 0
+      ? ::mmap(nullptr, bytes(capacity), PROT_READ | PROT_WRITE, MAP_SHARED, _file, 0)
+      : ::mmap(nullptr, bytes(capacity), PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+    if (region == MAP_FAILED) throw std::system_error(errno, std::generic_category(), "mmap");
+    if (_region) {
+      // A mapping of the file already sees the elements, an anonymous one has to be copied to.
+      if (_file < 0) std::memcpy(region, _region, bytes(size()));
+      ::munmap(_region, bytes(_capacity));
+    } else *static_cast<Header*>(region) = Header{};
+    _region = region;
+    _capacity = capacity;
+  }
+};
+
+}
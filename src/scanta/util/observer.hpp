@@ -0,0 +1,139 @@
+/// @file
+/// @brief System parameters passing batches of entities affected by structural events, turning systems into observers.
+
+#pragma once
+
+#include <cstddef>
+#include <span>
+#include <tuple>
+
+namespace scanta {
+
+/// The structural events systems can observe.
+enum class Event {
+  /// An entity has been created (with a set of components attached).
+  created,
+  /// A component has been attached to an entity.
+  attached,
+  /// A component has been detached from an entity.
+  detached,
+  /// An entity (with a set of components attached) has been removed.
+  removed
+};
+
+/// A system parameter passing the batch of entities affected by a structural event during the last frame.
+///
+/// Systems taking it are observers: instead of being called for entities every frame, they are called once
+/// after the deferred operations of a frame have been executed, and only if the event occurred.
+/// Used through the `OnCreate`, `OnAttach`, `OnDetach` and `OnRemove` aliases:
+/// ```cpp
+/// struct SpawnEffects {
+///   auto operator()(scanta::OnCreate<ECS::Entity, Explosion> created) const {
+///     return [created](const auto& manager) {
+///       for (ECS::Entity entity : created) spawn(manager.template get_component<Explosion>(entity));
+///     };
+///   }
+/// };
+/// ```
+/// Observers may return a callable, which is called with the deferred manager, so that they can access the components
+/// of the batch and make structural changes immediately. The events of those changes are observed in the next frame.
+/// Batches contain each entity once, and only entities which still match the event at the end of the frame.
+/// For example, an entity created and removed within the same frame is only part of the batches of removals.
+/// The handles of removed entities are no longer valid, so only they themselves can be used (e.g., as keys).
+/// @tparam event The observed event.
+/// @tparam TEntity The entity handle type.
+/// @tparam TComponents The component types the event refers to. Entities are only created or removed with all of them attached.
+/// Attachments and detachments refer to exactly one component type.
+template<Event event, typename TEntity, typename... TComponents>
+class Observed {
+  static_assert(event == Event::created || event == Event::removed || sizeof...(TComponents) == 1, "Attachments and detachments are observed for exactly one component type.");
+public:
+  /// The entity handle type.
+  using Entity = TEntity;
+
+  /// The component types the event refers to.
+  using Components = std::tuple<TComponents...>;
+
+  /// The observed event.
+  static constexpr Event trigger = event;
+
+  /// Wraps a batch of entities.
+  ///
+  /// @param entities The entities affected by the event.
+  explicit Observed(std::span<const TEntity> entities) : _entities(entities) {}
+
+  /// Returns the entities affected by the event.
+  std::span<const TEntity> entities() const {
+    return _entities;
+  }
+
+  /// Returns the number of entities affected by the event.
+  size_t size() const {
+    return _entities.size();
+  }
+
+  /// Whether no entity has been affected by the event.
+  bool empty() const {
+    return _entities.empty();
+  }
+
+  /// Returns an entity affected by the event.
+  ///
+  /// @param index The index of the entity in the batch.
+  const TEntity& operator[](size_t index) const {
+    return _entities[index];
+  }
+
+  /// Returns an iterator to the first entity.
+  auto begin() const {
+    return _entities.begin();
+  }
+
+  /// Returns an iterator past the last entity.
+  auto end() const {
+    return _entities.end();
+  }
+
+private:
+  /// The entities affected by the event.
+  std::span<const TEntity> _entities;
+};
+
+/// A system parameter passing the entities created with all of some component types attached during the last frame.
+///
+/// @tparam TEntity The entity handle type.
+/// @tparam TComponents The component types required to be attached initially. If none are given, all created entities are passed.
+template<typename TEntity, typename... TComponents>
+using OnCreate = Observed<Event::created, TEntity, TComponents...>;
+
+/// A system parameter passing the entities a component type has been attached to during the last frame.
+///
+/// @tparam TEntity The entity handle type.
+/// @tparam TComponent The attached component type.
+template<typename TEntity, typename TComponent>
+using OnAttach = Observed<Event::attached, TEntity, TComponent>;
+
+/// A system parameter passing the entities a component type has been detached from during the last frame.
+///
+/// @tparam TEntity The entity handle type.
+/// @tparam TComponent The detached component type.
+template<typename TEntity, typename TComponent>
+using OnDetach = Observed<Event::detached, TEntity, TComponent>;
+
+/// A system parameter passing the entities removed with all of some component types attached during the last frame.
+///
+/// @tparam TEntity The entity handle type.
+/// @tparam TComponents The component types required to be attached when removed. If none are given, all removed entities are passed.
+template<typename TEntity, typename... TComponents>
+using OnRemove = Observed<Event::removed, TEntity, TComponents...>;
+
+/// Whether a type is an observed event parameter.
+///
+/// @tparam T The type.
+template<typename T>
+constexpr bool is_observation = false;
+
+template<Event event, typename TEntity, typename... TComponents>
+constexpr bool is_observation<Observed<event, TEntity, TComponents...>> = true;
+
+}
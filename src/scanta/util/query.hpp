@@ -0,0 +1,115 @@
+/// @file
+/// @brief System parameters excluding entities by component types or accessing components which may not be attached.
+
+#pragma once
+
+#include <type_traits>
+
+namespace scanta {
+
+/// A system parameter excluding all entities with a component type attached from the system's query.
+///
+/// It carries no data. Storages matching signatures fold exclusions into their matching, all others skip
+/// excluded entities one by one. Systems excluding a component type required by another system are known to never
+/// be called for the same entities, so the `Parallel` scheduler runs them concurrently even if both write the same data.
+/// ```cpp
+/// void operator()(Velocity& velocity, scanta::Without<Frozen>) const;
+/// ```
+/// Storages accepting exclusions take them wrapped in the list of required component types (e.g., `for_entities_with<A, Without<B>>`).
+/// @tparam TComponent The excluded component type.
+template<typename TComponent>
+struct Without {
+  /// The excluded component type.
+  using Component = TComponent;
+};
+
+/// A system parameter passing a component which may not be attached to the entity, as a possibly null pointer.
+///
+/// The component type does not restrict the entities a system is called for. Like plain parameters,
+/// the component is only written if the component type is non-const:
+/// ```cpp
+/// void operator()(const Transform& transform, scanta::Optional<const Light> light) const {
+///   if (light) add_light(transform, *light);
+/// }
+/// ```
+/// @tparam TComponent The component type, const-qualified for read-only access.
+template<typename TComponent>
+class Optional {
+public:
+  /// The component type.
+  using Component = std::remove_const_t<TComponent>;
+
+  /// Wraps a component.
+  ///
+  /// @param component The component of the entity, or `nullptr` if not attached.
+  Optional(TComponent* component = nullptr) : _component(component) {}
+
+  /// Whether the component is attached to the entity.
+  bool has_value() const {
+    return _component;
+  }
+
+  /// Whether the component is attached to the entity.
+  explicit operator bool() const {
+    return _component;
+  }
+
+  /// Returns the component, or `nullptr` if not attached.
+  TComponent* get() const {
+    return _component;
+  }
+
+  /// Returns the component, which must be attached.
+  TComponent& operator*() const {
+    return *_component;
+  }
+
+  /// Accesses a member of the component, which must be attached.
+  TComponent* operator->() const {
+    return _component;
+  }
+
+private:
+  /// The component, or `nullptr` if not attached.
+  TComponent* _component;
+};
+
+/// Whether a type is an exclusion parameter.
+///
+/// @tparam T The type.
+template<typename T>
+constexpr bool is_exclusion = false;
+
+template<typename TComponent>
+constexpr bool is_exclusion<Without<TComponent>> = true;
+
+/// Whether a type is an optional component parameter.
+///
+/// @tparam T The type.
+template<typename T>
+constexpr bool is_optional = false;
+
+template<typename TComponent>
+constexpr bool is_optional<Optional<TComponent>> = true;
+
+/// Describes an entry of a storage query, which is either a required component type or an excluded one (`Without`).
+///
+/// @tparam T The entry of the query.
+template<typename T>
+struct QueryTraits {
+  /// The component type the entry refers to.
+  using Component = T;
+  /// Whether entities with the component type attached are excluded instead of required.
+  static constexpr bool excluded = false;
+};
+
+/// Describes an excluded entry of a storage query.
+///
+/// @tparam TComponent The excluded component type.
+template<typename TComponent>
+struct QueryTraits<Without<TComponent>> {
+  using Component = TComponent;
+  static constexpr bool excluded = true;
+};
+
+}
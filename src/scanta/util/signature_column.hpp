@@ -0,0 +1,445 @@
+/// @file
+/// @brief Column of entity signatures with block summaries and vectorized matching.
+
+#pragma once
+
+#include <cstdint>
+#include <cstddef>
+#include <vector>
+#include <filesystem>
+#include <algorithm>
+#include <utility>
+#include <type_traits>
+
+#if defined(__AVX2__) || defined(__SSE4_1__)
+#include <immintrin.h>
+#endif
+
+#include <bitset2/bitset2.hpp>
+
+#include "scanta/util/mapped_vector.hpp"
+
+namespace scanta {
+
+/// The signature type for a number of component types.
+///
+/// Up to 64 component types, signatures are native machine words which can be matched with vector instructions.
+/// Larger signatures fall back to a bitset.
+/// @tparam component_count The number of component types represented in the signature.
+template<size_t component_count>
+using SignatureOf = std::conditional_t<(component_count <= 64), uint64_t, Bitset2::bitset2<component_count>>;
+
+/// Stores the signatures of all entities of a storage contiguously, separate from other entity metadata.
+///
+/// If signatures are machine words, the column is divided into blocks of 64 entities, each of which carries
+/// a summary of the bitwise OR and AND over its signatures. When iterating, blocks in which no entity can
+/// match are skipped and blocks in which all entities must match are accepted without inspecting any signature.
+/// All other blocks are matched with SIMD instructions (AVX2 or SSE4.1, if enabled at compile-time) into a bit mask.
+/// Matching may also exclude a signature, whose bits must all be off. Both are folded into a single comparison
+/// of the masked signature, `(signature & (required | excluded)) == required`.
+///
+/// Summaries are updated conservatively on each modification (an OR summary may have excess bits, an AND
+/// summary may lack bits), which only reduces the number of blocks that can be skipped or accepted wholesale.
+/// `refresh` recomputes the summaries of modified blocks exactly.
+/// @tparam TSignature The signature type.
+/// @tparam TVector The vector template storing the signatures (e.g., `std::vector` or `MappedVector`).
+template<typename TSignature, template<typename> typename TVector = std::vector>
+class SignatureColumn {
+public:
+  /// Whether signatures are machine words, enabling block summaries and vectorized matching.
+  static constexpr bool packed = std::is_same_v<TSignature, uint64_t>;
+
+  /// The number of entities summarized by a block.
+  static constexpr size_t block_size = 64;
+
+  /// Returns the number of signatures stored.
+  size_t size() const {
+    return _signatures.size();
+  }
+
+  /// Returns the signature of an entity.
+  ///
+  /// @param index The index of the entity.
+  const TSignature& operator[](size_t index) const {
+    return _signatures[index];
+  }
+
+  /// Appends the signature of a new entity.
+  ///
+  /// @param signature The signature to be appended.
+  void push_back(const TSignature& signature) {
+    _signatures.push_back(signature);
+    if constexpr (packed) {
+      const size_t block = (_signatures.size() - 1) / block_size;
+      if (block == _any.size()) {
+        // The first signature of a block is its exact summary.
+        _any.push_back(signature);
+        _all.push_back(signature);
+        _dirty.push_back(false);
+      } else summarize(_signatures.size() - 1);
+    }
+  }
+
+  /// Replaces the signature of an entity.
+  ///
+  /// @param index The index of the entity.
+  /// @param signature The new signature.
+  void assign(size_t index, const TSignature& signature) {
+    _signatures[index] = signature;
+    if constexpr (packed) summarize(index);
+  }
+
+  /// Swaps the signatures of two entities.
+  ///
+  /// @param first The index of the first entity.
+  /// @param second The index of the second entity.
+  void swap(size_t first, size_t second) {
+    std::swap(_signatures[first], _signatures[second]);
+    if constexpr (packed) {
+      summarize(first);
+      summarize(second);
+    }
+  }
+
+  /// Drops the signatures of all entities at or beyond some index.
+  ///
+  /// @param size The new number of signatures.
+  void resize(size_t size) {
+    _signatures.resize(size);
+    if constexpr (packed) {
+      const size_t blocks = (size + block_size - 1) / block_size;
+      _any.resize(blocks);
+      _all.resize(blocks);
+      _dirty.resize(blocks);
+      // The summary of a truncated block includes dropped signatures.
+      if (size % block_size) _dirty.back() = true;
+    }
+  }
+
+  /// Reserve a given capacity of signatures.
+  ///
+  /// @param capacity The new capacity to be reserved.
+  void reserve(size_t capacity) {
+    _signatures.reserve(capacity);
+  }
+
+  /// Inspects the file backing the signatures without modifying it (see `MappedVector::inspect`).
+  ///
+  /// @param path The path of the file.
+  static MappedFile inspect(const std::filesystem::path& path) {
+    return TVector<TSignature>::inspect(path);
+  }
+
+  /// Backs the signatures by a file, if stored in a vector which can be backed by a file.
+  ///
+  /// @param path The path of the file.
+  /// @param adopt Whether to adopt and summarize the signatures of the file, which must have been inspected to be compatible.
+  /// Otherwise, the file is replaced by the signatures.
+  void open(const std::filesystem::path& path, bool adopt) {
+    _signatures.open(path, adopt);
+    if (adopt) summarize_all();
+  }
+
+  /// Captures the signatures into a snapshot as a single section.
+  ///
+  /// @param snapshot The `Snapshot` to be captured into.
+  void capture(auto& snapshot) const {
+    snapshot.capture(_signatures);
+  }
+
+  /// Replaces the signatures by the next section of a snapshot, and summarizes them.
+  ///
+  /// @param reader The `SnapshotReader` to be read from.
+  void restore(auto& reader) {
+    reader.read(_signatures);
+    summarize_all();
+  }
+
+  /// Recomputes the summaries of all blocks modified since the last refresh.
+  void refresh() {
+    if constexpr (packed) {
+      for (size_t block = 0; block < _any.size(); ++block) {
+        if (!_dirty[block]) continue;
+        const size_t end = std::min(_signatures.size(), (block + 1) * block_size);
+        uint64_t any = 0, all = ~uint64_t{0};
+        for (size_t index = block * block_size; index < end; ++index) {
+          any |= _signatures[index];
+          all &= _signatures[index];
+        }
+        _any[block] = any;
+        _all[block] = all;
+        _dirty[block] = false;
+      }
+    }
+  }
+
+  /// Calls a callable with the index of each entity whose signature contains all bits of a signature
+  /// and none of an excluded one, in ascending order.
+  ///
+  /// @param signature The signature to be matched.
+  /// @param excluded The signature whose bits must all be off.
+  /// @param callable The callable to be called with each matching entity's index.
+  void for_each_match(const TSignature& signature, const TSignature& excluded, auto&& callable) const {
+    if constexpr (packed) {
+      for (size_t block = 0; block < _any.size(); ++block)
+        for_each_match_in_block(block, signature, excluded, callable);
+    } else {
+      const TSignature mask = signature | excluded;
+      for (size_t index = 0; index < _signatures.size(); ++index)
+        if ((_signatures[index] & mask) == signature) callable(index);
+    }
+  }
+
+  /// Calls a callable with the index of each entity whose signature contains all bits of a signature, in ascending order.
+  ///
+  /// @param signature The signature to be matched.
+  /// @param callable The callable to be called with each matching entity's index.
+  void for_each_match(const TSignature& signature, auto&& callable) const {
+    for_each_match(signature, TSignature(0), callable);
+  }
+
+  /// Calls a callable with the index of each entity whose signature contains all bits of a signature and none of an excluded one.
+  /// Employs inner parallelism over blocks.
+  ///
+  /// @param signature The signature to be matched.
+  /// @param excluded The signature whose bits must all be off.
+  /// @param callable The callable to be called concurrently with each matching entity's index.
+  void for_each_match_parallel(const TSignature& signature, const TSignature& excluded, auto&& callable) const {
+    if constexpr (packed) {
+      #pragma omp parallel for
+      for (size_t block = 0; block < _any.size(); ++block)
+        for_each_match_in_block(block, signature, excluded, callable);
+    } else {
+      const TSignature mask = signature | excluded;
+      #pragma omp parallel for
+      for (size_t index = 0; index < _signatures.size(); ++index)
+        if ((_signatures[index] & mask) == signature) callable(index);
+    }
+  }
+
+  /// Calls a callable with the index of each entity whose signature contains all bits of a signature.
+  /// Employs inner parallelism over blocks.
+  ///
+  /// @param signature The signature to be matched.
+  /// @param callable The callable to be called concurrently with each matching entity's index.
+  void for_each_match_parallel(const TSignature& signature, auto&& callable) const {
+    for_each_match_parallel(signature, TSignature(0), callable);
+  }
+
+  /// Calls a callable with each maximal run of consecutive entities whose signatures contain all bits of a signature
+  /// and none of an excluded one, in ascending order.
+  ///
+  /// @param signature The signature to be matched.
+  /// @param excluded The signature whose bits must all be off.
+  /// @param callable The callable to be called with the index of the first entity and the number of entities of each run.
+  void for_each_run(const TSignature& signature, const TSignature& excluded, auto&& callable) const {
+    size_t run_begin = 0, run_count = 0;
+    // Runs reaching the end of a block are merged with runs starting at the beginning of the next one.
+    auto extend = [&](size_t begin, size_t count) {
+      if (run_count && run_begin + run_count == begin) {
+        run_count += count;
+        return;
+      }
+      if (run_count) callable(run_begin, run_count);
+      run_begin = begin;
+      run_count = count;
+    };
+    for (size_t block = 0; block < block_count(); ++block)
+      for_each_run_in_block(block, signature, excluded, extend);
+    if (run_count) callable(run_begin, run_count);
+  }
+
+  /// Calls a callable with each maximal run of consecutive entities whose signatures contain all bits of a signature,
+  /// in ascending order.
+  ///
+  /// @param signature The signature to be matched.
+  /// @param callable The callable to be called with the index of the first entity and the number of entities of each run.
+  void for_each_run(const TSignature& signature, auto&& callable) const {
+    for_each_run(signature, TSignature(0), callable);
+  }
+
+  /// Calls a callable with each run of consecutive entities whose signatures contain all bits of a signature and none of an excluded one.
+  /// Employs inner parallelism over blocks.
+  ///
+  /// Runs are split at block boundaries, so that each block is processed independently.
+  /// @param signature The signature to be matched.
+  /// @param excluded The signature whose bits must all be off.
+  /// @param callable The callable to be called concurrently with the index of the first entity and the number of entities of each run.
+  void for_each_run_parallel(const TSignature& signature, const TSignature& excluded, auto&& callable) const {
+    #pragma omp parallel for
+    for (size_t block = 0; block < block_count(); ++block)
+      for_each_run_in_block(block, signature, excluded, callable);
+  }
+
+  /// Calls a callable with each run of consecutive entities whose signatures contain all bits of a signature.
+  /// Employs inner parallelism over blocks.
+  ///
+  /// Runs are split at block boundaries, so that each block is processed independently.
+  /// @param signature The signature to be matched.
+  /// @param callable The callable to be called concurrently with the index of the first entity and the number of entities of each run.
+  void for_each_run_parallel(const TSignature& signature, auto&& callable) const {
+    for_each_run_parallel(signature, TSignature(0), callable);
+  }
+
+  /// Matches up to 64 consecutive signatures.
+  ///
+  /// @param begin The index of the first entity to be matched.
+  /// @param count The number of entities to be matched.
+  /// @param signature The signature whose bits must all be contained.
+  /// @param excluded The signature whose bits must all be off.
+  /// @returns A bit mask with bit `i` set if the entity at `begin + i` matches.
+  uint64_t match(size_t begin, size_t count, const TSignature& signature, const TSignature& excluded = TSignature(0)) const {
+    if constexpr (packed) return match(_signatures.data() + begin, count, signature, excluded);
+    else {
+      const TSignature mask = signature | excluded;
+      uint64_t matches = 0;
+      for (size_t index = 0; index < count; ++index)
+        matches |= uint64_t((_signatures[begin + index] & mask) == signature) << index;
+      return matches;
+    }
+  }
+
+private:
+  /// The signatures, indexed by entity.
+  TVector<TSignature> _signatures;
+
+  /// The bitwise OR over all signatures in each block.
+  ///
+  /// A block can only contain matching entities if this contains all bits matched.
+  std::vector<uint64_t> _any;
+
+  /// The bitwise AND over all signatures in each block.
+  ///
+  /// All entities of a block match if this contains all bits matched.
+  std::vector<uint64_t> _all;
+
+  /// Whether the summaries of each block are inexact.
+  std::vector<bool> _dirty;
+
+  /// Conservatively includes a modified signature in the summary of its block.
+  ///
+  /// @param index The index of the modified entity.
+  void summarize(size_t index) {
+    const size_t block = index / block_size;
+    _any[block] |= _signatures[index];
+    _all[block] &= _signatures[index];
+    _dirty[block] = true;
+  }
+
+  /// Recomputes the summaries of all blocks after the signatures have been replaced wholesale.
+  void summarize_all() {
+    if constexpr (packed) {
+      const size_t blocks = block_count();
+      _any.assign(blocks, 0);
+      _all.assign(blocks, 0);
+      _dirty.assign(blocks, true);
+      refresh();
+    }
+  }
+
+  /// Returns the number of blocks, the last of which may be partially used.
+  size_t block_count() const {
+    return (_signatures.size() + block_size - 1) / block_size;
+  }
+
+  /// Matches the signatures of a single block, using the block summaries if available.
+  ///
+  /// @param block The index of the block.
+  /// @param signature The signature to be matched.
+  /// @param excluded The signature whose bits must all be off.
+  /// @returns A bit mask with bit `i` set if the `i`-th entity of the block matches.
+  uint64_t match_block(size_t block, const TSignature& signature, const TSignature& excluded) const {
+    const size_t begin = block * block_size;
+    const size_t count = std::min(block_size, _signatures.size() - begin);
+    if constexpr (packed) {
+      // No entity of the block can match.
+      if ((_any[block] & signature) != signature || (_all[block] & excluded)) return 0;
+      // Every entity of the block matches.
+      if ((_all[block] & signature) == signature && !(_any[block] & excluded))
+        return count == block_size ? ~uint64_t{0} : (uint64_t{1} << count) - 1;
+    }
+    // Otherwise, match each entity into a bit mask.
+    return match(begin, count, signature, excluded);
+  }
+
+  /// Calls a callable with the index of each matching entity of a single block.
+  ///
+  /// @param block The index of the block.
+  /// @param signature The signature to be matched.
+  /// @param excluded The signature whose bits must all be off.
+  /// @param callable The callable to be called with each matching entity's index.
+  void for_each_match_in_block(size_t block, uint64_t signature, uint64_t excluded, auto& callable) const {
+    const size_t begin = block * block_size;
+    uint64_t matches = match_block(block, signature, excluded);
+    // Visit the set bits from lowest to highest.
+    while (matches) {
+      callable(begin + __builtin_ctzll(matches));
+      matches &= matches - 1;
+    }
+  }
+
+  /// Calls a callable with each maximal run of consecutive matching entities within a single block.
+  ///
+  /// @param block The index of the block.
+  /// @param signature The signature to be matched.
+  /// @param excluded The signature whose bits must all be off.
+  /// @param callable The callable to be called with the index of the first entity and the number of entities of each run.
+  void for_each_run_in_block(size_t block, const TSignature& signature, const TSignature& excluded, auto& callable) const {
+    const size_t begin = block * block_size;
+    uint64_t matches = match_block(block, signature, excluded);
+    while (matches) {
+      // A run starts at the lowest set bit and is as long as the number of consecutive set bits from there.
+      const size_t first = __builtin_ctzll(matches);
+      const uint64_t shifted = ~(matches >> first);
+      const size_t count = shifted ? __builtin_ctzll(shifted) : block_size - first;
+      callable(begin + first, count);
+      if (first + count == block_size) break;
+      // Clear the bits of the run.
+      matches &= ~uint64_t{0} << (first + count);
+    }
+  }
+
+  /// Matches up to 64 consecutive signatures.
+  ///
+  /// @param signatures The first signature to be matched.
+  /// @param count The number of signatures to be matched.
+  /// @param signature The signature whose bits must all be contained.
+  /// @param excluded The signature whose bits must all be off.
+  /// @returns A bit mask with bit `i` set if the `i`-th signature matches.
+  static uint64_t match(const uint64_t* signatures, size_t count, uint64_t signature, uint64_t excluded) {
+    uint64_t matches = 0;
+    size_t index = 0;
+    // The bits compared, of which exactly the required ones must be set.
+    const uint64_t compared = signature | excluded;
+    #if defined(__AVX2__)
+    // Match 8 signatures per iteration in two 4-lane comparisons.
+    const __m256i required = _mm256_set1_epi64x(signature);
+    const __m256i mask = _mm256_set1_epi64x(compared);
+    for (; index + 8 <= count; index += 8) {
+      const __m256i low = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(signatures + index));
+      const __m256i high = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(signatures + index + 4));
+      const int low_mask = _mm256_movemask_pd(_mm256_castsi256_pd(_mm256_cmpeq_epi64(_mm256_and_si256(low, mask), required)));
+      const int high_mask = _mm256_movemask_pd(_mm256_castsi256_pd(_mm256_cmpeq_epi64(_mm256_and_si256(high, mask), required)));
+      matches |= uint64_t(low_mask | (high_mask << 4)) << index;
+    }
+    #elif defined(__SSE4_1__)
+    // Match 8 signatures per iteration in four 2-lane comparisons.
+    const __m128i required = _mm_set1_epi64x(signature);
+    const __m128i mask = _mm_set1_epi64x(compared);
+    for (; index + 8 <= count; index += 8) {
+      int lanes = 0;
+      for (size_t lane = 0; lane < 8; lane += 2) {
+        const __m128i pair = _mm_loadu_si128(reinterpret_cast<const __m128i*>(signatures + index + lane));
+        lanes |= _mm_movemask_pd(_mm_castsi128_pd(_mm_cmpeq_epi64(_mm_and_si128(pair, mask), required))) << lane;
+      }
+      matches |= uint64_t(lanes) << index;
+    }
+    #endif
+    // Match the remaining signatures one by one.
+    for (; index < count; ++index)
+      matches |= uint64_t((signatures[index] & compared) == signature) << index;
+    return matches;
+  }
+};
+
+}
@@ -0,0 +1,174 @@
+/// @file
+/// @brief Slab pools recycling fixed-size slots, and an allocator drawing from them.
+
+#pragma once
+
+#include <algorithm>
+#include <cstddef>
+#include <memory>
+#include <new>
+#include <vector>
+
+namespace scanta {
+
+/// Pool allocating fixed-size slots from large slabs.
+///
+/// Slots are handed out from contiguous slabs, which are allocated with a geometrically growing size.
+/// Released slots are kept in an intrusive free list and recycled before new slabs are allocated.
+/// The slabs are returned to the global allocator when the pool is destroyed.
+///
+/// The pool is not synchronized, just like the storage owning it.
+class SlabPool {
+public:
+  /// Constructs a pool without any slabs.
+  ///
+  /// @param size The size of each slot in bytes, which is at least that of a pointer.
+  /// @param alignment The alignment of each slot, which is at least that of a pointer.
+  SlabPool(size_t size, size_t alignment) :
+    _alignment(slot_alignment(alignment)),
+    _size(slot_size(size, alignment))
+  {}
+
+  SlabPool(const SlabPool&) = delete;
+  SlabPool& operator=(const SlabPool&) = delete;
+
+  /// Destructor releasing all slabs, whether their slots have been deallocated or not.
+  ~SlabPool() {
+    for (std::byte* slab : _slabs) ::operator delete(slab, std::align_val_t{_alignment});
+  }
+
+  /// Whether the pool hands out slots fitting objects of some size and alignment.
+  ///
+  /// @param size The size of the objects in bytes.
+  /// @param alignment The alignment of the objects.
+  bool fits(size_t size, size_t alignment) const {
+    return slot_size(size, alignment) == _size && slot_alignment(alignment) == _alignment;
+  }
+
+  /// Allocates uninitialized memory for a single object.
+  void* allocate() {
+    if (!_free) grow();
+    Link* slot = _free;
+    _free = slot->next;
+    return slot;
+  }
+
+  /// Returns the memory of a single object (which must have been destroyed already) to the pool.
+  ///
+  /// @param pointer The memory previously obtained from `allocate`.
+  void deallocate(void* pointer) {
+    _free = new (pointer) Link{_free};
+  }
+
+private:
+  /// A free slot links to the next free slot.
+  struct Link {
+    Link* next;
+  };
+
+  /// Returns the alignment of slots for objects of some alignment.
+  static size_t slot_alignment(size_t alignment) {
+    return std::max(alignment, alignof(Link));
+  }
+
+  /// Returns the size of slots for objects of some size and alignment.
+  ///
+  /// The size is rounded up to the alignment, so that consecutive slots stay aligned.
+  static size_t slot_size(size_t size, size_t alignment) {
+    const size_t rounding = slot_alignment(alignment);
+    return (std::max(size, sizeof(Link)) + rounding - 1) / rounding * rounding;
+  }
+
+  /// The alignment of each slot.
+  size_t _alignment;
+
+  /// The size of each slot in bytes.
+  size_t _size;
+
+  /// The slabs allocated so far.
+  std::vector<std::byte*> _slabs;
+
+  /// The head of the free list.
+  Link* _free = nullptr;
+
+  /// The number of slots of the next slab.
+  size_t _slab_size = 64;
+
+  /// Allocates a new slab and links all of its slots into the free list.
+  void grow() {
+    _slabs.reserve(_slabs.size() + 1);
+    std::byte* slab = static_cast<std::byte*>(::operator new(_slab_size * _size, std::align_val_t{_alignment}));
+    _slabs.push_back(slab);
+    for (size_t i = _slab_size; i-- > 0;) deallocate(slab + i * _size);
+    _slab_size *= 2;
+  }
+};
+
+/// Set of slab pools, one for each slot size and alignment allocated from it.
+///
+/// Objects of different types share a pool if their slots have the same size and alignment.
+class SlabPools {
+public:
+  /// Returns the pool for objects of some type, creating it if necessary.
+  ///
+  /// @tparam T The type of objects allocated.
+  template<typename T>
+  SlabPool& of() {
+    // Only a handful of slot sizes are in use, so a linear search is sufficient.
+    for (const auto& pool : _pools)
+      if (pool->fits(sizeof(T), alignof(T))) return *pool;
+    return *_pools.emplace_back(std::make_unique<SlabPool>(sizeof(T), alignof(T)));
+  }
+
+private:
+  /// The pools, which stay at the same address when more are added.
+  std::vector<std::unique_ptr<SlabPool>> _pools;
+};
+
+/// Allocator drawing single objects from a set of slab pools.
+///
+/// Array allocations are forwarded to the standard allocator.
+/// Each allocator shares ownership of the pools, so that objects allocated by it (e.g., via `std::allocate_shared`,
+/// which keeps a copy of the allocator) may outlive the storage owning the pools.
+/// @tparam T The type of objects allocated.
+template<typename T>
+class SlabAllocator {
+  template<typename>
+  friend class SlabAllocator;
+public:
+  using value_type = T;
+
+  /// Constructs an allocator drawing from some pools.
+  ///
+  /// @param pools The pools to draw from.
+  explicit SlabAllocator(std::shared_ptr<SlabPools> pools) : _pools(std::move(pools)), _pool(&_pools->template of<T>()) {}
+
+  /// Converting constructor required for rebinding, drawing from the same pools.
+  template<typename U>
+  SlabAllocator(const SlabAllocator<U>& other) : SlabAllocator(other._pools) {}
+
+  T* allocate(size_t count) {
+    if (count == 1) return static_cast<T*>(_pool->allocate());
+    return std::allocator<T>{}.allocate(count);
+  }
+
+  void deallocate(T* pointer, size_t count) {
+    if (count == 1) _pool->deallocate(pointer);
+    else std::allocator<T>{}.deallocate(pointer, count);
+  }
+
+  /// Slab allocators drawing from the same pools are interchangeable.
+  template<typename U>
+  bool operator==(const SlabAllocator<U>& other) const {
+    return _pools == other._pools;
+  }
+
+private:
+  /// The pools shared with all allocators rebound from this one.
+  std::shared_ptr<SlabPools> _pools;
+
+  /// The pool of this allocator's type, cached to avoid the lookup on each allocation.
+  SlabPool* _pool;
+};
+
+}
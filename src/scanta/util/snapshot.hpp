@@ -0,0 +1,381 @@
+/// @file
+/// @brief Binary snapshots of storages, captured on the frame thread and written by a background thread.
+
+#pragma once
+
+#include <algorithm>
+#include <cstdint>
+#include <cstddef>
+#include <cstring>
+#include <concepts>
+#include <condition_variable>
+#include <deque>
+#include <exception>
+#include <filesystem>
+#include <fstream>
+#include <functional>
+#include <istream>
+#include <memory>
+#include <mutex>
+#include <ostream>
+#include <span>
+#include <stdexcept>
+#include <thread>
+#include <tuple>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+#include "scanta/util/component_traits.hpp"
+
+namespace scanta {
+
+/// Whether values of a type can be written to snapshots.
+///
+/// Trivially copyable types are written as raw bytes and tuples member by member. Any other type
+/// requires its `component_traits` to declare how to write and read a value:
+/// ```cpp
+/// template<>
+/// struct scanta::component_traits<Name> {
+///   static void write(std::ostream& stream, const Name& name);
+///   static Name read(std::istream& stream);
+/// };
+/// ```
+/// @tparam T The type to be written.
+template<typename T>
+constexpr bool is_serializable = []() {
+  if constexpr (std::is_trivially_copyable_v<T>) return true;
+  else if constexpr (requires (std::ostream& out, std::istream& in, const T& value) {
+    component_traits<T>::write(out, value);
+    { component_traits<T>::read(in) } -> std::convertible_to<T>;
+  }) return true;
+  else return false;
+}();
+
+template<typename... Ts>
+constexpr bool is_serializable<std::tuple<Ts...>> = (is_serializable<Ts> && ...);
+
+/// Writes a single value to a binary stream.
+///
+/// @param stream The stream to be written to.
+/// @param value The value to be written.
+template<typename T>
+void write_value(std::ostream& stream, const T& value) {
+  static_assert(is_serializable<T>, "Values of this type can not be written to snapshots.");
+  if constexpr (requires { component_traits<T>::write(stream, value); }) component_traits<T>::write(stream, value);
+  else if constexpr (std::is_trivially_copyable_v<T>) stream.write(reinterpret_cast<const char*>(&value), sizeof(T));
+  else std::apply([&](const auto&... members) { (write_value(stream, members), ...); }, value);
+}
+
+/// Reads a single value from a binary stream, as written by `write_value`.
+///
+/// @param stream The stream to be read from.
+/// @param value The value to be overwritten.
+template<typename T>
+void read_value(std::istream& stream, T& value) {
+  static_assert(is_serializable<T>, "Values of this type can not be read from snapshots.");
+  if constexpr (requires { component_traits<T>::read(stream); }) value = component_traits<T>::read(stream);
+  else if constexpr (std::is_trivially_copyable_v<T>) stream.read(reinterpret_cast<char*>(&value), sizeof(T));
+  else std::apply([&](auto&... members) { (read_value(stream, members), ...); }, value);
+}
+
+/// A consistent copy of the state of a storage, to be written to a file later on, possibly by another thread.
+///
+/// A snapshot consists of sections, each of which is a copy of a range of elements, e.g. a column.
+/// Sections of trivially copyable elements are captured with a single bulk copy and written as raw bytes.
+/// All other sections are copied element-wise and only serialized when written.
+/// The file starts with a header, followed by the sections in order of capture, each starting with the size
+/// of its elements (or 0 if serialized) and their number. Storages restore themselves by reading the sections
+/// in the same order through a `SnapshotReader`.
+///
+/// Cleared snapshots keep their memory, so that capturing into a snapshot written before does not need to
+/// allocate (and fault in) fresh pages for each bulk copy.
+class Snapshot {
+public:
+  /// Identifies snapshot files.
+  static constexpr uint64_t magic = 0x5343414e5441534e;
+
+  /// The version of the file format.
+  static constexpr uint64_t version = 1;
+
+  /// Captures a copy of a range of elements as the next section.
+  ///
+  /// @param elements The elements to be copied.
+  template<typename T>
+  void capture(std::span<const T> elements) {
+    static_assert(is_serializable<T>, "Values of this type can not be written to snapshots.");
+    if (_count == _sections.size()) _sections.emplace_back();
+    Section& section = _sections[_count++];
+    section.count = elements.size();
+    if constexpr (std::is_trivially_copyable_v<T>) {
+      section.element_size = sizeof(T);
+      // Reuse the memory of the section if large enough. It is left uninitialized, so that its pages are only touched once.
+      if (section.capacity < elements.size_bytes()) {
+        section.bytes.reset(new std::byte[elements.size_bytes()]);
+        section.capacity = elements.size_bytes();
+      }
+      if (!elements.empty()) std::memcpy(section.bytes.get(), elements.data(), elements.size_bytes());
+    } else {
+      section.element_size = 0;
+      section.serialize = [copy = std::vector<T>(elements.begin(), elements.end())](std::ostream& stream) {
+        for (const T& element : copy) write_value(stream, element);
+      };
+    }
+  }
+
+  /// Captures a copy of a vector of elements as the next section.
+  ///
+  /// @param elements The elements to be copied.
+  template<typename TVector>
+  void capture(const TVector& elements) {
+    capture(std::span<const typename TVector::value_type>(elements.data(), elements.size()));
+  }
+
+  /// Drops all sections, keeping the memory of bulk copies for capturing again.
+  void clear() {
+    for (size_t index = 0; index < _count; ++index) _sections[index].serialize = nullptr;
+    _count = 0;
+  }
+
+  /// Writes the snapshot to a stream.
+  ///
+  /// @param stream The binary stream to be written to.
+  void write(std::ostream& stream) const {
+    const uint64_t header[] = {magic, version, _count};
+    stream.write(reinterpret_cast<const char*>(header), sizeof(header));
+    for (size_t index = 0; index < _count; ++index) {
+      const Section& section = _sections[index];
+      const uint64_t section_header[] = {section.element_size, section.count};
+      stream.write(reinterpret_cast<const char*>(section_header), sizeof(section_header));
+      if (section.serialize) section.serialize(stream);
+      else stream.write(reinterpret_cast<const char*>(section.bytes.get()), section.count * section.element_size);
+    }
+  }
+
+  /// Writes the snapshot to a file.
+  ///
+  /// The snapshot is written to a temporary file first, which then replaces the file,
+  /// so that the file always holds a complete snapshot.
+  /// @param path The path of the file.
+  /// @throws std::runtime_error when the file can not be written.
+  void write(const std::filesystem::path& path) const {
+    std::filesystem::path temporary = path;
+    temporary += ".tmp";
+    {
+      std::ofstream stream(temporary, std::ios::binary | std::ios::trunc);
+      write(stream);
+      if (!stream.flush()) throw std::runtime_error("Could not write snapshot to " + temporary.string());
+    }
+    std::filesystem::rename(temporary, path);
+  }
+
+private:
+  /// A captured copy of a range of elements.
+  struct Section {
+    /// The size of an element, or 0 if serialized.
+    uint64_t element_size = 0;
+    /// The number of elements.
+    uint64_t count = 0;
+    /// The bulk copy of trivially copyable elements.
+    std::unique_ptr<std::byte[]> bytes;
+    /// The size of the memory of the bulk copy.
+    size_t capacity = 0;
+    /// Serializes the copy of other elements.
+    std::function<void(std::ostream&)> serialize;
+  };
+
+  /// The sections, the first `_count` of which have been captured, while the others only keep their memory.
+  std::vector<Section> _sections;
+
+  /// The number of captured sections.
+  size_t _count = 0;
+};
+
+/// Reads the sections of a snapshot file in order of capture.
+class SnapshotReader {
+public:
+  /// Opens a snapshot file and reads its header.
+  ///
+  /// @param path The path of the snapshot file.
+  /// @throws std::runtime_error when the file can not be read or is not a snapshot.
+  SnapshotReader(const std::filesystem::path& path) : _stream(path, std::ios::binary), _path(path) {
+    uint64_t header[3] = {};
+    _stream.read(reinterpret_cast<char*>(header), sizeof(header));
+    if (!_stream || header[0] != Snapshot::magic || header[1] != Snapshot::version)
+      throw std::runtime_error("No snapshot in " + _path.string());
+    _sections = header[2];
+    _size = std::filesystem::file_size(path);
+  }
+
+  /// Reads the next section into a vector, replacing its elements.
+  ///
+  /// Trivially copyable elements are read directly into the vector's memory with a single bulk read.
+  /// @param elements The vector to be read into.
+  /// @throws std::runtime_error when the section does not hold elements of the vector's type.
+  template<typename TVector>
+  void read(TVector& elements) {
+    using T = typename TVector::value_type;
+    const size_t count = read_section(std::is_trivially_copyable_v<T> ? sizeof(T) : 0);
+    elements.clear();
+    if constexpr (std::is_trivially_copyable_v<T>) {
+      elements.resize(count);
+      _stream.read(reinterpret_cast<char*>(elements.data()), count * sizeof(T));
+    } else {
+      // The count of serialized elements is only an upper bound on their memory, so the vector grows as they are read.
+      // Stop at the first element which could not be read, instead of reading the others from a failed stream.
+      for (size_t index = 0; index < count && _stream; ++index) {
+        T value{};
+        read_value(_stream, value);
+        if (_stream) elements.push_back(std::move(value));
+      }
+    }
+    if (!_stream) throw std::runtime_error("Truncated snapshot in " + _path.string());
+  }
+
+  /// Reads the next section into a new vector.
+  ///
+  /// @returns The elements of the section.
+  template<typename T>
+  std::vector<T> read() {
+    std::vector<T> elements;
+    read(elements);
+    return elements;
+  }
+
+private:
+  /// The stream of the snapshot file.
+  std::ifstream _stream;
+
+  /// The path of the snapshot file, for error messages.
+  std::filesystem::path _path;
+
+  /// The number of sections not read yet.
+  uint64_t _sections = 0;
+
+  /// The size of the snapshot file in bytes.
+  uint64_t _size = 0;
+
+  /// Reads the header of the next section.
+  ///
+  /// @param element_size The expected size of an element, or 0 if serialized.
+  /// @returns The number of elements of the section.
+  size_t read_section(size_t element_size) {
+    uint64_t header[2] = {};
+    if (_sections-- == 0 || !_stream.read(reinterpret_cast<char*>(header), sizeof(header)) || header[0] != element_size)
+      throw std::runtime_error("Mismatching snapshot in " + _path.string());
+    // Check the number of elements against the rest of the file before allocating memory for them.
+    // Serialized elements are assumed to take up at least one byte each.
+    if (header[1] > (_size - uint64_t(_stream.tellg())) / std::max<size_t>(element_size, 1))
+      throw std::runtime_error("Truncated snapshot in " + _path.string());
+    return header[1];
+  }
+};
+
+/// Writes snapshots to files on a background thread.
+///
+/// The thread is started with the first snapshot to be written. Snapshots are written in order.
+/// Destroying the writer waits for all pending snapshots to be written.
+class SnapshotWriter {
+public:
+  SnapshotWriter() = default;
+  SnapshotWriter(const SnapshotWriter&) = delete;
+  SnapshotWriter& operator=(const SnapshotWriter&) = delete;
+
+  /// Waits for all pending snapshots to be written, and stops the thread.
+  ~SnapshotWriter() {
+    {
+      std::scoped_lock lock(_mutex);
+      _stopping = true;
+    }
+    _condition.notify_all();
+    if (_thread.joinable()) _thread.join();
+  }
+
+  /// Queues a snapshot to be written to a file.
+  ///
+  /// @param path The path of the file.
+  /// @param snapshot The snapshot to be written, which is moved in.
+  /// @throws The exception thrown while writing a previous snapshot, if any.
+  void write(std::filesystem::path path, Snapshot&& snapshot) {
+    {
+      std::scoped_lock lock(_mutex);
+      rethrow();
+      _pending.emplace_back(std::move(path), std::move(snapshot));
+    }
+    if (!_thread.joinable()) _thread = std::thread([this]() { run(); });
+    _condition.notify_all();
+  }
+
+  /// Returns a cleared snapshot written before, whose memory can be reused for capturing the next one.
+  ///
+  /// @returns The snapshot written last, or an empty snapshot if none has been written since the last call.
+  Snapshot recycle() {
+    std::scoped_lock lock(_mutex);
+    _written.clear();
+    return std::move(_written);
+  }
+
+  /// Waits for all pending snapshots to be written.
+  ///
+  /// @throws The exception thrown while writing a snapshot, if any.
+  void wait() {
+    std::unique_lock lock(_mutex);
+    _condition.wait(lock, [&]() { return _pending.empty() && !_writing; });
+    rethrow();
+  }
+
+private:
+  /// Guards all other members.
+  std::mutex _mutex;
+
+  /// Signals new snapshots to the thread, and written snapshots to waiting callers.
+  std::condition_variable _condition;
+
+  /// The snapshots not written yet, with the paths of their files.
+  std::deque<std::pair<std::filesystem::path, Snapshot>> _pending;
+
+  /// The snapshot written last, kept to be recycled.
+  Snapshot _written;
+
+  /// Whether the thread is writing a snapshot taken from the queue.
+  bool _writing = false;
+
+  /// Whether the thread is to stop once all pending snapshots are written.
+  bool _stopping = false;
+
+  /// The first exception thrown while writing a snapshot, until rethrown.
+  std::exception_ptr _error;
+
+  /// The background thread.
+  std::thread _thread;
+
+  /// Writes pending snapshots until stopped.
+  void run() {
+    std::unique_lock lock(_mutex);
+    while (true) {
+      _condition.wait(lock, [&]() { return !_pending.empty() || _stopping; });
+      if (_pending.empty()) return;
+      auto [path, snapshot] = std::move(_pending.front());
+      _pending.pop_front();
+      _writing = true;
+      lock.unlock();
+      try {
+        snapshot.write(path);
+      } catch (...) {
+        std::scoped_lock error_lock(_mutex);
+        if (!_error) _error = std::current_exception();
+      }
+      lock.lock();
+      _written = std::move(snapshot);
+      _writing = false;
+      _condition.notify_all();
+    }
+  }
+
+  /// Rethrows and clears the exception thrown while writing a snapshot, if any. Requires the mutex to be locked.
+  void rethrow() {
+    if (_error) std::rethrow_exception(std::exchange(_error, nullptr));
+  }
+};
+
+}
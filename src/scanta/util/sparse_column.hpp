@@ -0,0 +1,229 @@
+/// @file
+/// @brief Columns storing components of only some entities, for the sparse and boxed component layouts.
+
+#pragma once
+
+#include <cstdint>
+#include <memory>
+#include <utility>
+#include <vector>
+
+namespace scanta {
+
+/// A vector-like container storing components of only those entities they are attached to, as a sparse set.
+///
+/// Components are addressed by entity index like in a vector. For each index, a position into a dense vector
+/// of components is stored. The dense vector is kept packed, so that it can be iterated instead of all entities.
+/// @tparam TComponent The component type stored.
+/// @tparam TAllocator The allocator template allocating the dense vector of components.
+template<typename TComponent, template<typename> typename TAllocator = std::allocator>
+class SparseColumn {
+public:
+  /// Returns a reference to the component of an entity, which must be stored.
+  ///
+  /// @param index The index of the entity.
+  TComponent& operator[](size_t index) {
+    return _dense[_sparse[index]];
+  }
+
+  /// Returns the number of components stored.
+  size_t size() const {
+    return _dense.size();
+  }
+
+  /// Returns the indices of the entities whose components are stored, in the order of the dense vector.
+  const std::vector<uint32_t>& owners() const {
+    return _owners;
+  }
+
+  /// Appends an entity with a component.
+  ///
+  /// @param component The component of the new entity.
+  void push_back(auto&& component) {
+    _sparse.push_back(npos);
+    store(_sparse.size() - 1, std::forward<decltype(component)>(component));
+  }
+
+  /// Appends an entity without a component.
+  void emplace_back() {
+    _sparse.push_back(npos);
+  }
+
+  /// Stores the component of an entity, inserting it if not stored yet.
+  ///
+  /// @param index The index of the entity.
+  /// @param component The component to be stored.
+  void store(size_t index, auto&& component) {
+    if (_sparse[index] == npos) {
+      _sparse[index] = _dense.size();
+      _dense.push_back(std::forward<decltype(component)>(component));
+      _owners.push_back(index);
+    } else _dense[_sparse[index]] = std::forward<decltype(component)>(component);
+  }
+
+  /// Erases the component of an entity, if stored.
+  ///
+  /// The last component of the dense vector is moved into the gap to keep it packed.
+  /// @param index The index of the entity.
+  void erase(size_t index) {
+    const uint32_t position = _sparse[index];
+    if (position == npos) return;
+    if (position != _dense.size() - 1) {
+      _dense[position] = std::move(_dense.back());
+      _owners[position] = _owners.back();
+      _sparse[_owners[position]] = position;
+    }
+    _dense.pop_back();
+    _owners.pop_back();
+    _sparse[index] = npos;
+  }
+
+  /// Swaps the components of two entities, without moving any component data.
+  ///
+  /// @param first The index of the first entity.
+  /// @param second The index of the second entity.
+  void swap(size_t first, size_t second) {
+    std::swap(_sparse[first], _sparse[second]);
+    if (_sparse[first] != npos) _owners[_sparse[first]] = first;
+    if (_sparse[second] != npos) _owners[_sparse[second]] = second;
+  }
+
+  /// Moves the component of an entity to another entity, without moving any component data.
+  ///
+  /// The component of the target entity is erased, and the source entity is left without a component.
+  /// @param from The index of the source entity.
+  /// @param to The index of the target entity.
+  void relocate(size_t from, size_t to) {
+    erase(to);
+    _sparse[to] = std::exchange(_sparse[from], npos);
+    if (_sparse[to] != npos) _owners[_sparse[to]] = to;
+  }
+
+  /// Reorders the entities, without moving any component data.
+  ///
+  /// @param order The previous index of each entity, i.e., the entity at index `i` afterwards is the one at `order[i]` before.
+  void permute(const std::vector<size_t>& order) {
+    std::vector<uint32_t> sparse(order.size());
+    for (size_t index = 0; index < order.size(); ++index)
+      if ((sparse[index] = _sparse[order[index]]) != npos) _owners[sparse[index]] = index;
+    _sparse = std::move(sparse);
+  }
+
+  /// Changes the number of entities, erasing the components of dropped entities.
+  ///
+  /// @param size The new number of entities.
+  void resize(size_t size) {
+    for (size_t index = size; index < _sparse.size(); ++index) erase(index);
+    _sparse.resize(size, npos);
+  }
+
+  /// Reserve a given capacity of entities.
+  ///
+  /// @param capacity The new capacity to be reserved.
+  void reserve(size_t capacity) {
+    _sparse.reserve(capacity);
+  }
+
+private:
+  /// The position marking an entity without a stored component.
+  static constexpr uint32_t npos = UINT32_MAX;
+
+  /// The position of each entity's component in the dense vector, indexed by entity.
+  std::vector<uint32_t> _sparse;
+
+  /// The stored components, packed.
+  std::vector<TComponent, TAllocator<TComponent>> _dense;
+
+  /// The index of the entity owning each component in the dense vector.
+  std::vector<uint32_t> _owners;
+};
+
+/// A vector-like container storing each component in its own allocation.
+///
+/// Only a pointer is stored per entity, so that moving entities (e.g., when shuffling) never moves component data,
+/// and entities without the component only take up the size of a pointer.
+/// @tparam TComponent The component type stored.
+template<typename TComponent>
+class BoxedColumn {
+public:
+  /// Returns a reference to the component of an entity, which must be stored.
+  ///
+  /// @param index The index of the entity.
+  TComponent& operator[](size_t index) {
+    return *_boxes[index];
+  }
+
+  /// Appends an entity with a component.
+  ///
+  /// @param component The component of the new entity.
+  void push_back(auto&& component) {
+    _boxes.push_back(std::make_unique<TComponent>(std::forward<decltype(component)>(component)));
+  }
+
+  /// Appends an entity without a component.
+  void emplace_back() {
+    _boxes.emplace_back();
+  }
+
+  /// Stores the component of an entity, allocating it if not stored yet.
+  ///
+  /// @param index The index of the entity.
+  /// @param component The component to be stored.
+  void store(size_t index, auto&& component) {
+    if (_boxes[index]) *_boxes[index] = std::forward<decltype(component)>(component);
+    else _boxes[index] = std::make_unique<TComponent>(std::forward<decltype(component)>(component));
+  }
+
+  /// Releases the component of an entity, if stored.
+  ///
+  /// @param index The index of the entity.
+  void erase(size_t index) {
+    _boxes[index].reset();
+  }
+
+  /// Swaps the components of two entities, without moving any component data.
+  ///
+  /// @param first The index of the first entity.
+  /// @param second The index of the second entity.
+  void swap(size_t first, size_t second) {
+    std::swap(_boxes[first], _boxes[second]);
+  }
+
+  /// Moves the component of an entity to another entity, without moving any component data.
+  ///
+  /// The component of the target entity is released, and the source entity is left without a component.
+  /// @param from The index of the source entity.
+  /// @param to The index of the target entity.
+  void relocate(size_t from, size_t to) {
+    _boxes[to] = std::move(_boxes[from]);
+  }
+
+  /// Reorders the entities, without moving any component data.
+  ///
+  /// @param order The previous index of each entity, i.e., the entity at index `i` afterwards is the one at `order[i]` before.
+  void permute(const std::vector<size_t>& order) {
+    std::vector<std::unique_ptr<TComponent>> boxes(order.size());
+    for (size_t index = 0; index < order.size(); ++index) boxes[index] = std::move(_boxes[order[index]]);
+    _boxes = std::move(boxes);
+  }
+
+  /// Changes the number of entities, releasing the components of dropped entities.
+  ///
+  /// @param size The new number of entities.
+  void resize(size_t size) {
+    _boxes.resize(size);
+  }
+
+  /// Reserve a given capacity of entities.
+  ///
+  /// @param capacity The new capacity to be reserved.
+  void reserve(size_t capacity) {
+    _boxes.reserve(capacity);
+  }
+
+private:
+  /// The pointers to the components, or null for entities without one, indexed by entity.
+  std::vector<std::unique_ptr<TComponent>> _boxes;
+};
+
+}
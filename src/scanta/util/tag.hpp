@@ -0,0 +1,61 @@
+/// @file
+/// @brief Tag components, which carry no data and are stored as signature bits only.
+
+#pragma once
+
+#include <cstddef>
+#include <type_traits>
+#include <vector>
+
+namespace scanta {
+
+/// Whether a component type is a tag.
+///
+/// Tags are empty types (e.g., `struct Water {};`), whose only information is whether they are attached to an entity.
+/// Storages keep them as signature bits only, and never store or move any instances.
+/// @tparam TComponent The component type.
+template<typename TComponent>
+constexpr bool is_tag = std::is_empty_v<TComponent>;
+
+/// The single instance of a tag component type, shared by all entities it is attached to.
+///
+/// @tparam TComponent The tag component type.
+template<typename TComponent>
+inline TComponent tag_instance{};
+
+/// A stand-in for a vector of tag components, which stores nothing.
+///
+/// Every element is the shared `tag_instance`, and all operations changing the size are no-ops.
+/// @tparam TComponent The tag component type.
+template<typename TComponent>
+class TagColumn {
+  static_assert(is_tag<TComponent>, "Only tag component types can be stored in tag columns.");
+public:
+  /// Returns the shared tag instance.
+  TComponent& operator[](size_t) {
+    return tag_instance<TComponent>;
+  }
+
+  /// Does nothing, as tags are not stored.
+  void push_back(const TComponent&) {}
+
+  /// Does nothing, as tags are not stored.
+  void emplace_back() {}
+
+  /// Does nothing, as tags are not stored.
+  void resize(size_t) {}
+
+  /// Does nothing, as tags are not stored.
+  void reserve(size_t) {}
+
+  /// Does nothing, as tags are not stored.
+  void swap(size_t, size_t) {}
+
+  /// Does nothing, as tags are not stored.
+  void relocate(size_t, size_t) {}
+
+  /// Does nothing, as tags are not stored.
+  void permute(const std::vector<size_t>&) {}
+};
+
+}
@@ -0,0 +1,51 @@
+/// @file
+/// @brief Configuration of the storages keeping entities in vectors (`TupleOfVectors` and `VectorOfTuples`).
+
+#pragma once
+
+namespace scanta::storage::internal {
+
+  /// Structure for setting and accessing vector storage configuration.
+  ///
+  /// Allows the configuration to be passed in as a compile-time template
+  /// parameter instead of a preprocessor define.
+  /// This struct is only ever instantiated at compile-time.
+  constexpr struct VectorOptions {
+    /// Whether to reuse the slots of removed entities for new entities instead of compacting the vectors on refresh.
+    ///
+    /// Removed entities are then left in place with an empty signature, which no iteration matches, and their slots
+    /// are put on a free list. Component data is never moved, so references to components stay valid
+    /// as long as the vectors do not grow, which they do not in steady state.
+    const bool free_list = false;
+
+    /// Whether compacting the vectors on refresh preserves the order of the remaining entities.
+    ///
+    /// Instead of moving entities from the back into holes, all entities behind the first hole are slid down
+    /// in order, run by run. This costs more moves per refresh, but keeps locality built up by the order of entities
+    /// (e.g., spawn order) from decaying over time. Has no effect if slots are reused through a free list.
+    const bool stable_compaction = false;
+
+    /// Whether the entity metadata and the columns of trivially copyable component types are stored in memory-mapped regions.
+    ///
+    /// The regions can then be backed by files (see `map_files`), so that a storage persists across runs, is loaded
+    /// on demand as its pages are accessed, and can exceed the available memory. Columns of other component types,
+    /// as well as sparse, boxed, AoSoA and group columns, stay on the heap. Only supported by `TupleOfVectors`.
+    const bool mapped_columns = false;
+
+    /// Copies the options but with a free list configured.
+    consteval VectorOptions use_free_list() const {
+      return VectorOptions{true, this->stable_compaction, this->mapped_columns};
+    }
+
+    /// Copies the options but with order-preserving compaction configured.
+    consteval VectorOptions use_stable_compaction() const {
+      return VectorOptions{this->free_list, true, this->mapped_columns};
+    }
+
+    /// Copies the options but with memory-mapped columns configured.
+    consteval VectorOptions use_mapped_columns() const {
+      return VectorOptions{this->free_list, this->stable_compaction, true};
+    }
+  } vector_options;
+
+}